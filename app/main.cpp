@@ -1,10 +1,22 @@
 #include "mainwindow.h"
+#include "RangeCache.h"
 #include <QApplication>
+#include <QStandardPaths>
+#include <iostream>
 
 int main(int argc, char *argv[])
 {
     Q_INIT_RESOURCE(resorces);
     QApplication a(argc, argv);
+    a.setApplicationName("Qkinz");
+
+    // Keep the range tables across sessions, for the GUI and the batch files.
+    QString cache = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cache.isEmpty())
+        RangeCache::SetDirectory(cache.toStdString() + "/ranges");
+    if (RangeCache::GetDirectory().empty())
+        std::cerr << "Warning: no cache location, range tables are not kept on disk." << std::endl;
+
     MainWindow w;
     w.show();
 
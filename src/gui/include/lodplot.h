@@ -0,0 +1,86 @@
+#ifndef LODPLOT_H
+#define LODPLOT_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+#include "qcustomplot.h"
+
+//! Class: LODPlot
+/*! Keeps the full data of the curves and points in a plot, and gives the
+ *  graphs only the points needed to draw them in the visible range, see
+ *  \ref Decimate. The graphs are refined shortly after the range has
+ *  changed, so panning and zooming draw the reduced data and a burst of
+ *  wheel events gives a single refinement. Point sets too dense to show
+ *  as points are binned into a colour map instead.
+ */
+class LODPlot : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Number of points above which a point set is shown as a histogram.
+    static const int DENSE_POINTS = 20000;
+
+    //! Constructor.
+    LODPlot(QCustomPlot *plot,          /*!< The plot.      */
+            QObject *parent = nullptr   /*!< Parent object. */);
+
+    //! Show a curve in a graph.
+    void AddCurve(QCPGraph *graph,              /*!< Graph showing the curve.   */
+                  const QVector<double> &x,     /*!< x-values of the curve.     */
+                  const QVector<double> &y      /*!< y-values of the curve.     */);
+
+    //! Show points with error bars in a graph.
+    void AddPoints(QCPGraph *graph,             /*!< Graph showing the points.  */
+                   QCPErrorBars *xBars,         /*!< Error bars in x.           */
+                   QCPErrorBars *yBars,         /*!< Error bars in y.           */
+                   const QVector<double> &x,    /*!< x-values.                  */
+                   const QVector<double> &dx,   /*!< Errors of the x-values.    */
+                   const QVector<double> &y,    /*!< y-values.                  */
+                   const QVector<double> &dy    /*!< Errors of the y-values.    */);
+
+    //! Show a dense point set as a two dimensional histogram.
+    /*! \return the colour map.
+     */
+    QCPColorMap *AddHistogram(const QVector<double> &x,     /*!< x-values.                      */
+                              const QVector<double> &y,     /*!< y-values.                      */
+                              const int &bins = 256         /*!< Number of bins along each axis. */);
+
+    //! Set the axis ranges to show all the data.
+    void Rescale();
+
+    //! Forget all data, the plottables are removed from the plot separately.
+    void Clear();
+
+public slots:
+    //! Give the graphs the points needed for the visible range and replot.
+    void Refine();
+
+private:
+    //! Full data of a graph.
+    struct Series_t {
+        QPointer<QCPGraph> graph;               //! The graph, null when removed from the plot.
+        QPointer<QCPErrorBars> xBars, yBars;    //! Error bars, null for curves.
+        QVector<double> x, dx, y, dy;           //! Full data.
+    };
+
+    //! Give a graph the points needed for the visible range.
+    void Refine(Series_t &s, const double &xmin, const double &xmax, const int &columns);
+
+    //! The plot.
+    QCustomPlot *plot;
+
+    //! All graphs.
+    QVector<Series_t> series;
+
+    //! All histograms.
+    QVector<QPointer<QCPColorMap> > maps;
+
+    //! Delays the refinement after the range has changed.
+    QTimer timer;
+};
+
+#endif // LODPLOT_H
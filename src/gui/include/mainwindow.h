@@ -11,6 +11,8 @@
 #include "selecttelescopeform.h"
 #include "selectfrontbackform.h"
 #include "rundialog.h"
+#include "resultmodel.h"
+#include "lodplot.h"
 
 #include "types.h"
 #include "worker.h"
@@ -40,6 +42,9 @@ signals:
     void operate(const double &Angle, const double &incAngle, const bool &p, const bool &d, const bool &t, const bool &h3, const bool &a, const int &A, const int &Z);
     void runBatchFile(QString batchfile);
 
+    //! Emitted with a copy of the settings when they may have changed.
+    void setupChanged(const Setup_t &setup);
+
 public slots:
     //! Slot for reciving curve data from the worker. It will plot the data for the
     //! recived data.
@@ -47,7 +52,8 @@ public slots:
                    const QVector<double> &x,       /*!< x-values.                                                      */
                    const QVector<double> &y,       /*!< y-values.                                                      */
                    const QVector<double> &coeff,   /*!< Coefficients for the fit Ex(x+y) = a0 + a1(x+y) + a2(x+y)^2    */
-                   const Fragment_t &what          /*!< What fragment.                                                 */);
+                   const Fragment_t &what,         /*!< What fragment.                                                 */
+                   const int &component            /*!< Component of the target, 0 for the target isotope.             */);
 
     //! Slot for reciving scatter graph data from the worker.
     void ScatterData(const QVector<double> &x,     /*!< x-values.                                      */
@@ -55,7 +61,8 @@ public slots:
                      const QVector<double> &y,     /*!< y-values.                                      */
                      const QVector<double> &dy,    /*!< Error in y-values.                             */
                      const QVector<double> &ex,    /*!< The excitation energy at each x and y point.   */
-                     const Fragment_t &what        /*!< Indication what type of fragment.              */);
+                     const Fragment_t &what,       /*!< Indication what type of fragment.              */
+                     const int &component          /*!< Component of the target.                       */);
 
     //! Slot to indicate that the worker is finished with calculations.
     void WorkFinished();
@@ -75,6 +82,7 @@ private slots:
     inline void showTarget()
     {
         setTarget_form->setTarget(&theTarget);
+        setTarget_form->setContaminants(&theContaminants);
         setTarget_form->Refresh();
         setTarget_form->show();
     }
@@ -177,6 +185,9 @@ private:
     //! Structure containing information about the target.
     Target_t theTarget;
 
+    //! Contaminants of the target, calculated along with it.
+    QVector<Contaminant_t> theContaminants;
+
     //! Structure containing element in front of the target.
     Extra_t theFront;
 
@@ -195,6 +206,12 @@ private:
     //! Class making the tables.
     TableMakerHTML table;
 
+    //! Shows the table in the result view.
+    ResultModel *resultModel;
+
+    //! Keeps the full data of the plot and draws what is visible.
+    LODPlot *lodPlot;
+
     //! Function to remove all graphs from the plot.
     void RemoveAllGraphs();
 
@@ -0,0 +1,66 @@
+#ifndef RESULTMODEL_H
+#define RESULTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+
+#include "tablemakerhtml.h"
+
+//! Class: ResultModel
+/*! Shows the results kept by a \ref TableMakerHTML in a table view.
+ *  Nothing is copied, the rows are looked up in the result vectors and
+ *  formatted when the view asks for them, so only the visible rows are
+ *  ever made into text.
+ */
+class ResultModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    //! Constructor.
+    ResultModel(const TableMakerHTML *table,    /*!< The results to show.   */
+                QObject *parent = nullptr       /*!< Parent object.         */);
+
+    //! Find the rows again after the results have changed.
+    void Refresh();
+
+    //! \return the number of rows.
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    //! \return the number of columns.
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    //! \return the text of a cell.
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    //! \return the column titles.
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    //! What a block of rows shows.
+    enum Kind_t {
+        States,     //! Known states.
+        Curve,      //! Points on the curve.
+        Fit         //! Coefficients of the fit.
+    };
+
+    //! A block of consecutive rows.
+    struct Block_t {
+        TableMakerHTML::Particle_t particle;    //! Which particle.
+        int component;                          //! Which component of the target.
+        Kind_t kind;                            //! What the rows show.
+        int first;                              //! First row of the block.
+        int count;                              //! Number of rows.
+    };
+
+    //! The results.
+    const TableMakerHTML *table;
+
+    //! Blocks of rows, in order.
+    QVector<Block_t> blocks;
+
+    //! Total number of rows.
+    int rows;
+};
+
+#endif // RESULTMODEL_H
@@ -3,6 +3,7 @@
 
 #include <QDialog>
 #include <QThread>
+#include <QVector>
 
 
 
@@ -44,6 +45,9 @@ public slots:
     void startMovie();
     void progress(double curr);
 
+    //! Show the profile of the calculation, \see Worker::Profiled.
+    void profile(const QString &summary);
+
 private:
     Ui::RunDialog *ui;
 
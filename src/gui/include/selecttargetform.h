@@ -2,6 +2,7 @@
 #define SELECTTARGETFORM_H
 
 #include <QDialog>
+#include <QVector>
 
 #include "types.h"
 
@@ -19,6 +20,9 @@ public:
 
     inline void setTarget(Target_t *target){ theTarget = target; }
 
+    //! Set the contaminants of the target to edit.
+    inline void setContaminants(QVector<Contaminant_t> *contaminants){ theContaminants = contaminants; }
+
     void Refresh();
 
 signals:
@@ -27,10 +31,22 @@ signals:
 private slots:
     void on_buttonBox_accepted();
 
+    //! Add a row to the contaminant table.
+    void on_addContaminant_clicked();
+
+    //! Remove the selected row of the contaminant table.
+    void on_removeContaminant_clicked();
+
 private:
     Ui::SelectTargetForm *ui;
 
     Target_t *theTarget;
+
+    //! Contaminants of the target.
+    QVector<Contaminant_t> *theContaminants;
+
+    //! Put a contaminant in a row of the table.
+    void setRow(const int &row, const Contaminant_t &contaminant);
 };
 
 #endif // SELECTTARGETFORM_H
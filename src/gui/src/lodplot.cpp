@@ -0,0 +1,156 @@
+#include "lodplot.h"
+
+#include "Decimate.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+//! Delay before refining after the range has changed [ms].
+static const int REFINE_DELAY = 40;
+
+LODPlot::LODPlot(QCustomPlot *plot, QObject *parent)
+    : QObject( parent )
+    , plot( plot )
+{
+    timer.setSingleShot(true);
+    timer.setInterval(REFINE_DELAY);
+    connect(&timer, &QTimer::timeout, this, QOverload<>::of(&LODPlot::Refine));
+    connect(plot->xAxis, QOverload<const QCPRange &>::of(&QCPAxis::rangeChanged), &timer, QOverload<>::of(&QTimer::start));
+}
+
+void LODPlot::AddCurve(QCPGraph *graph, const QVector<double> &x, const QVector<double> &y)
+{
+    graph->setData(x, y, true);
+    series.push_back({graph, nullptr, nullptr, x, QVector<double>(), y, QVector<double>()});
+    timer.start();
+}
+
+void LODPlot::AddPoints(QCPGraph *graph, QCPErrorBars *xBars, QCPErrorBars *yBars,
+                        const QVector<double> &x, const QVector<double> &dx, const QVector<double> &y, const QVector<double> &dy)
+{
+    graph->setData(x, y);
+    xBars->setData(dx);
+    yBars->setData(dy);
+    series.push_back({graph, xBars, yBars, x, dx, y, dy});
+    timer.start();
+}
+
+QCPColorMap *LODPlot::AddHistogram(const QVector<double> &x, const QVector<double> &y, const int &bins)
+{
+    double xmin = std::numeric_limits<double>::max(), xmax = -xmin;
+    double ymin = xmin, ymax = -xmin;
+    for (int i = 0 ; i < x.size() ; ++i){
+        xmin = std::min(xmin, x[i]);
+        xmax = std::max(xmax, x[i]);
+        ymin = std::min(ymin, y[i]);
+        ymax = std::max(ymax, y[i]);
+    }
+
+    QCPColorMap *map = new QCPColorMap(plot->xAxis, plot->yAxis);
+    map->removeFromLegend();
+    map->data()->setSize(bins, bins);
+    map->data()->setRange(QCPRange(xmin, xmax), QCPRange(ymin, ymax));
+    std::vector<double> counts(size_t(bins)*bins, 0);
+    for (int i = 0 ; i < x.size() ; ++i){
+        int kx = (xmax > xmin) ? std::min(int((x[i] - xmin)/(xmax - xmin)*bins), bins - 1) : 0;
+        int ky = (ymax > ymin) ? std::min(int((y[i] - ymin)/(ymax - ymin)*bins), bins - 1) : 0;
+        counts[size_t(kx)*bins + ky] += 1;
+    }
+    for (int kx = 0 ; kx < bins ; ++kx){
+        for (int ky = 0 ; ky < bins ; ++ky)
+            map->data()->setCell(kx, ky, counts[size_t(kx)*bins + ky]);
+    }
+    map->setGradient(QCPColorGradient::gpThermal);
+    map->setInterpolate(false);
+    map->rescaleDataRange(true);
+    maps.push_back(map);
+    return map;
+}
+
+void LODPlot::Rescale()
+{
+    bool found = false;
+    double xmin = std::numeric_limits<double>::max(), xmax = -xmin;
+    double ymin = xmin, ymax = -xmin;
+    for (const Series_t &s : series){
+        if (!s.graph)
+            continue;
+        for (int i = 0 ; i < s.x.size() ; ++i){
+            double ex = (s.dx.isEmpty()) ? 0 : s.dx[i];
+            double ey = (s.dy.isEmpty()) ? 0 : s.dy[i];
+            if (!qIsFinite(s.x[i]) || !qIsFinite(s.y[i]))
+                continue;
+            xmin = std::min(xmin, s.x[i] - ex);
+            xmax = std::max(xmax, s.x[i] + ex);
+            ymin = std::min(ymin, s.y[i] - ey);
+            ymax = std::max(ymax, s.y[i] + ey);
+            found = true;
+        }
+    }
+    for (const QPointer<QCPColorMap> &map : maps){
+        if (!map)
+            continue;
+        xmin = std::min(xmin, map->data()->keyRange().lower);
+        xmax = std::max(xmax, map->data()->keyRange().upper);
+        ymin = std::min(ymin, map->data()->valueRange().lower);
+        ymax = std::max(ymax, map->data()->valueRange().upper);
+        found = true;
+    }
+    if (!found)
+        return;
+    plot->xAxis->setRange(xmin, xmax);
+    plot->yAxis->setRange(ymin, ymax);
+}
+
+void LODPlot::Clear()
+{
+    timer.stop();
+    series.clear();
+    maps.clear();
+}
+
+void LODPlot::Refine()
+{
+    double xmin = plot->xAxis->range().lower;
+    double xmax = plot->xAxis->range().upper;
+    int columns = std::max(plot->axisRect()->width(), 1);
+    for (Series_t &s : series){
+        if (s.graph)
+            Refine(s, xmin, xmax, columns);
+    }
+    plot->replot(QCustomPlot::rpQueuedReplot);
+}
+
+void LODPlot::Refine(Series_t &s, const double &xmin, const double &xmax, const int &columns)
+{
+    // Few enough points to draw them all.
+    if (s.x.size() <= 4*columns){
+        if (s.graph->dataCount() != s.x.size()){
+            s.graph->setData(s.x, s.y, !s.xBars);
+            if (s.xBars){
+                s.xBars->setData(s.dx);
+                s.yBars->setData(s.dy);
+            }
+        }
+        return;
+    }
+
+    std::vector<size_t> keep;
+    Decimate(s.x.constData(), s.y.constData(), size_t(s.x.size()), xmin, xmax, columns, keep);
+    QVector<double> x(int(keep.size())), y(int(keep.size()));
+    for (size_t i = 0 ; i < keep.size() ; ++i){
+        x[int(i)] = s.x[int(keep[i])];
+        y[int(i)] = s.y[int(keep[i])];
+    }
+    s.graph->setData(x, y, !s.xBars);
+    if (s.xBars){
+        QVector<double> dx(int(keep.size())), dy(int(keep.size()));
+        for (size_t i = 0 ; i < keep.size() ; ++i){
+            dx[int(i)] = s.dx[int(keep[i])];
+            dy[int(i)] = s.dy[int(keep[i])];
+        }
+        s.xBars->setData(dx);
+        s.yBars->setData(dy);
+    }
+}
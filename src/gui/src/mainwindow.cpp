@@ -10,9 +10,25 @@
 
 #include <QFile>
 #include <QFileDialog>
+#include <QHeaderView>
 
 const double PI = acos(-1);
 
+//! Pen of a curve, dashed for the contaminants of the target.
+static QPen ComponentPen(const QColor &color, const int &component)
+{
+    QPen pen(color);
+    if (component > 0)
+        pen.setStyle(Qt::DashLine);
+    return pen;
+}
+
+//! Name of an isotope, e.g. 12C.
+static QString IsotopeName(const int &A, const int &Z)
+{
+    return std::string(std::to_string(A) + get_element_name(Z)).c_str();
+}
+
 static QString Unit2String(const Unit_t &unit)
 {
     if (unit == mgcm2)
@@ -31,10 +47,16 @@ MainWindow::MainWindow(QWidget *parent)
     , setFrontBack_form(new SelectFrontBackForm(this))
     , setTelescope_form(new SelectTelescopeForm(this))
     , runDialog(new RunDialog(this))
+    , resultModel(new ResultModel(&table, this))
 {
     ui->setupUi(this);
+    lodPlot = new LODPlot(ui->plotTab, this);
+
+    ui->resultView->setModel(resultModel);
+    ui->resultView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->resultView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
 
-    worker = new Worker(&theBeam, &theTarget, &theFront, &theBack, &theTelescope);
+    worker = new Worker();
     //worker->setCustomTarget(new CustomPower("SKrC2D4_table2_ug.txt"), new CustomPower("SpC2D4_pstar_ug.txt"));
     worker->moveToThread(&workThread);
 
@@ -46,10 +68,12 @@ MainWindow::MainWindow(QWidget *parent)
     qRegisterMetaType<Fragment_t>("Fragment_t");
     connect(&workThread, &QThread::finished, worker, &QObject::deleteLater);
     connect(this, &MainWindow::operate, worker, &Worker::Run);
+    connect(this, &MainWindow::setupChanged, worker, &Worker::setSetup);
     connect(worker, &Worker::ResultCurve, this, &MainWindow::CurveData);
     connect(worker, &Worker::ResultScatter, this, &MainWindow::ScatterData);
     connect(worker, &Worker::FinishedAll, this, &MainWindow::WorkFinished);
     connect(worker, &Worker::curr_prog, runDialog, &RunDialog::progress);
+    connect(worker, &Worker::Profiled, runDialog, &RunDialog::profile);
     workThread.start();
 
     qRegisterMetaType<QString>("QString");
@@ -61,6 +85,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     ui->plotTab->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom | QCP::iSelectAxes |
                                  QCP::iSelectLegend | QCP::iSelectPlottables);
+    ui->plotTab->setNoAntialiasingOnDrag(true);
 
     ui->plotTab->xAxis->setLabel("E [MeV]");
     ui->plotTab->yAxis->setLabel("dE [MeV]");
@@ -214,6 +239,16 @@ MainWindow::~MainWindow()
 
 void MainWindow::Refresh()
 {
+    // The worker has its own copy, changed between its calculations.
+    Setup_t setup;
+    setup.beam = theBeam;
+    setup.target = theTarget;
+    setup.front = theFront;
+    setup.back = theBack;
+    setup.telescope = theTelescope;
+    setup.contaminants.assign(theContaminants.begin(), theContaminants.end());
+    emit setupChanged(setup);
+
     std::string bName;
     if (theBeam.Z == 1){
         if (theBeam.A == 1)
@@ -274,77 +309,84 @@ void MainWindow::Refresh()
 
 }
 
-void MainWindow::CurveData(const QVector<double> &ex, const QVector<double> &x, const QVector<double> &y, const QVector<double> &coeff, const Fragment_t &what)
+void MainWindow::CurveData(const QVector<double> &ex, const QVector<double> &x, const QVector<double> &y, const QVector<double> &coeff, const Fragment_t &what, const int &component)
 {
-    QString legend = QString("%1(%2,").arg(ui->CurrentTarget->text()).arg(ui->CurrentBeam->text());
+    int tA = theTarget.A, tZ = theTarget.Z;
+    QString tName = ui->CurrentTarget->text();
+    if (component > 0 && component <= theContaminants.size()){
+        tA = theContaminants[component - 1].A;
+        tZ = theContaminants[component - 1].Z;
+        tName = IsotopeName(tA, tZ);
+    }
+    QString legend = QString("%1(%2,").arg(tName).arg(ui->CurrentBeam->text());
     if (what == Proton){
-        int Zres = theBeam.Z + theTarget.Z - 1;
-        int Ares = theBeam.A + theTarget.A - 1;
+        int Zres = theBeam.Z + tZ - 1;
+        int Ares = theBeam.A + tA - 1;
         QString outP = std::string(std::to_string(Ares) + get_element_name(Zres)).c_str();
         if (theBeam.A == 1 && theBeam.Z == 1){
             legend = QString("%1%2)%3").arg(legend).arg("p'").arg(outP);
         } else {
             legend = QString("%1%2)%3").arg(legend).arg("p").arg(outP);
         }
-        makeCurve2(ui->plotTab->addGraph(), x, y, QPen(QColor(255,0,0)), legend);
+        makeCurve2(ui->plotTab->addGraph(), x, y, ComponentPen(QColor(255,0,0), component), legend);
         //ui->plotTab->addPlottable(makeCurve(x, y, QPen(QColor(255,0,0)), legend));
-        table.setCoeff(coeff, TableMakerHTML::Proton);
-        table.setCurve(ex, x, y, TableMakerHTML::Proton);
+        table.setCoeff(coeff, TableMakerHTML::Proton, component);
+        table.setCurve(ex, x, y, TableMakerHTML::Proton, component);
     } else if (what == Deutron){
-        int Zres = theBeam.Z + theTarget.Z - 1;
-        int Ares = theBeam.A + theTarget.A - 2;
+        int Zres = theBeam.Z + tZ - 1;
+        int Ares = theBeam.A + tA - 2;
         QString outP = std::string(std::to_string(Ares) + get_element_name(Zres)).c_str();
         if (theBeam.A == 2 && theBeam.Z == 1){
             legend = QString("%1%2)%3").arg(legend).arg("d'").arg(outP);
         } else {
             legend = QString("%1%2)%3").arg(legend).arg("d").arg(outP);
         }
-        makeCurve2(ui->plotTab->addGraph(), x, y, QPen(QColor(0,255,0)), legend);
+        makeCurve2(ui->plotTab->addGraph(), x, y, ComponentPen(QColor(0,255,0), component), legend);
         //ui->plotTab->addPlottable(makeCurve(x, y, QPen(QColor(0,255,0)), legend));
-        table.setCoeff(coeff, TableMakerHTML::Deutron);
-        table.setCurve(ex, x, y, TableMakerHTML::Deutron);
+        table.setCoeff(coeff, TableMakerHTML::Deutron, component);
+        table.setCurve(ex, x, y, TableMakerHTML::Deutron, component);
     } else if (what == Triton){
-        int Zres = theBeam.Z + theTarget.Z - 1;
-        int Ares = theBeam.A + theTarget.A - 3;
+        int Zres = theBeam.Z + tZ - 1;
+        int Ares = theBeam.A + tA - 3;
         QString outP = std::string(std::to_string(Ares) + get_element_name(Zres)).c_str();
         if (theBeam.A == 3 && theBeam.Z == 1){
             legend = QString("%1%2)%3").arg(legend).arg("t'").arg(outP);
         } else {
             legend = QString("%1%2)%3").arg(legend).arg("t").arg(outP);
         }
-        makeCurve2(ui->plotTab->addGraph(), x, y, QPen(QColor(128,128,128)), legend);
+        makeCurve2(ui->plotTab->addGraph(), x, y, ComponentPen(QColor(128,128,128), component), legend);
         //ui->plotTab->addPlottable(makeCurve(x, y, QPen(QColor(128,128,128)), legend));
-        table.setCoeff(coeff, TableMakerHTML::Triton);
-        table.setCurve(ex, x, y, TableMakerHTML::Triton);
+        table.setCoeff(coeff, TableMakerHTML::Triton, component);
+        table.setCurve(ex, x, y, TableMakerHTML::Triton, component);
     } else if (what == Helium3){
-        int Zres = theBeam.Z + theTarget.Z - 2;
-        int Ares = theBeam.A + theTarget.A - 3;
+        int Zres = theBeam.Z + tZ - 2;
+        int Ares = theBeam.A + tA - 3;
         QString outP = std::string(std::to_string(Ares) + get_element_name(Zres)).c_str();
         if (theBeam.A == 3 && theBeam.Z == 2){
             legend = QString("%1%2)%3").arg(legend).arg("He-3'").arg(outP);
         } else {
             legend = QString("%1%2)%3").arg(legend).arg("He-3").arg(outP);
         }
-        makeCurve2(ui->plotTab->addGraph(), x, y, QPen(QColor(0,0,255)), legend);
+        makeCurve2(ui->plotTab->addGraph(), x, y, ComponentPen(QColor(0,0,255), component), legend);
         //ui->plotTab->addPlottable(makeCurve(x, y, QPen(QColor(0,0,255)), legend));
-        table.setCoeff(coeff, TableMakerHTML::Helium3);
-        table.setCurve(ex, x, y, TableMakerHTML::Helium3);
+        table.setCoeff(coeff, TableMakerHTML::Helium3, component);
+        table.setCurve(ex, x, y, TableMakerHTML::Helium3, component);
     } else if (what == Alpha){
-        int Zres = theBeam.Z + theTarget.Z - 2;
-        int Ares = theBeam.A + theTarget.A - 4;
+        int Zres = theBeam.Z + tZ - 2;
+        int Ares = theBeam.A + tA - 4;
         QString outP = std::string(std::to_string(Ares) + get_element_name(Zres)).c_str();
         if (theBeam.A == 4 && theBeam.Z == 2){
             legend = QString("%1%2)%3").arg(legend).arg("α'").arg(outP);
         } else {
             legend = QString("%1%2)%3").arg(legend).arg("α").arg(outP);
         }
-        makeCurve2(ui->plotTab->addGraph(), x, y, QPen(QColor(0,0,0)), legend);
+        makeCurve2(ui->plotTab->addGraph(), x, y, ComponentPen(QColor(0,0,0), component), legend);
         //ui->plotTab->addPlottable(makeCurve(x, y, QPen(QColor(0,0,0)), legend));
-        table.setCoeff(coeff, TableMakerHTML::Alpha);
-        table.setCurve(ex, x, y, TableMakerHTML::Alpha);
+        table.setCoeff(coeff, TableMakerHTML::Alpha, component);
+        table.setCurve(ex, x, y, TableMakerHTML::Alpha, component);
     } else if (what == Other){
-        int Zres = theBeam.Z + theTarget.Z - ui->otherZ->value();
-        int Ares = theBeam.A + theTarget.A - ui->otherA->value();
+        int Zres = theBeam.Z + tZ - ui->otherZ->value();
+        int Ares = theBeam.A + tA - ui->otherA->value();
         QString outP = std::string(std::to_string(Ares) + get_element_name(Zres)).c_str();
         QString inP = std::string(std::to_string(ui->otherA->value()) + get_element_name(ui->otherZ->value())).c_str();
         if ( theBeam.A == ui->otherA->value() && theBeam.Z == ui->otherZ->value() ){
@@ -352,19 +394,19 @@ void MainWindow::CurveData(const QVector<double> &ex, const QVector<double> &x,
         } else {
             legend = QString("%1%2)%3").arg(legend).arg(inP).arg(outP);
         }
-        makeCurve2(ui->plotTab->addGraph(), x, y, QPen(QColor(128, 128, 0)), legend);
+        makeCurve2(ui->plotTab->addGraph(), x, y, ComponentPen(QColor(128, 128, 0), component), legend);
         //ui->plotTab->addPlottable(makeCurve(x, y, QPen(QColor(128, 128, 0)), legend));
-        table.setCoeff(coeff, TableMakerHTML::Other);
-        table.setCurve(ex, x, y, TableMakerHTML::Other);
+        table.setCoeff(coeff, TableMakerHTML::Other, component);
+        table.setCurve(ex, x, y, TableMakerHTML::Other, component);
     }
 
+    lodPlot->Rescale();
     ui->plotTab->replot();
-    ui->plotTab->rescaleAxes();
     ui->plotTab->show();
 }
 
 void MainWindow::ScatterData(const QVector<double> &x, const QVector<double> &dx, const QVector<double> &y,
-                             const QVector<double> &dy, const QVector<double> &ex, const Fragment_t &what)
+                             const QVector<double> &dy, const QVector<double> &ex, const Fragment_t &what, const int &component)
 {
     QPen pen;
     TableMakerHTML::Particle_t particle;
@@ -395,10 +437,15 @@ void MainWindow::ScatterData(const QVector<double> &x, const QVector<double> &dx
             particle = TableMakerHTML::Other;
             break;
     }
-    makeGraph2(ui->plotTab->addGraph(), x, dx, y, dy, pen);
-    table.setData(ex, y, dy, x, dx, particle);
+    if (component > 0)
+        pen.setStyle(Qt::DashLine);
+    if (x.size() > LODPlot::DENSE_POINTS)
+        lodPlot->AddHistogram(x, y);
+    else
+        makeGraph2(ui->plotTab->addGraph(), x, dx, y, dy, pen);
+    table.setData(ex, y, dy, x, dx, particle, component);
+    lodPlot->Rescale();
     ui->plotTab->replot();
-    ui->plotTab->rescaleAxes();
     ui->plotTab->show();
 }
 
@@ -408,7 +455,11 @@ void MainWindow::run()
     runDialog->show();
 
     RemoveAllGraphs();
-    table.Reset();
+    QStringList contaminants;
+    for (const Contaminant_t &c : theContaminants)
+        contaminants << QString("%1 (%2)").arg(IsotopeName(c.A, c.Z)).arg(c.weight);
+    table.Reset(contaminants);
+    resultModel->Refresh();
     double angle;
     double incAngle;
 
@@ -433,7 +484,7 @@ void MainWindow::run()
 
 void MainWindow::WorkFinished()
 {
-    ui->webView->setHtml(table.getHTMLCode());
+    resultModel->Refresh();
     emit runDialog->Finished();
 }
 
@@ -475,6 +526,7 @@ void MainWindow::mouseWheel()
 void MainWindow::RemoveAllGraphs()
 {
     ui->plotTab->clearPlottables();
+    lodPlot->Clear();
     ui->plotTab->replot();
 }
 
@@ -495,8 +547,8 @@ void MainWindow::makeCurve2(QCPGraph* graph, QVector<double> x, QVector<double>
 
     graph->setName(label);
     graph->setPen(pen);
-    graph->setData(x, y, true);
     graph->setLineStyle(QCPGraph::lsLine);
+    lodPlot->AddCurve(graph, x, y);
 }
 
 
@@ -523,8 +575,6 @@ void MainWindow::makeGraph2(QCPGraph* graph, QVector<double> x, QVector<double>
 
     error_bars_x->setErrorType(QCPErrorBars::etKeyError);
     error_bars_y->setErrorType(QCPErrorBars::etValueError);
-    error_bars_x->setData(dx);
-    error_bars_y->setData(dy);
     error_bars_x->setPen(pen);
     error_bars_y->setPen(pen);
     error_bars_x->setAntialiased(false);
@@ -533,8 +583,8 @@ void MainWindow::makeGraph2(QCPGraph* graph, QVector<double> x, QVector<double>
     error_bars_y->setDataPlottable(graph);
 
     graph->removeFromLegend();
-    graph->setData(x, y);
     graph->setPen(pen);
+    lodPlot->AddPoints(graph, error_bars_x, error_bars_y, x, dx, y, dy);
     graph->setLineStyle(QCPGraph::lsNone);
     graph->setScatterStyle(QCPScatterStyle::ssDisc);
 }
@@ -565,19 +615,17 @@ void MainWindow::on_actionExport_table_triggered()
 
     QString FilePath = SaveTabDialog->getSaveFileName(this, "Save table", QDir::homePath(), Filters, &DefaultFilter);
     if (FilePath.endsWith("html", Qt::CaseInsensitive)){
-        QString htmlCode = table.getHTMLCode();
         QFile file(FilePath);
         if (file.open(QIODevice::WriteOnly|QIODevice::Text)){
             QTextStream out(&file);
-            out << htmlCode;
+            table.WriteHTML(out);
         }
         file.close();
     } else if (FilePath.endsWith("txt", Qt::CaseInsensitive)){
-        QString txt = table.getTXT();
         QFile file(FilePath);
         if (file.open(QIODevice::WriteOnly|QIODevice::Text)){
             QTextStream out(&file);
-            out << txt;
+            table.WriteTXT(out);
         }
         file.close();
     }
@@ -598,6 +646,9 @@ void MainWindow::on_actionSave_triggered()
         fwrite(&theBeam, sizeof(Beam_t), 1, outFile);
         fwrite(&theTarget, sizeof(Target_t), 1, outFile);
         fwrite(&theTelescope, sizeof(Telescope_t), 1, outFile);
+        int nContaminants = theContaminants.size();
+        fwrite(&nContaminants, sizeof(int), 1, outFile);
+        fwrite(theContaminants.constData(), sizeof(Contaminant_t), nContaminants, outFile);
         std::fclose(outFile);
     }
 
@@ -615,6 +666,21 @@ void MainWindow::on_actionOpen_triggered()
         fread(&theBeam, sizeof(Beam_t), 1, inFile);
         fread(&theTarget, sizeof(Target_t), 1, inFile);
         fread(&theTelescope, sizeof(Telescope_t), 1, inFile);
+        // Setups saved before the contaminants were added end here. A
+        // corrupt count is limited to what the rest of the file holds.
+        int nContaminants = 0;
+        if (fread(&nContaminants, sizeof(int), 1, inFile) != 1 || nContaminants < 0)
+            nContaminants = 0;
+        long start = std::ftell(inFile);
+        std::fseek(inFile, 0, SEEK_END);
+        long left = std::ftell(inFile) - start;
+        std::fseek(inFile, start, SEEK_SET);
+        if (start < 0 || left < 0)
+            nContaminants = 0;
+        else if (nContaminants > left/long(sizeof(Contaminant_t)))
+            nContaminants = int(left/long(sizeof(Contaminant_t)));
+        theContaminants.resize(nContaminants);
+        theContaminants.resize(int(fread(theContaminants.data(), sizeof(Contaminant_t), nContaminants, inFile)));
         std::fclose(inFile);
     }
 
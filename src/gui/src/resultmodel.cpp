@@ -0,0 +1,147 @@
+#include "resultmodel.h"
+
+#include <cmath>
+
+//! Columns of the view.
+enum Column_t {
+    ColParticle,
+    ColType,
+    ColEx,
+    ColdE,
+    ColE,
+    ColTotal,
+    NumColumns
+};
+
+static const char *columnNames[NumColumns] = {
+    "Particle", "Type", "Excitation energy (keV)", "Energy dE-detector (keV)",
+    "Energy E-detector (keV)", "Total particle energy (keV)"
+};
+
+static inline QString num(const double &x)
+{
+    return QString::number(x, 'f', 1);
+}
+
+static inline QString num(const double &x, const double &dx)
+{
+    return QString("%1 ± %2").arg(x, 0, 'f', 1).arg(dx, 0, 'f', 1);
+}
+
+ResultModel::ResultModel(const TableMakerHTML *table, QObject *parent)
+    : QAbstractTableModel( parent )
+    , table( table )
+    , rows( 0 )
+{
+}
+
+void ResultModel::Refresh()
+{
+    beginResetModel();
+    blocks.clear();
+    rows = 0;
+    for (int c = 0 ; c < table->getNComponents() ; ++c){
+        for (int i = 0 ; i < TableMakerHTML::NPARTICLES ; ++i){
+            TableMakerHTML::Particle_t particle = TableMakerHTML::Particle_t(i);
+            const TableMakerHTML::Result_t &result = table->getResult(particle, c);
+            if (!result.is_set)
+                continue;
+            Block_t block[3] = {{particle, c, States, 0, int(result.Ex.size())},
+                                {particle, c, Curve, 0, int(table->getCurve(particle, c).ex.size())},
+                                {particle, c, Fit, 0, (table->getCoeff(particle, c).size() > 3) ? 1 : 0}};
+            for (Block_t &b : block){
+                if (b.count == 0)
+                    continue;
+                b.first = rows;
+                rows += b.count;
+                blocks.push_back(b);
+            }
+        }
+    }
+    endResetModel();
+}
+
+int ResultModel::rowCount(const QModelIndex &parent) const
+{
+    return (parent.isValid()) ? 0 : rows;
+}
+
+int ResultModel::columnCount(const QModelIndex &parent) const
+{
+    return (parent.isValid()) ? 0 : NumColumns;
+}
+
+QVariant ResultModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows || index.column() >= NumColumns)
+        return QVariant();
+    if (role == Qt::TextAlignmentRole)
+        return (index.column() < ColEx) ? int(Qt::AlignLeft|Qt::AlignVCenter) : int(Qt::AlignRight|Qt::AlignVCenter);
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    // The blocks are sorted by their first row.
+    int n = 0;
+    while (n + 1 < blocks.size() && blocks[n + 1].first <= index.row())
+        ++n;
+    const Block_t &block = blocks[n];
+    int i = index.row() - block.first;
+
+    if (index.column() == ColParticle){
+        if (block.component == 0)
+            return QString(TableMakerHTML::Name(block.particle));
+        return QString("%1 from %2").arg(TableMakerHTML::Name(block.particle)).arg(table->getComponentName(block.component));
+    }
+
+    if (block.kind == States){
+        const TableMakerHTML::Result_t &r = table->getResult(block.particle, block.component);
+        switch (index.column()){
+        case ColType :
+            return QString("State");
+        case ColEx :
+            return num(r.Ex[i]*1000);
+        case ColdE :
+            return num(r.dE[i]*1000, r.d_dE[i]*1000);
+        case ColE :
+            return num(r.E[i]*1000, r.d_E[i]*1000);
+        case ColTotal :
+            return num((r.dE[i] + r.E[i])*1000, sqrt(r.d_dE[i]*r.d_dE[i] + r.d_E[i]*r.d_E[i])*1000);
+        }
+    } else if (block.kind == Curve){
+        const TableMakerHTML::Res_t &c = table->getCurve(block.particle, block.component);
+        switch (index.column()){
+        case ColType :
+            return QString("Curve");
+        case ColEx :
+            return num(c.ex[i]*1000);
+        case ColdE :
+            return num(c.y[i]*1000);
+        case ColE :
+            return num(c.x[i]*1000);
+        case ColTotal :
+            return num((c.y[i] + c.x[i])*1000);
+        }
+    } else {
+        const QVector<double> &coeff = table->getCoeff(block.particle, block.component);
+        switch (index.column()){
+        case ColType :
+            return QString("Fit, chi^2 = %1").arg(coeff[3], 0, 'g', 4);
+        case ColEx :
+            return QString("a0 = %1 MeV").arg(coeff[0], 0, 'g', 6);
+        case ColdE :
+            return QString("a1 = %1").arg(coeff[1], 0, 'g', 6);
+        case ColE :
+            return QString("a2 = %1 MeV^-1").arg(coeff[2], 0, 'g', 6);
+        }
+    }
+    return QVariant();
+}
+
+QVariant ResultModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+        return QVariant();
+    if (orientation == Qt::Horizontal)
+        return (section >= 0 && section < NumColumns) ? QString(columnNames[section]) : QVariant();
+    return section + 1;
+}
@@ -2,6 +2,7 @@
 #include "ui_rundialog.h"
 
 #include "QMovie"
+#include <QFontDatabase>
 
 #include "Particle.h"
 #include "Material.h"
@@ -25,6 +26,8 @@ RunDialog::RunDialog(QWidget *parent) :
     ui->label->setScaledContents(true);
     connect(movie, SIGNAL(finished()), this, SLOT(startMovie()));
     movie->start();
+
+    ui->profileLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
 }
 
 RunDialog::~RunDialog()
@@ -41,6 +44,7 @@ void RunDialog::startMovie()
 void RunDialog::restart_counter()
 {
     ui->progressBar->setValue(0);
+    ui->profileLabel->clear();
 }
 
 void RunDialog::progress(double curr)
@@ -48,6 +52,11 @@ void RunDialog::progress(double curr)
     ui->progressBar->setValue(curr);
 }
 
+void RunDialog::profile(const QString &summary)
+{
+    ui->profileLabel->setText(summary);
+}
+
 void RunDialog::RunData(QVector<double> &Ex, QVector<double> &dE, QVector<double> &E,
                         QVector<double> &delta_dE, QVector<double> &delta_E, const double &Angle,
                         const int &fA, const int &fZ)
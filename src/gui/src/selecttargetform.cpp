@@ -5,7 +5,9 @@
 
 SelectTargetForm::SelectTargetForm(QWidget *parent) :
     QDialog(parent),
-    ui(new Ui::SelectTargetForm)
+    ui(new Ui::SelectTargetForm),
+    theTarget(nullptr),
+    theContaminants(nullptr)
 {
     ui->setupUi(this);
     QDialog::setWindowFlags(Qt::Sheet);
@@ -28,9 +30,47 @@ void SelectTargetForm::on_buttonBox_accepted()
         theTarget->unit = gcm2;
     else if (ui->umButton->isChecked())
         theTarget->unit = um;
+
+    if (theContaminants){
+        theContaminants->clear();
+        for (int i = 0 ; i < ui->Contaminants->rowCount() ; ++i){
+            QTableWidgetItem *A = ui->Contaminants->item(i, 0);
+            QTableWidgetItem *Z = ui->Contaminants->item(i, 1);
+            QTableWidgetItem *W = ui->Contaminants->item(i, 2);
+            if (!A || !Z || !W)
+                continue;
+            Contaminant_t contaminant = {A->text().toInt(), Z->text().toInt(), W->text().toDouble()};
+            if (contaminant.A < 1 || contaminant.Z < 1 || contaminant.Z > contaminant.A || !(contaminant.weight > 0)){
+                QMessageBox::warning(this, "Contaminant ignored", QString("Row %1 is not a valid isotope and weight.").arg(i + 1));
+                continue;
+            }
+            theContaminants->push_back(contaminant);
+        }
+    }
     emit DoRefresh();
 }
 
+void SelectTargetForm::setRow(const int &row, const Contaminant_t &contaminant)
+{
+    ui->Contaminants->setItem(row, 0, new QTableWidgetItem(QString::number(contaminant.A)));
+    ui->Contaminants->setItem(row, 1, new QTableWidgetItem(QString::number(contaminant.Z)));
+    ui->Contaminants->setItem(row, 2, new QTableWidgetItem(QString::number(contaminant.weight)));
+}
+
+void SelectTargetForm::on_addContaminant_clicked()
+{
+    int row = ui->Contaminants->rowCount();
+    ui->Contaminants->insertRow(row);
+    setRow(row, {12, 6, 0.01});
+}
+
+void SelectTargetForm::on_removeContaminant_clicked()
+{
+    int row = ui->Contaminants->currentRow();
+    if (row >= 0)
+        ui->Contaminants->removeRow(row);
+}
+
 void SelectTargetForm::Refresh()
 {
     ui->MassNumb->setValue(theTarget->A);
@@ -49,4 +89,11 @@ void SelectTargetForm::Refresh()
         ui->gcm2Button->setChecked(false);
         ui->umButton->setChecked(true);
     }
+
+    ui->Contaminants->setRowCount(0);
+    if (theContaminants){
+        ui->Contaminants->setRowCount(theContaminants->size());
+        for (int i = 0 ; i < theContaminants->size() ; ++i)
+            setRow(i, (*theContaminants)[i]);
+    }
 }
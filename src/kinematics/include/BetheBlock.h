@@ -16,13 +16,8 @@ public:
     //! Empty constructor.
     BetheBlock();
 
-	//! Constructor.
-	BetheBlock(Material *material, Particle *particle);
-
-	~BetheBlock();
-
-    //! Assign operator.
-    BetheBlock &operator=(const BetheBlock &bb);
+	//! Constructor. The material and particle are copied.
+	BetheBlock(const Material *material, const Particle *particle);
 
 	//! Calculate stopping power.
 	/*! \return the stopping power for a
@@ -30,6 +25,9 @@ public:
 	 */
 	double Evaluate(const double &E	/*!< Energy of incident particle.	*/) const;
 
+	//! Calculate stopping power and its derivatives.
+	Dual Evaluate(const Dual &E	/*!< Energy of incident particle.	*/) const;
+
 	double Loss(const double &E,		/*!< Initial energy of the incident particle in [MeV].	*/
                 const int &points=1001	/*!< Number of integration points.						*/) const;
 
@@ -37,9 +35,22 @@ public:
                 const double &width,
                 const int &points=1001) const;
 
+    //! Energy loss with derivatives with respect to energy and width.
+    Dual Loss(const Dual &E,
+              const Dual &width,
+              const int &points=1001) const;
+
     adouble Loss(adouble E, int points=1001);
     adouble Loss(adouble E, double width, int points=1001);
 
+    //! Widths are in [g/cm²].
+    inline Material::Unit GetUnit() const { return Material::gcm2; }
+
+    //! The formula does not hold below 0.1 MeV.
+    inline double GetEmin() const { return 0.1; }
+
+    using StoppingPower::Loss;
+
 	//! Set density correction parameters (optional).
 	void setDensityCorr(const DensityCorr &densC)
 	{
@@ -51,7 +62,16 @@ private:
 	DensityCorr densCorr;
 	bool densCorrSet;
 
-	double calcDensityCorrection(const double &X) const;
+	template<typename T>
+	T calcDensityCorrection(const T &X) const;
+
+	//! Stopping power, for double or Dual.
+	template<typename T>
+	T EvaluateT(const T &E) const;
+
+	//! Runge-Kutta integration of the energy loss, for double or Dual.
+	template<typename T>
+	T LossT(const T &E, const T &width, const int &points) const;
 };
 
 
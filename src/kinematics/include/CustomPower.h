@@ -1,9 +1,10 @@
 #ifndef CUSTOM_POWER_H
 #define CUSTOM_POWER_H
 
+#include <memory>
 #include <string>
 #include <vector>
-#include "spline.h"
+#include "StoppingTable.h"
 #include "types.h"
 
 
@@ -14,15 +15,22 @@ public:
 
     ~CustomPower();
 
+    //! \return true if the table was loaded.
+    inline bool IsValid() const { return table != nullptr; }
+
     double Evaluate(const double &E) const;
 
+    //! Same as Evaluate(E), but starts the table look-up from cursor and
+    //! stores the interval found. Use when E changes slowly between calls.
+    double Evaluate(const double &E, size_t &cursor) const;
+
 	double Loss(const double &E,
 				const double &width,
 				const int &points=1001) const;
 
     adouble Loss(adouble E, double width, int points=1001);
 private:
-    spline SP;
+    std::shared_ptr<const StoppingTable> table;
     double xmin;
     double xmax;
 
@@ -3,6 +3,8 @@
 
 #include "Scattering.h"
 
+#include <cmath>
+
 /*! Scattering calculator for inelastic relativistic scattering.
  *  This class is based on F. Dick and J. W. Norbury, Eur. J. Phys. 30 (2009) 403-416.
  *  The implementation depends on equations 48, 50-53.
@@ -10,6 +12,38 @@
 class DickNorbury : public Scattering
 {
 public:
+    //! Kinematics at a fixed incident energy and scattering angle.
+    /*! Everything that does not depend on the excitation energy is
+     *  calculated once by \ref DickNorbury::Prepare.
+     */
+    class Prepared
+    {
+    public:
+        //! \return the energy of particle Y when B has excitation energy Ex.
+        inline double operator()(const double &Ex /*!< Excitation energy of particle B. */) const
+        {
+            double m4 = m4gs + Ex;
+            double a = 0.5*(s + m3*m3 - m4*m4);
+            double y = x*sqrt(a*a - m3*m3*D);
+            double k3la = (a*b + y)/D - m3;
+            double k3lb = (a*b - y)/D - m3;
+            double k3l = (k3la > k3lb) ? k3la : k3lb;
+            return (Ex > Exmax || (k3la < 0 && k3lb < 0)) ? 0 : k3l;
+        }
+
+        //! Energy of particle Y for n excitation energies.
+        void operator()(const double *Ex,   /*!< Excitation energies of particle B. */
+                        double *EY,         /*!< Energies of particle Y.            */
+                        const int &n        /*!< Number of excitation energies.     */) const;
+
+    private:
+        friend class DickNorbury;
+
+        double m3, m4gs;    //! Masses of Y and B (ground state) in [MeV].
+        double Exmax;       //! Excitation energy above the total energy available.
+        double s, b, x, D;  //! Invariant mass squared, total energy, momentum along theta and b^2 - x^2.
+    };
+
     //! Constructor.
     DickNorbury(Particle *pA, /*!< The incident particle.                            */
                 Particle *pX, /*!< The particle that are scattered of.               */
@@ -26,6 +60,19 @@ public:
                      const double &theta,   /*!< Scattering angle (Particle Y).             */
                      const double &Ex       /*!< Excitation energy of particle B.           */) const;
 
+    //! Calculate energy of particle Y for many excitation energies.
+    void EvaluateY(const double &E,     /*!< Energy of incident particle (particle A).  */
+                   const double &theta, /*!< Scattering angle (Particle Y).             */
+                   const double *Ex,    /*!< Excitation energies of particle B.         */
+                   double *EY,          /*!< Energies of particle Y.                    */
+                   const int &n         /*!< Number of excitation energies.             */) const;
+
+    //! Prepare the kinematics for a given incident energy and angle.
+    /*! \return the kinematics, valid as long as the particles are unchanged.
+     */
+    Prepared Prepare(const double &E,       /*!< Energy of incident particle (particle A).  */
+                     const double &theta    /*!< Scattering angle (Particle Y).             */) const;
+
     //! Calculate maximum excitation energy of the B particle after scattering.
     /*! \return Maximum posible excitation energy after scattering.
      */
@@ -0,0 +1,28 @@
+#ifndef EXITCHANNELS_H
+#define EXITCHANNELS_H
+
+#include <vector>
+
+//! A two-body exit channel, beam + target -> fragment + residual.
+struct Channel_t {
+    int A;      //! Mass number of the fragment.
+    int Z;      //! Element number of the fragment.
+    int resA;   //! Mass number of the residual.
+    int resZ;   //! Element number of the residual.
+    double Q;   //! Q-value of the reaction [MeV].
+};
+
+//! Find the two-body exit channels open at a beam energy.
+/*! Every charged fragment in the mass table that leaves a residual also
+ *  in the table is tried, in one pass over the table. A channel is open if
+ *  the energy in the centre of mass frame is above -Q. The channels are
+ *  in the order of the mass table, i.e. by A and then Z of the fragment.
+ *  \return the open channels.
+ */
+std::vector<Channel_t> ExitChannels(const int &beamA,       /*!< Mass number of the beam.           */
+                                    const int &beamZ,       /*!< Element number of the beam.        */
+                                    const int &targetA,     /*!< Mass number of the target.         */
+                                    const int &targetZ,     /*!< Element number of the target.      */
+                                    const double &Ebeam     /*!< Kinetic energy of the beam [MeV].  */);
+
+#endif // EXITCHANNELS_H
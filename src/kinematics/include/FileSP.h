@@ -3,8 +3,9 @@
 
 #include "StoppingPower.h"
 
-#include "spline.h"
+#include "StoppingTable.h"
 
+#include <memory>
 #include <string>
 
 class Material;
@@ -13,13 +14,16 @@ class Particle;
 class FileSP : public StoppingPower
 {
 public:
-    FileSP(Material *material, Particle *particle) : StoppingPower(material, particle), fileSet( false ){ }
+    FileSP(const Material *material, const Particle *particle) : StoppingPower(material, particle), fileSet( false ){ }
 
     ~FileSP(){ }
 
     double Evaluate(const double &E) const; //{ if (fileSet) return -stop(E);
                                             //        else return 0;}
 
+    //! Table look-up starting from the interval stored in cursor.
+    double Evaluate(const double &E, size_t &cursor) const;
+
     double Loss(const double &E, const int &points) const;
 
     double Loss(const double &E, const double &width, const int &points) const;
@@ -27,15 +31,12 @@ public:
     void setFile(const std::string &file);
 
 private:
-    spline stop;
+    std::shared_ptr<const StoppingTable> table;
     
     //double refA;
     //int refZ;
 
     bool fileSet;
-
-    bool next_line(std::istream &file, std::string &line);
-
 };
 
 #endif // FILESP_H
@@ -0,0 +1,76 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <cmath>
+#include <numbers>
+
+#include "Material.h"
+#include "types.h"
+
+//! Class: Geometry
+/*! The setup as seen by the calculations: the units of the widths given
+ *  by the user, and the paths of the fragment through the layers. Shared
+ *  by \ref Worker, \ref Reconstructor and the Python module, so that all
+ *  see the same telescope. The paths are templates so that they also
+ *  carry derivatives, \see DualNumber.
+ */
+class Geometry
+{
+public:
+    //! Angle of the normal of the telescope to the beam [rad].
+    static constexpr double NORMAL = 47*std::numbers::pi/180.;
+
+    //! \return the unit of a material with a width given in unit.
+    static Material::Unit MatUnit(const Unit_t &unit /*!< Unit of the setup. */);
+
+    //! \return the angle of incidence on the telescope of a fragment at a scattering angle.
+    /*! The telescope is mirrored at backward angles.
+     */
+    template<typename T>
+    static T IncAngle(const T &angle,                   /*!< Scattering angle [rad].                    */
+                      const double &normal = NORMAL     /*!< Angle of the normal to the beam [rad].     */)
+    {
+        return (angle > std::numbers::pi/2.) ? std::numbers::pi - normal - angle : angle - normal;
+    }
+
+    //! \return the path through a layer of the target, or the whole target, at a scattering angle.
+    template<typename T>
+    static T Path(const T &width,   /*!< Width of the layer along its normal.   */
+                  const T &angle    /*!< Scattering angle [rad].                */)
+    {
+        using std::cos;
+        using std::fabs;
+        return width/fabs(cos(angle));
+    }
+
+    //! \return the path out of the target from its middle, at a scattering angle.
+    template<typename T>
+    static T HalfPath(const T &width,   /*!< Width of the target along its normal.  */
+                      const T &angle    /*!< Scattering angle [rad].                */)
+    {
+        using std::cos;
+        using std::fabs;
+        return width/fabs(2*cos(angle));
+    }
+
+    //! \return the path through a layer of the telescope.
+    template<typename T>
+    static T TelescopePath(const T &width,      /*!< Width of the layer along its normal.   */
+                           const T &incAngle    /*!< Angle of incidence [rad].              */)
+    {
+        using std::cos;
+        return width/cos(incAngle);
+    }
+
+    //! \return true if the fragment leaves the target through the fronting.
+    /*! That is at backward angles when there is a fronting, else the
+     *  fragment leaves through the backing, if any.
+     */
+    static bool ThroughFront(const double &angle,   /*!< Scattering angle [rad].        */
+                             const bool &front      /*!< True if there is a fronting.   */)
+    {
+        return angle > std::numbers::pi/2. && front;
+    }
+};
+
+#endif // GEOMETRY_H
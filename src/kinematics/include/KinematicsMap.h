@@ -0,0 +1,120 @@
+#ifndef KINEMATICSMAP_H
+#define KINEMATICSMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Particle;
+
+//! Class: KinematicsMap
+/*! Two-body kinematics of a reaction A(X,Y)B, tabulated on a grid of
+ *  scattering angle of Y and excitation energy of B at a fixed beam
+ *  energy. Each point holds the energy of Y, and the energy and angle of
+ *  B, as found by \ref RelScatter and \ref Scattering::EvaluateB, and
+ *  \ref Evaluate interpolates between them. Points where the reaction is
+ *  not possible hold NaN. The angles are made in parallel.
+ *
+ *  The file written by \ref Write is read by \ref Read without copying
+ *  where memory mapping is available. It holds, in the native byte
+ *  order: "QKKMAP01", A and Z of A, X, Y and B (32 bit signed), the
+ *  number of angles and excitation energies (32 bit unsigned), the beam
+ *  energy, first and last angle and highest excitation energy (64 bit
+ *  floats), and then E_Y, E_B and theta_B of each point as 32 bit
+ *  floats, with the excitation energy changing fastest.
+ */
+class KinematicsMap
+{
+public:
+    //! Number of values at each point.
+    static const int NVALUES = 3;
+
+    //! Constructor, an empty map.
+    KinematicsMap();
+
+    //! Destructor.
+    ~KinematicsMap();
+
+    KinematicsMap(const KinematicsMap &) = delete;
+    KinematicsMap &operator=(const KinematicsMap &) = delete;
+
+    //! Tabulate the kinematics of a reaction.
+    /*! \return false if the grid is empty or the particles do not match.
+     */
+    bool Make(Particle *pA,             /*!< Incident particle.                         */
+              Particle *pX,             /*!< Target particle.                           */
+              Particle *pY,             /*!< Fragment.                                  */
+              Particle *pB,             /*!< Residual.                                  */
+              const double &E,          /*!< Beam energy [MeV].                         */
+              const double &thetaMin,   /*!< First angle of the fragment [rad].         */
+              const double &thetaMax,   /*!< Last angle of the fragment [rad].          */
+              const int &nTheta,        /*!< Number of angles.                          */
+              const double &ExMax,      /*!< Highest excitation energy of B [MeV].      */
+              const int &nEx            /*!< Number of excitation energies, from 0.     */);
+
+    //! Interpolate the kinematics bilinearly.
+    /*! \return false if outside the grid or the reaction is not possible
+     *  at a neighbouring point.
+     */
+    bool Evaluate(const double &theta,  /*!< Angle of the fragment [rad].   */
+                  const double &Ex,     /*!< Excitation energy of B [MeV].  */
+                  double &EY,           /*!< Energy of the fragment [MeV].  */
+                  double &EB,           /*!< Energy of the residual [MeV].  */
+                  double &thetaB        /*!< Angle of the residual [rad].   */) const;
+
+    //! Write the map to a file.
+    /*! \return false if the file could not be written.
+     */
+    bool Write(const std::string &file /*!< File to write. */) const;
+
+    //! Read a map written by \ref Write, replacing this one.
+    /*! \return false if the file could not be read or is not a map.
+     */
+    bool Read(const std::string &file /*!< File to read. */);
+
+    //! \return the value v (E_Y, E_B, theta_B) at grid point i, j.
+    inline float GetValue(const int &i, const int &j, const int &v) const
+    { return values[(size_t(i)*nEx + j)*NVALUES + v]; }
+
+    //! \return the angle of grid index i [rad].
+    inline double GetTheta(const int &i) const { return (nTheta > 1) ? thetaMin + i*(thetaMax - thetaMin)/(nTheta - 1) : thetaMin; }
+
+    //! \return the excitation energy of grid index j [MeV].
+    inline double GetEx(const int &j) const { return (nEx > 1) ? j*ExMax/(nEx - 1) : 0; }
+
+    //! \return the number of angles.
+    inline int GetNTheta() const { return nTheta; }
+
+    //! \return the number of excitation energies.
+    inline int GetNEx() const { return nEx; }
+
+    //! \return the beam energy [MeV].
+    inline double GetE() const { return E; }
+
+    //! \return A and Z of the incident, target, fragment and residual particles.
+    inline const int32_t *GetParticles() const { return particles; }
+
+private:
+    //! Free the values.
+    void Clear();
+
+    //! A and Z of the particles.
+    int32_t particles[8];
+
+    //! Grid.
+    double E, thetaMin, thetaMax, ExMax;
+    int nTheta, nEx;
+
+    //! Values made by \ref Make.
+    std::vector<float> storage;
+
+    //! The values, in storage or in a mapped file.
+    const float *values;
+
+    //! Mapped file, if any.
+    void *mapped;
+    size_t mappedSize;
+};
+
+#endif // KINEMATICSMAP_H
@@ -0,0 +1,48 @@
+#ifndef PUNCHTHROUGH_H
+#define PUNCHTHROUGH_H
+
+class RangeTable;
+
+//! Class: PunchThrough
+/*! Energy thresholds of a particle entering a dE-E telescope, found by
+ *  inverting the range tables of the two detectors instead of scanning
+ *  energies. All energies are at the front of the thin detector, in [MeV].
+ */
+class PunchThrough
+{
+public:
+    //! Constructor.
+    PunchThrough(const RangeTable *dE,  /*!< Range table of the thin detector.          */
+                 const double &wDE,     /*!< Width of the thin detector, table units.   */
+                 const RangeTable *E,   /*!< Range table of the thick detector.         */
+                 const double &wE       /*!< Width of the thick detector, table units.  */);
+
+    //! \return the highest energy that is stopped in the thin detector.
+    double StopDE() const;
+
+    //! \return the highest energy that is stopped in the thick detector,
+    //! leaving at most Eres behind it.
+    double Punch(const double &Eres=0 /*!< Energy left behind the thick detector. */) const;
+
+    //! \return the lowest energy depositing at least Emin in the thick detector.
+    double Lower(const double &Emin /*!< Lowest energy seen in the thick detector. */) const;
+
+    //! \return the highest energy depositing at least Emin in the thick
+    //! detector, 0 if the detector can never see Emin.
+    double Upper(const double &Emin /*!< Lowest energy seen in the thick detector. */) const;
+
+private:
+    //! Range table of the thin detector.
+    const RangeTable *tDE;
+
+    //! Range table of the thick detector.
+    const RangeTable *tE;
+
+    //! Width of the thin detector.
+    double wDE;
+
+    //! Width of the thick detector.
+    double wE;
+};
+
+#endif // PUNCHTHROUGH_H
@@ -0,0 +1,78 @@
+#ifndef RANGECACHE_H
+#define RANGECACHE_H
+
+#include "StoppingModel.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+class Particle;
+class Material;
+class RangeTable;
+
+//! Class: RangeCache
+/*! Keeps \ref RangeTable "range tables" on disk so they are made once and
+ *  then reused across sessions. A table is stored under a hash of
+ *  everything that goes into it: the model and its precision,
+ *  \ref VERSION, the particle and the material properties (including the
+ *  Ziegler coefficients) and the energy grid. Changing any of them gives another file, so stale tables
+ *  are never read. Tables read in this session are also kept in memory.
+ *  The energy grid is fixed by the model (\ref StoppingModel::TableEmax),
+ *  so the same particle in the same material finds the same table for
+ *  any energy.
+ *
+ *  When the tables on disk take more than \ref MAX_SIZE, those used
+ *  longest ago are removed (\ref Prune). Reading a table counts as a use.
+ *
+ *  Nothing is read or written before \ref SetDirectory is called.
+ */
+class RangeCache
+{
+public:
+    //! Version of the stopping-power models. Bump it when any model changes.
+    static constexpr uint32_t VERSION = 1;
+
+    //! Largest size of the tables kept on disk [bytes].
+    static constexpr uintmax_t MAX_SIZE = uintmax_t(64) << 20;
+
+    //! Set the directory to keep the tables in, an empty path disables the cache.
+    static void SetDirectory(const std::string &dir);
+
+    //! \return the directory the tables are kept in, empty if disabled.
+    static std::string GetDirectory();
+
+    //! Looks up a range table, or makes and stores it.
+    /*! \return the table from memory or disk if there, else the one
+     *  returned by make, which is then stored.
+     */
+    static std::shared_ptr<RangeTable> Get(const StoppingModel::Model_t &model,    /*!< The model of the table.        */
+                                           const StoppingModel::Precision_t &precision, /*!< Precision of the model. */
+                                           const Particle *particle,                /*!< Incident particle.             */
+                                           const Material *material,                /*!< Material.                      */
+                                           const double &Emin,                      /*!< Lowest energy in [MeV].        */
+                                           const double &Emax,                      /*!< Highest energy in [MeV].       */
+                                           const std::function<std::shared_ptr<RangeTable>()> &make /*!< Makes the table. */);
+
+    //! Forget the tables kept in memory. Files on disk are kept.
+    static void ClearCache();
+
+    //! Remove the tables on disk used longest ago until the rest take at most maxSize.
+    /*! Called after every table written.
+     */
+    static void Prune(const uintmax_t &maxSize = MAX_SIZE /*!< Largest size to keep [bytes]. */);
+
+private:
+    //! Read a table from a file.
+    /*! \return the table, nullptr if the file is missing or does not match.
+     */
+    static std::shared_ptr<RangeTable> Read(const std::string &path, const std::string &key);
+
+    //! Write a table to a file.
+    /*! \return true if written.
+     */
+    static bool Write(const std::string &path, const std::string &key, const RangeTable *table);
+};
+
+#endif // RANGECACHE_H
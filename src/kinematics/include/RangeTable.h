@@ -0,0 +1,114 @@
+#ifndef RANGETABLE_H
+#define RANGETABLE_H
+
+#include "spline.h"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+//! Class: RangeTable
+/*! Tabulated range of a particle in a material, R(E) = int_0^E dE'/S(E').
+ *  The energy after a layer of width d is found as E' = R^-1(R(E) - d),
+ *  so one table serves every thickness and every incoming energy. This
+ *  makes it cheap to reuse for layers that do not depend on the beam
+ *  (e.g. the telescope) when the same setup is evaluated many times.
+ */
+class RangeTable
+{
+public:
+    //! Constructor.
+    RangeTable(const std::function<double(const double &)> &stopping,  /*!< Stopping power in [MeV/(width unit)] at E in [MeV], positive.  */
+               const double &Emin,                                     /*!< Lowest energy in [MeV]. Particles below are stopped.          */
+               const double &Emax,                                     /*!< Highest energy in [MeV].                                      */
+               const int &points=1000                                  /*!< Number of log spaced grid points.                            */);
+
+    //! Constructor from a grid made before, see \ref GetGrid.
+    RangeTable(const double &Emin,                  /*!< Lowest energy in [MeV].        */
+               const double &Emax,                  /*!< Highest energy in [MeV].       */
+               const double &Rmin,                  /*!< Range at Emin.                 */
+               const std::vector<double> &lnEgrid,  /*!< ln(E) at the grid points.      */
+               const std::vector<double> &lnRgrid   /*!< ln(R) at the grid points.      */);
+
+    //! Range of the particle.
+    /*! \return the range in width units of a particle with energy E.
+     */
+    double Range(const double &E /*!< Energy in [MeV]. */) const;
+
+    //! Energy of a particle with given range, the inverse of \ref Range
+    //! to round-off above the lowest energy of the table.
+    /*! \return the energy in [MeV], 0 if the range is below the table.
+     */
+    double Energy(const double &R /*!< Range in width units. */) const;
+
+    //! Calculates energy loss in a layer.
+    /*! \return The energy after passing through
+     *  the layer, 0 if the particle is stopped.
+     */
+    double Loss(const double &E,    /*!< Initial energy in [MeV].   */
+                const double &width /*!< Width of the layer.        */) const;
+
+    //! Inverse of \ref Loss.
+    /*! \return the energy a particle must have before the layer
+     *  to leave it with energy E.
+     */
+    double Gain(const double &E,    /*!< Energy after the layer in [MeV].   */
+                const double &width /*!< Width of the layer.                */) const;
+
+    //! \ref Loss of many particles, Eout may be E. NaN energies stay NaN.
+    void Loss(const double *E,      /*!< Initial energies in [MeV].         */
+              const double *width,  /*!< Width of the layer for each.       */
+              double *Eout,         /*!< Energies after the layer.          */
+              const size_t &n       /*!< Number of particles.               */) const;
+
+    //! \ref Loss of many particles through the same width.
+    void Loss(const double *E,      /*!< Initial energies in [MeV].         */
+              const double &width,  /*!< Width of the layer.                */
+              double *Eout,         /*!< Energies after the layer.          */
+              const size_t &n       /*!< Number of particles.               */) const;
+
+    //! \ref Gain of many particles, Eout may be E. NaN energies stay NaN.
+    void Gain(const double *E,      /*!< Energies after the layer in [MeV]. */
+              const double *width,  /*!< Width of the layer for each.       */
+              double *Eout,         /*!< Energies before the layer.         */
+              const size_t &n       /*!< Number of particles.               */) const;
+
+    //! \ref Gain of many particles through the same width.
+    void Gain(const double *E,      /*!< Energies after the layer in [MeV]. */
+              const double &width,  /*!< Width of the layer.                */
+              double *Eout,         /*!< Energies before the layer.         */
+              const size_t &n       /*!< Number of particles.               */) const;
+
+    //! \return the lowest energy in the table.
+    inline double GetEmin() const { return Emin; }
+
+    //! \return the highest energy in the table.
+    inline double GetEmax() const { return Emax; }
+
+    //! \return the range at the lowest energy in the table.
+    inline double GetRmin() const { return Rmin; }
+
+    //! \return ln(E) (first) and ln(R) (second) at the grid points.
+    inline std::pair<const std::vector<double> &, const std::vector<double> &> GetGrid() const { return {u, r}; }
+
+private:
+    //! Lowest energy in the table.
+    double Emin;
+
+    //! Highest energy in the table.
+    double Emax;
+
+    //! Range at Emin.
+    double Rmin;
+
+    //! Grid of ln(E) and ln(R).
+    std::vector<double> u, r;
+
+    //! ln(R) as a function of ln(E).
+    spline lnR;
+
+    //! ln(E) as a function of ln(R).
+    spline lnE;
+};
+
+#endif // RANGETABLE_H
@@ -1,14 +1,48 @@
 #ifndef RELSCATTER_H
 #define RELSCATTER_H
 
+#include "Dual.h"
 #include "types.h"
 
+#include <cmath>
+
 class Particle;
 #include "Scattering.h"
 
 class RelScatter : public Scattering
 {
 public:
+    //! Kinematics at a fixed incident energy and scattering angle.
+    /*! Everything that does not depend on the excitation energy is
+     *  calculated once by \ref RelScatter::Prepare, leaving a short,
+     *  branch free calculation for each excitation energy.
+     */
+    class Prepared
+    {
+    public:
+        //! \return the energy of particle Y when B has excitation energy Ex.
+        inline double operator()(const double &Ex /*!< Excitation of particle B. */) const
+        {
+            double m4ex = m4 + Ex;
+            double t = s - m3*m3 - m4ex*m4ex;
+            double pcm2 = (t*t - 4*m3*m3*m4ex*m4ex)*inv4s;
+            double p3 = (sqrt(pcm2 + m3*m3)*a + sqrt(pcm2 - b)*c)*d;
+            return sqrt(p3*p3 + m3*m3) - m3;
+        }
+
+        //! Energy of particle Y for n excitation energies.
+        void operator()(const double *Ex,   /*!< Excitation energies of particle B. */
+                        double *EY,         /*!< Energies of particle Y.            */
+                        const int &n        /*!< Number of excitation energies.     */) const;
+
+    private:
+        friend class RelScatter;
+
+        double m3, m4;      //! Masses of Y and B (ground state) in [MeV].
+        double s, inv4s;    //! Invariant mass squared and 1/(4s).
+        double a, b, c, d;  //! cos(theta)sinh(chi), (m3 sin(theta)sinh(chi))^2, cosh(chi) and 1/(1 + sin^2(theta)sinh^2(chi)).
+    };
+
     //! Constuctor.
     RelScatter(Particle *pA, /*!< Incident particle.            */
                Particle *pX, /*!< Target particle.              */
@@ -25,13 +59,37 @@ public:
                      const double &theta,   /*!< Scattering angle of particle Y */
                      const double &Ex       /*!< Excitation of particle B.      */) const;
 
+    //! Evaluate energy of residual particle for many excitation energies.
+    void EvaluateY(const double &E,     /*!< Incident energy.                   */
+                   const double &theta, /*!< Scattering angle of particle Y.    */
+                   const double *Ex,    /*!< Excitation energies of particle B. */
+                   double *EY,          /*!< Energies of particle Y.            */
+                   const int &n         /*!< Number of excitation energies.     */) const;
+
     adouble EvaluateY(double E, double theta, adouble Ex);
 
+    //! Prepare the kinematics for a given incident energy and angle.
+    /*! \return the kinematics, valid as long as the particles are unchanged.
+     */
+    Prepared Prepare(const double &E,       /*!< Incident energy.               */
+                     const double &theta    /*!< Scattering angle of particle Y */) const;
+
+    //! Evaluate energy of residual particle, with derivatives.
+    /*! \return Energy of particle Y after scattering.
+     */
+    Dual EvaluateY(const Dual &E,       /*!< Incident energy.               */
+                   const Dual &theta,   /*!< Scattering angle of particle Y */
+                   const Dual &Ex       /*!< Excitation of particle B.      */) const;
+
 
     //! Calculate the maximum excitation energy of particle B at given scattering angle and residual energy.
     double FindMaxEx(const double &E,       /*!< Incident energy.   */
                      const double &theta    /*!< Scattering angle.  */) const;
 
+private:
+    //! Energy of particle Y, for double or Dual.
+    template<typename T>
+    T EvaluateYT(const T &E, const T &theta, const T &Ex) const;
 };
 
 #endif // RELSCATTER_H
@@ -25,6 +25,16 @@ public:
                              const double &theta,   /*!< Scattering angle (Particle Y).             */
                              const double &Ex       /*!< Excitation energy of particle B.           */) const=0;
 
+    //! Function for calculating energy of particle Y for many excitation energies.
+    /*! Fills EY with the energy of particle Y for each of the n excitation
+     *  energies in Ex. The default calls \ref EvaluateY for each of them.
+     */
+    virtual void EvaluateY(const double &E,     /*!< Energy of incident particle (particle A).  */
+                           const double &theta, /*!< Scattering angle (Particle Y).             */
+                           const double *Ex,    /*!< Excitation energies of particle B.         */
+                           double *EY,          /*!< Energies of particle Y.                    */
+                           const int &n         /*!< Number of excitation energies.             */) const;
+
     //! Function for calculating energy of particle B.
     /*! \return Energy of particle B after scattering.
      */
@@ -0,0 +1,104 @@
+#ifndef STOPPINGMODEL_H
+#define STOPPINGMODEL_H
+
+#include "Material.h"
+
+#include <memory>
+
+class Particle;
+class RangeTable;
+class StoppingPower;
+
+//! Class: StoppingModel
+/*! Picks the stopping-power model for a particle in a material over the
+ *  energies it will have, and makes it with the backend asked for:
+ *  analytic (\ref Make), integrated step by step, or tabulated
+ *  (\ref MakeTable), a \ref RangeTable that is cheap when the same layer
+ *  is crossed many times. The choice is
+ *   - \ref Bethe if the particle or the material has Z > 92, where the
+ *     Ziegler fits are not defined,
+ *   - \ref Stitched (\ref ZieglerBethe) if the energy goes above the
+ *     end of the Ziegler fits (\ref ZieglerBethe::STITCH),
+ *   - \ref Ziegler otherwise.
+ *
+ *  The precision of the Ziegler fits is given to \ref Make and
+ *  \ref MakeTable, by default the one set for the whole program with
+ *  \ref SetPrecision, \see Ziegler1985.
+ */
+class StoppingModel
+{
+public:
+    //! The models.
+    enum Model_t {
+        Ziegler,        //! Ziegler (1985), widths in [µm].
+        Bethe,          //! Bethe-Block, widths in [g/cm²].
+        Stitched,       //! Ziegler stitched to Bethe-Block, widths in [µm].
+        NumModels       //! Number of models.
+    };
+
+    //! Precision of the transcendental functions in the Ziegler fits.
+    enum Precision_t {
+        Exact,          //! Standard library.
+        Fast            //! Approximations of \ref FastMath.
+    };
+
+    //! Set the precision of the stopping powers made from now on, when none is given. The default is Exact.
+    static void SetPrecision(const Precision_t &precision /*!< Precision. */);
+
+    //! \return the precision of the stopping powers made when none is given.
+    static Precision_t GetPrecision();
+
+    //! \return the model for a particle in a material.
+    static Model_t Choose(const Particle *particle,     /*!< Incident particle.                 */
+                          const Material *material,     /*!< Material.                          */
+                          const double &Emax            /*!< Highest energy of the particle [MeV]. */);
+
+    //! \return the unit of the widths a model expects.
+    static Material::Unit Unit(const Model_t &model);
+
+    //! \return the name of a model.
+    static const char *Name(const Model_t &model);
+
+    //! Analytic stopping power of the chosen model.
+    /*! \return the stopping power, to be deleted by the caller. The unit
+     *  is set to the unit of the widths it expects.
+     */
+    static StoppingPower *Make(const Material *material,    /*!< Material, copied.                          */
+                               const Particle *particle,    /*!< Incident particle, copied.                 */
+                               const double &Emax,          /*!< Highest energy of the particle [MeV].      */
+                               Material::Unit &unit,        /*!< Set to the unit of the widths.             */
+                               const Precision_t &precision = GetPrecision() /*!< Precision of the Ziegler fits. */);
+
+    //! Highest energy of the range tables of a model [MeV].
+    /*! The end of the Ziegler fits for \ref Ziegler, else \ref BETHE_EMAX
+     *  per nucleon, doubled until it reaches Emax. Tables of a particle in
+     *  a material are then the same for all energies in the model, and
+     *  are found again in \ref RangeCache.
+     */
+    static double TableEmax(const Model_t &model,          /*!< The model.                             */
+                            const Particle *particle,      /*!< Incident particle.                     */
+                            const double &Emax             /*!< Highest energy of the particle [MeV].  */);
+
+    //! Highest energy per nucleon of the range tables with Bethe-Block [MeV/u].
+    static constexpr double BETHE_EMAX = 1000.;
+
+    //! Range table of the chosen model, from 1 keV (0.1 MeV for Bethe-Block) to \ref TableEmax.
+    /*! The table is taken from \ref RangeCache if it has been made before.
+     *  \return the table, width is set to the width of the material in table units.
+     */
+    static std::shared_ptr<RangeTable> MakeTable(const Particle *particle,  /*!< Incident particle.                     */
+                                                 const Material *material,  /*!< Material.                              */
+                                                 const double &Emax,        /*!< Highest energy of the particle [MeV].  */
+                                                 double &width,             /*!< Set to the width in table units.       */
+                                                 const Precision_t &precision = GetPrecision() /*!< Precision of the Ziegler fits. */);
+
+    //! Range table of a stopping power over the whole range of its model.
+    /*! For the models made by \ref Make the table is the one \ref MakeTable
+     *  gives at the lowest energies, from \ref RangeCache, up to \ref TableEmax.
+     *  Other stopping powers get a table of their own up to
+     *  StoppingPower::TABLE_EMAX per nucleon. Used by StoppingPower::GetTable.
+     */
+    static std::shared_ptr<RangeTable> Table(const StoppingPower *stop /*!< The stopping power. */);
+};
+
+#endif // STOPPINGMODEL_H
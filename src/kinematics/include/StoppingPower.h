@@ -2,18 +2,29 @@
 #define STOPPINGPOWER_H
 
 #include "AbstractFunction.h"
+#include "Dual.h"
+#include "Material.h"
+#include "Particle.h"
+#include "RangeTable.h"
 #include "types.h"
 
 #include <memory>
+#include <mutex>
 
-class Material;
-class Particle;
-
+//! Base class of the stopping-power models.
+/*! The material and the particle are copied when the object is made
+ *  and never changed, so the const functions may be called from
+ *  several threads at once.
+ */
 class StoppingPower : public AbstractFunction
 {
 public:
+    //! Empty constructor.
+    StoppingPower();
+
 	//! Constructor.
-    StoppingPower(Material *material, Particle *particle);
+    StoppingPower(const Material *material, /*!< Material, copied. */
+                  const Particle *particle  /*!< Incident particle, copied. */);
 
 	//! Virtual destructor.
     virtual ~StoppingPower() {}
@@ -33,53 +44,110 @@ public:
                         const int &points=1001  /*!< Number of integration points.                      */) const=0;
 
     //! Calculates energy loss in the material.
-    /*! \return The energy after passing through
-     *  the material.
+    /*! The stopping power is integrated in points steps, so \ref Gain,
+     *  from the range table, undoes it only to the accuracy of the
+     *  integration. The batched \ref Loss and \ref Gain are exact inverses.
+     *  \return The energy after passing through the material.
      */
     virtual double Loss(const double &E,        /*!< Initial energy of the incident particle in [MeV].      */
                         const double &width,    /*!< Width of the target. Units depends on implementation.  */
                         const int &points=1001  /*!< Number of integration points.                          */) const=0;
 
+    //! Calculates energy loss in the material, with derivatives
+    //! with respect to the energy and width.
+    /*! \return The energy after passing through the material.
+     *  The default implementation uses dE'/dE = S(E')/S(E) and
+     *  dE'/dw = S(E'), which assumes that \ref Evaluate is given
+     *  per width unit at an energy in [MeV].
+     */
+    virtual Dual Loss(const Dual &E,            /*!< Initial energy of the incident particle in [MeV].      */
+                      const Dual &width,        /*!< Width of the target. Units depends on implementation.  */
+                      const int &points=1001    /*!< Number of integration points.                          */) const;
+
     virtual adouble Loss(adouble E, int points=1001)=0;
     virtual adouble Loss(adouble E, double width, int points=1001)=0;
 
 
-    //! Calculates energy after the reversed process.
-    /*! \return The energy before passing through
-     *  the material.
+    //! Calculates energy after the reversed process, from the range
+    //! table of the model (\ref GetTable) and the width of the material.
+    /*! \return The energy before passing through the material.
      */
-    //virtual double Gain(const double &E,        /*!< Energy of the incident particle in [MeV] after material.   */
-    //                    const int &points=1000  /*!< Number of integration points.                              */) const=0;
+    double Gain(const double &E /*!< Energy of the incident particle in [MeV] after material. */) const;
 
-    //! Calculates energy after the reversed process.
-    /*! \return The energy before passing through
-     *  the material.
+    //! Calculates energy after the reversed process, from the range table of the model.
+    /*! Exact inverse, to round-off, of the loss of the range table. It
+     *  agrees with the integrated \ref Loss to the accuracy of the table.
+     *  \return The energy before passing through the material.
      */
-    //virtual double Gain(const double &E,        /*!< Energy of the incident particle in [MeV] after material.   */
-    //                    const double &width,    /*!< Width of the target. Units depends on implementation.      */
-    //                    const int &points=1000  /*!< Number of integration points.                              */) const=0;
+    double Gain(const double &E,        /*!< Energy of the incident particle in [MeV] after material.   */
+                const double &width     /*!< Width of the target, in \ref GetUnit.                      */) const;
+
+    //! Energies of many particles after the material, from the range table
+    //! of the model, so that \ref Gain is their exact inverse. Eout may be E.
+    void Loss(const double *E,          /*!< Initial energies in [MeV].                 */
+              const double *width,      /*!< Width for each particle, in \ref GetUnit.  */
+              double *Eout,             /*!< Energies after the material.               */
+              const size_t &n           /*!< Number of particles.                       */) const;
+
+    //! Same as above, for the same width.
+    void Loss(const double *E, const double &width, double *Eout, const size_t &n) const;
+
+    //! Energies of many particles before the material, e.g. to track
+    //! measured particles back to the reaction. Eout may be E.
+    void Gain(const double *E,          /*!< Energies after the material in [MeV].      */
+              const double *width,      /*!< Width for each particle, in \ref GetUnit.  */
+              double *Eout,             /*!< Energies before the material.              */
+              const size_t &n           /*!< Number of particles.                       */) const;
+
+    //! Same as above, for the same width.
+    void Gain(const double *E, const double &width, double *Eout, const size_t &n) const;
+
+    //! Range table of the model, from \ref GetEmin over the range of the model.
+    /*! Made when first needed, and shared by the copies of the object. The
+     *  same table as StoppingModel::MakeTable, \see StoppingModel::Table.
+     */
+    std::shared_ptr<const RangeTable> GetTable() const;
+
+    //! Stopping power as tabulated by \ref GetTable.
+    /*! \return the stopping power in [MeV/(width unit)], positive,
+     *  at E in [MeV]. The default is -\ref Evaluate.
+     */
+    virtual double Stopping(const double &E /*!< Energy of incident particle in [MeV]. */) const;
+
+    //! \return the unit of the widths of the model.
+    virtual Material::Unit GetUnit() const { return Material::um; }
+
+    //! \return the lowest energy of the range table [MeV].
+    virtual double GetEmin() const { return 1e-3; }
+
+    //! Highest energy per nucleon of the range table of models not made by StoppingModel [MeV/u].
+    static constexpr double TABLE_EMAX = 100.;
 
 	//! Overloaded () operator.
 	/*! \return \ref Evaluate.
 	 */
 	inline double operator()(const double &E) const { return Evaluate(E); }
 
-	//! Set the material.
-	/*! \return true if possible, false otherwise.
-	 */
-	void setMaterial(Material *material /*!< Material to set. */);
+    //! \return the material.
+    inline const Material &GetMaterial() const { return material; }
 
-	//! Set the incident particle.
-	/*! \return true if possible, false otherwise.
-	 */
-	void setParticle(Particle *particle /*!< Incident particle to set. */);
+    //! \return the incident particle.
+    inline const Particle &GetParticle() const { return particle; }
 
 protected:
 	//! Variable to contain the material.
-    Material *pMaterial;
+    Material material;
 
 	//! Variable to contain incident particle.
-    Particle *pParticle;
+    Particle particle;
+
+private:
+    //! The range table, made once for the object and its copies.
+    struct TableCache_t {
+        std::once_flag made;
+        std::shared_ptr<const RangeTable> table;
+    };
+    std::shared_ptr<TableCache_t> cache;
 };
 
 #endif // STOPPINGPOWER_H
@@ -0,0 +1,82 @@
+#ifndef STOPPINGTABLE_H
+#define STOPPINGTABLE_H
+
+#include "spline.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+//! Class: StoppingTable
+/*! A tabulated stopping power (e.g. SRIM or ATIMA output) read from
+ *  file and splined. Tables are shared between all users in the
+ *  process, so loading the same unchanged file twice only parses it
+ *  once.
+ *
+ *  Each data line holds an energy, optionally followed by a unit
+ *  (eV, keV, MeV or GeV, MeV is assumed if none is given), and one or
+ *  more stopping power columns that are summed (e.g. electronic and
+ *  nuclear stopping). Lines that do not start with a number, or have
+ *  no stopping power after the energy (such as the table of units at
+ *  the end of SRIM output), are skipped, as is anything after the
+ *  stopping power columns.
+ */
+class StoppingTable
+{
+public:
+    //! Load a table from file.
+    /*! \return the parsed table, or a null pointer if the file could
+     *  not be read or did not contain a valid table. The table is
+     *  cached, and the cached copy is returned as long as the
+     *  modification time of the file is unchanged.
+     */
+    static std::shared_ptr<const StoppingTable> Load(const std::string &path,   /*!< File to read.                                      */
+                                                     const int &columns=0       /*!< Number of stopping power columns to sum, 0 for all. */);
+
+    //! Remove all tables from the cache.
+    static void ClearCache();
+
+    //! Stopping power at a given energy.
+    /*! \return the interpolated (summed) stopping power at E.
+     */
+    inline double Evaluate(const double &E /*!< Energy in [MeV]. */) const { return sp(E); }
+
+    //! Stopping power at a given energy, starting the look-up from cursor.
+    /*! \return the interpolated (summed) stopping power at E.
+     */
+    inline double Evaluate(const double &E,     /*!< Energy in [MeV].                           */
+                           size_t &cursor       /*!< Look-up hint, updated. Initialise to 0.    */) const
+        { return sp(E, cursor); }
+
+    //! Lowest energy in the table in [MeV].
+    inline double GetEmin() const { return energy.front(); }
+
+    //! Highest energy in the table in [MeV].
+    inline double GetEmax() const { return energy.back(); }
+
+    //! Energies in the table in [MeV].
+    inline const std::vector<double> &GetEnergy() const { return energy; }
+
+    //! Stopping powers in the table.
+    inline const std::vector<double> &GetStopping() const { return stopping; }
+
+private:
+    //! Parse the content of a file.
+    /*! \return true if a valid table was found.
+     */
+    bool Parse(const char *begin,       /*!< Start of the file content.                 */
+               const char *end,         /*!< End of the file content.                   */
+               const int &columns,      /*!< Stopping power columns to sum, 0 for all.  */
+               const std::string &path  /*!< File name, for messages.                   */);
+
+    //! Tabulated energies in [MeV].
+    std::vector<double> energy;
+
+    //! Tabulated stopping powers.
+    std::vector<double> stopping;
+
+    //! Spline through the table.
+    spline sp;
+};
+
+#endif // STOPPINGTABLE_H
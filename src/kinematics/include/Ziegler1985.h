@@ -6,24 +6,36 @@
 class Material;
 class Particle;
 
+//! Class: Ziegler1985
+/*! Stopping power from the Ziegler (1985) fits. In the fast mode the
+ *  logarithms, exponentials and powers of the fits are approximated by
+ *  \ref FastMath for plain doubles, which changes the stopping power by
+ *  less than 1e-5. Derivatives (\ref Dual) are always exact.
+ */
 class Ziegler1985 : public StoppingPower
 {
 public:
+    //! Empty constructor.
     Ziegler1985();
-	//! Default Constructor.
-	Ziegler1985(Material *material, Particle *particle);
 
-    //! Destructor.
-    ~Ziegler1985();
+	//! Constructor. The material and particle are copied.
+	Ziegler1985(const Material *material,   /*!< Material.                          */
+	            const Particle *particle,   /*!< Incident particle.                 */
+	            const bool &fast = false    /*!< Use the fast transcendentals.      */);
 
-    //! Assign operator.
-    Ziegler1985 &operator=(const Ziegler1985 &ziegler);
+    //! \return true if the fast transcendentals are used.
+    inline bool IsFast() const { return fast; }
 
 	//! Calculates the stopping power.
     /*! \return Stopping power in [MeV/µm].
 	 */
     inline double Evaluate(const double &E /*!< Energy of incident particle in MeV. */) const { return -stop(E)*10; }
 
+    //! Calculates the stopping power and its derivatives.
+    /*! \return Stopping power in [MeV/µm].
+     */
+    Dual Evaluate(const Dual &E /*!< Energy of incident particle in MeV. */) const;
+
     //! Calculates energy loss in the material.
     /*! \return The energy after passing through
      *  the material.
@@ -32,6 +44,15 @@ public:
                 const double &d,        /*!< Width of target in [µm].                           */
                 const int &points=1000  /*!< Number of integration points.                      */) const;
 
+    //! Calculates energy loss in the material, with derivatives
+    //! with respect to the energy and width.
+    /*! \return The energy after passing through
+     *  the material.
+     */
+    Dual Loss(const Dual &E,            /*!< Initial energy of the incident particle in [MeV].  */
+              const Dual &d,            /*!< Width of target in [µm].                           */
+              const int &points=1000    /*!< Number of integration points.                      */) const;
+
     //! Calculates energy loss in the material.
     /*! \return The energy after passing through
      *  the material.
@@ -42,37 +63,48 @@ public:
     adouble Loss(adouble E, int points=1001);
     adouble Loss(adouble E, double width, int points=1001);
 
-    //! Calculates energy after the reversed process.
-    /*! \return The energy before passing through
-     *  the material.
-     */
-    double Gain(const double &E,        /*!< Energy of the incident particle in [MeV] after material.   */
-                const int &points=1000  /*!< Number of integration points.                              */) const;
+    //! Stopping power in [MeV/µm] at E in [MeV], positive, \see StoppingPower::Stopping.
+    inline double Stopping(const double &E) const { return -Evaluate(E*1e3)*1e-3; }
+
+    using StoppingPower::Loss;
 
-    //! Calculates energy after the reversed process.
-    /*! \return The energy before passing through
-     *  the material.
-     */
-    double Gain(const double &E,        /*!< Energy of the incident particle in [MeV] after material.   */
-                const double &width,    /*!< Width of the target. Units depends on implementation.      */
-                const int &points=1000  /*!< Number of integration points.                              */) const;
 private:
+    //! True to use \ref FastMath for doubles.
+    bool fast;
+
+    //! Cube root and its square of the particle Z, and the screening mass of the nuclear stopping.
+    double z13, z23, rm;
+
+    //! Logarithm, exponential and power, fast for doubles in the fast mode.
+    template<typename T> T Log(const T &x) const;
+    template<typename T> T Exp(const T &x) const;
+    template<typename T> T Pow(const T &x, const double &y) const;
+
 	//! Fucntion to calculate proton stopping power.
 	/*! \return the proton stopping power of protons in the material.
 	 */
-	double pstop(const double &e /*!< Energy of proton. */) const;
+	template<typename T>
+	T pstop(const T &e /*!< Energy of proton. */) const;
 
 	//! Function to calculate alfa particle stopping power.
 	/*! \return the stopping power of alpha particles in the material.
 	 */
-	double hestop(const double &e /*!< Energy of alfa particle. */) const;
+	template<typename T>
+	T hestop(const T &e /*!< Energy of alfa particle. */) const;
 
 	//! Function to calculate ion stopping power.
 	/*! \return the stopping power of ion stopping power in the material.
 	 */
-	double histop(const double &e /*!< Energy of ion. */) const;
+	template<typename T>
+	T histop(const T &e /*!< Energy of ion. */) const;
+
+    //! Total (electronic and nuclear) stopping power.
+    template<typename T>
+    T stop(const T &ee) const;
 
-    double stop(const double &ee) const;
+    //! Runge-Kutta integration of the energy loss, for double or Dual.
+    template<typename T>
+    T LossT(const T &E, const T &d, const int &points) const;
 
 	//! Function to calculate the nuclear stopping power.
 	/*! \return the nuclear stopping power of particle in the material.
@@ -0,0 +1,89 @@
+#ifndef ZIEGLERBETHE_H
+#define ZIEGLERBETHE_H
+
+#include "StoppingPower.h"
+#include "Ziegler1985.h"
+#include "BetheBlock.h"
+
+//! Class: ZieglerBethe
+/*! Ziegler (1985) stopping power at low energy, stitched to the
+ *  Bethe-Block formula above \ref GetEstitch where the Ziegler fits end.
+ *  The Bethe part is scaled to be continuous at the stitch. Units are as
+ *  for \ref Ziegler1985: energies in [keV] for \ref Evaluate, [MeV] for
+ *  the energy loss, and widths in [µm].
+ */
+class ZieglerBethe : public StoppingPower
+{
+public:
+    //! Highest energy per nucleon of the Ziegler part [MeV/u].
+    static constexpr double STITCH = 100.;
+
+    //! Empty constructor.
+    ZieglerBethe();
+
+    //! Constructor. The material and particle are copied.
+    ZieglerBethe(const Material *material,  /*!< Material.                                      */
+                 const Particle *particle,  /*!< Incident particle.                             */
+                 const bool &fast = false   /*!< Fast transcendentals, \see Ziegler1985.        */);
+
+    //! \return the energy where the Bethe-Block part takes over [MeV].
+    inline double GetEstitch() const { return 1e-3*Estitch; }
+
+    //! \return true if the Ziegler part uses the fast transcendentals.
+    inline bool IsFast() const { return low.IsFast(); }
+
+    //! Calculates the stopping power.
+    /*! \return Stopping power in [keV/µm], negative.
+     */
+    double Evaluate(const double &E /*!< Energy of incident particle in [keV]. */) const;
+
+    //! Calculates the stopping power and its derivatives.
+    Dual Evaluate(const Dual &E /*!< Energy of incident particle in [keV]. */) const;
+
+    //! Calculates energy loss in the material.
+    /*! \return The energy after passing through the material.
+     */
+    double Loss(const double &E,        /*!< Initial energy of the incident particle in [MeV].  */
+                const int &points=1001  /*!< Number of integration points.                      */) const;
+
+    //! Calculates energy loss in the material.
+    /*! \return The energy after passing through the material.
+     */
+    double Loss(const double &E,        /*!< Initial energy of the incident particle in [MeV].  */
+                const double &d,        /*!< Width of the material in [µm].                     */
+                const int &points=1001  /*!< Number of integration points.                      */) const;
+
+    //! Energy loss with derivatives with respect to energy and width.
+    Dual Loss(const Dual &E,            /*!< Initial energy of the incident particle in [MeV].  */
+              const Dual &d,            /*!< Width of the material in [µm].                     */
+              const int &points=1001    /*!< Number of integration points.                      */) const;
+
+    adouble Loss(adouble E, int points=1001);
+    adouble Loss(adouble E, double width, int points=1001);
+
+    //! Stopping power in [MeV/µm] at E in [MeV], positive, \see StoppingPower::Stopping.
+    inline double Stopping(const double &E) const { return -Evaluate(E*1e3)*1e-3; }
+
+    using StoppingPower::Loss;
+
+private:
+    //! The two parts.
+    Ziegler1985 low;
+    BetheBlock high;
+
+    //! Energy of the stitch [keV].
+    double Estitch;
+
+    //! Converts the Bethe-Block part from [MeV cm²/g] to [keV/µm], including the scale at the stitch.
+    double scale;
+
+    //! Stopping power, for double or Dual.
+    template<typename T>
+    T EvaluateT(const T &E) const;
+
+    //! Runge-Kutta integration of the energy loss, for double or Dual.
+    template<typename T>
+    T LossT(const T &E, const T &d, const int &points) const;
+};
+
+#endif // ZIEGLERBETHE_H
@@ -2,6 +2,7 @@
 
 #include "Material.h"
 #include "Particle.h"
+#include "Profiler.h"
 
 #ifndef BETHEBLOCKCONST
 #define BETHEBLOCKCONST 0.1535 // MeVcm^2/g
@@ -12,83 +13,82 @@
 #endif
 
 BetheBlock::BetheBlock()
-    : StoppingPower(new Material(), new Particle())
+    : StoppingPower()
     , densCorrSet( false ) {}
 
-BetheBlock::BetheBlock(Material *material, Particle *particle)
+BetheBlock::BetheBlock(const Material *material, const Particle *particle)
 	: StoppingPower(material, particle)
 	, densCorrSet( false )
 {
 }
 
-BetheBlock::~BetheBlock()
+template<typename T>
+T BetheBlock::EvaluateT(const T &E) const
 {
-    //delete pMaterial;
-    //delete pParticle;
-}
+	T Erel = E + particle.GetM_MeV();
+	T prel = sqrt(Erel*Erel - particle.GetM_MeV()*particle.GetM_MeV());
+	T beta = prel/Erel;
+	T gamma = 1./sqrt(1 - beta*beta);
 
-BetheBlock &BetheBlock::operator=(const BetheBlock &bb)
-{
-    this->pMaterial = new Material(*(bb.pMaterial));
-    this->pParticle = new Particle(*(bb.pParticle));
-    this->densCorrSet = bb.densCorrSet;
-    this->densCorr = bb.densCorr;
-    return *this;
+    T result = 2*log(2*MASSELECTRON*pow(beta*gamma, 2)/material.GetMeanEx());
+    result -= log(pow(MASSELECTRON/particle.GetM_MeV(), 2) + 2*gamma*MASSELECTRON/particle.GetM_MeV() + 1);
+	result -= 2*beta*beta;
+	if (densCorrSet)
+		result -= calcDensityCorrection(log10(beta*gamma));
+    result *= BETHEBLOCKCONST*material.GetZ()*pow(particle.GetZ(), 2)/(material.GetA()*pow(beta,2));
+    return -fabs(result);
 }
 
 double BetheBlock::Evaluate(const double &E) const
 {
-	double Erel = E + pParticle->GetM_MeV();
-	double prel = sqrt(Erel*Erel - pParticle->GetM_MeV()*pParticle->GetM_MeV());
-	double beta = prel/Erel;
-	double gamma = 1./sqrt(1 - beta*beta);
+    return EvaluateT(E);
+}
 
-    double result = 2*log(2*MASSELECTRON*pow(beta*gamma, 2)/pMaterial->GetMeanEx());
-    result -= log(pow(MASSELECTRON/pParticle->GetM_MeV(), 2) + 2*gamma*MASSELECTRON/pParticle->GetM_MeV() + 1);
-	result -= 2*beta*beta;
-	if (densCorrSet)
-		result -= calcDensityCorrection(log10(beta*gamma));
-    result *= BETHEBLOCKCONST*pMaterial->GetZ()*pow(pParticle->GetZ(), 2)/(pMaterial->GetA()*pow(beta,2));
-    return -fabs(result);
+Dual BetheBlock::Evaluate(const Dual &E) const
+{
+    return EvaluateT(E);
 }
 
 double BetheBlock::Loss(const double &E, const int &points) const
 {
-    double dx = pMaterial->GetWidth(Material::gcm2)/(points - 1);
-    double e = E;
-    double R1, R2, R3, R4;
-    for (int i = 0 ; i < points ; ++i){
+    return LossT(E, material.GetWidth(Material::gcm2), points);
+}
+
+template<typename T>
+T BetheBlock::LossT(const T &E, const T &width, const int &points) const
+{
+    T dx = width/(points - 1);
+    T e = E;
+    T R1, R2, R3, R4;
+    int i = 0;
+    for ( ; i < points ; ++i){
         R1 = dx*Evaluate(e);
         R2 = dx*Evaluate(e + 0.5*R1);
         R3 = dx*Evaluate(e + 0.5*R2);
         R4 = dx*Evaluate(e + R3);
         e += (R1 + 2*(R2 + R3) + R4)/6.;
-        if (e < 0.1 || e != e)
-            return 0;
+        if (e < 0.1 || e != e){
+            e = 0;
+            break;
+        }
     }
+    Profiler::Steps(i);
     return e;
 }
 
 double BetheBlock::Loss(const double &E, const double &width, const int &points) const
 {
-    double dx = width/(points - 1);
-    double e = E;
-    double R1, R2, R3, R4;
-    for (int i = 0 ; i < points ; ++i){
-        R1 = dx*Evaluate(e);
-        R2 = dx*Evaluate(e + 0.5*R1);
-        R3 = dx*Evaluate(e + 0.5*R2);
-        R4 = dx*Evaluate(e + R3);
-        e += (R1 + 2*(R2 + R3) + R4)/6.;
-        if (e < 0.1 || e != e)
-            return 0;
-    }
-    return e;
+    return LossT(E, width, points);
+}
+
+Dual BetheBlock::Loss(const Dual &E, const Dual &width, const int &points) const
+{
+    return LossT(E, width, points);
 }
 
 adouble BetheBlock::Loss(adouble E, int points)
 {
-    double dx = pMaterial->GetWidth(Material::gcm2)/(points - 1);
+    double dx = material.GetWidth(Material::gcm2)/(points - 1);
     adouble e = E;
     adouble R1(E.size()), R2(E.size()), R3(E.size()), R4(E.size());
     for (int i = 0 ; i < points ; ++i){
@@ -141,7 +141,8 @@ adouble BetheBlock::Loss(adouble E, double width, int points)
 #endif // __linux
 }
 
-double BetheBlock::calcDensityCorrection(const double &X) const
+template<typename T>
+T BetheBlock::calcDensityCorrection(const T &X) const
 {
     if (!densCorrSet)
         return 0;
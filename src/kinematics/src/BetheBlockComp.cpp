@@ -29,7 +29,7 @@ BetheBlockComp::BetheBlockComp(Material *material, double *weights, const int &n
         Aeff += material[i].GetA()*weights[i];
         Ieff += log(material[i].GetMeanEx())*weights[i]*material[i].GetZ();
         weight[i] = weights[i];
-        elements[i] = BetheBlock(new Material(*(material+i)), new Particle(*beam));
+        elements[i] = BetheBlock(material + i, beam);
     }
     Ieff /= Zeff;
     Ieff = exp(Ieff);
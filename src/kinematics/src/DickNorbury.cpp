@@ -35,6 +35,35 @@ double DickNorbury::EvaluateY(const double &E, const double &theta, const double
 
 }
 
+void DickNorbury::EvaluateY(const double &E, const double &theta, const double *Ex, double *EY, const int &n) const
+{
+    Prepare(E, theta)(Ex, EY, n);
+}
+
+DickNorbury::Prepared DickNorbury::Prepare(const double &E, const double &theta) const
+{
+    double m1 = A->GetM_MeV(), m2 = X->GetM_MeV();
+    double c3l = cos(theta);
+    double E1l = E + m1;
+
+    Prepared kin;
+    kin.m3 = Y->GetM_MeV();
+    kin.m4gs = B->GetM_MeV();
+    kin.Exmax = E + m1 + m2 - kin.m3 - kin.m4gs;
+    kin.s = m1*m1 + m2*m2 + 2*E1l*m2;
+    kin.b = E1l + m2;
+    double x2 = (E1l*E1l - m1*m1)*c3l*c3l;
+    kin.x = sqrt(x2);
+    kin.D = kin.b*kin.b - x2;
+    return kin;
+}
+
+void DickNorbury::Prepared::operator()(const double *Ex, double *EY, const int &n) const
+{
+    for (int i = 0 ; i < n ; ++i)
+        EY[i] = (*this)(Ex[i]);
+}
+
 double DickNorbury::FindMaxEx(const double &E, const double &theta) const
 {
     double Ex = 0.0;
@@ -0,0 +1,30 @@
+#include "ExitChannels.h"
+
+#include "ame2012_masses.h"
+
+std::vector<Channel_t> ExitChannels(const int &beamA, const int &beamZ, const int &targetA, const int &targetZ, const double &Ebeam)
+{
+    std::vector<Channel_t> channels;
+    const ame2012_mass_t &beam = find_entry(beamA, beamZ);
+    const ame2012_mass_t &target = find_entry(targetA, targetZ);
+    if (beam.A == 0 || target.A == 0)
+        return channels;
+
+    // Non-relativistic energy in the centre of mass frame.
+    double Ecm = Ebeam*target.mass_u_amu/(beam.mass_u_amu + target.mass_u_amu);
+    int A = beamA + targetA, Z = beamZ + targetZ;
+
+    // The table is sorted by A, then Z.
+    for (int i = 0 ; i < ame2012_n_masses && ame2012_masses[i].A < A ; ++i){
+        const ame2012_mass_t &fragment = ame2012_masses[i];
+        if (fragment.Z < 1 || fragment.Z > Z)
+            continue;
+        const ame2012_mass_t &residual = find_entry(A - fragment.A, Z - fragment.Z);
+        if (residual.A == 0)
+            continue;
+        double Q = 1e-3*(beam.mass_excess + target.mass_excess - fragment.mass_excess - residual.mass_excess);
+        if (Ecm + Q > 0)
+            channels.push_back({fragment.A, fragment.Z, residual.A, residual.Z, Q});
+    }
+    return channels;
+}
@@ -0,0 +1,11 @@
+#include "Geometry.h"
+
+Material::Unit Geometry::MatUnit(const Unit_t &unit)
+{
+    if (unit == mgcm2)
+        return Material::mgcm2;
+    else if (unit == gcm2)
+        return Material::gcm2;
+    else
+        return Material::um;
+}
@@ -0,0 +1,234 @@
+#include "KinematicsMap.h"
+
+#include "Particle.h"
+#include "RelScatter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define KINEMATICSMAP_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // __unix__ || __APPLE__
+
+namespace {
+
+const char MAGIC[8] = {'Q', 'K', 'K', 'M', 'A', 'P', '0', '1'};
+
+// Size of everything before the values.
+const size_t HEADER = sizeof(MAGIC) + 8*sizeof(int32_t) + 2*sizeof(uint32_t) + 4*sizeof(double);
+
+} // namespace
+
+KinematicsMap::KinematicsMap()
+    : particles{ 0, 0, 0, 0, 0, 0, 0, 0 }
+    , E( 0 )
+    , thetaMin( 0 )
+    , thetaMax( 0 )
+    , ExMax( 0 )
+    , nTheta( 0 )
+    , nEx( 0 )
+    , values( nullptr )
+    , mapped( nullptr )
+    , mappedSize( 0 )
+{
+}
+
+KinematicsMap::~KinematicsMap()
+{
+    Clear();
+}
+
+void KinematicsMap::Clear()
+{
+#ifdef KINEMATICSMAP_USE_MMAP
+    if (mapped)
+        munmap(mapped, mappedSize);
+#endif // KINEMATICSMAP_USE_MMAP
+    mapped = nullptr;
+    mappedSize = 0;
+    storage.clear();
+    values = nullptr;
+    nTheta = nEx = 0;
+}
+
+bool KinematicsMap::Make(Particle *pA, Particle *pX, Particle *pY, Particle *pB, const double &Ebeam,
+                         const double &theta0, const double &theta1, const int &nAngles, const double &Exmax, const int &nExs)
+{
+    if (nAngles < 1 || nExs < 1)
+        return false;
+    if (pA->GetA() + pX->GetA() != pY->GetA() + pB->GetA() || pA->GetZ() + pX->GetZ() != pY->GetZ() + pB->GetZ()){
+        std::cerr << "Particles of the kinematics map do not match" << std::endl;
+        return false;
+    }
+    Clear();
+    const Particle *p[4] = {pA, pX, pY, pB};
+    for (int i = 0 ; i < 4 ; ++i){
+        particles[2*i] = p[i]->GetA();
+        particles[2*i + 1] = p[i]->GetZ();
+    }
+    E = Ebeam;
+    thetaMin = theta0;
+    thetaMax = theta1;
+    ExMax = Exmax;
+    nTheta = nAngles;
+    nEx = nExs;
+    storage.resize(size_t(nTheta)*nEx*NVALUES);
+
+    RelScatter scat(pA, pX, pY, pB);
+    std::vector<double> ex(nEx);
+    for (int j = 0 ; j < nEx ; ++j)
+        ex[j] = GetEx(j);
+
+    // Each thread takes the next angle not yet done. The energies of Y
+    // for all excitation energies are found in one sweep.
+    unsigned nthreads = std::thread::hardware_concurrency();
+    if (nthreads == 0)
+        nthreads = 1;
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0 ; t < nthreads && int(t) < nTheta ; ++t){
+        threads.push_back(std::thread([this, &scat, &ex, &next](){
+            std::vector<double> EY(nEx);
+            for (int i = next++ ; i < nTheta ; i = next++){
+                double theta = GetTheta(i);
+                scat.Prepare(E, theta)(ex.data(), EY.data(), nEx);
+                float *row = storage.data() + size_t(i)*nEx*NVALUES;
+                for (int j = 0 ; j < nEx ; ++j){
+                    const double nan = std::numeric_limits<double>::quiet_NaN();
+                    double Ex, EB = nan, thetaB = nan;
+                    if (EY[j] > 0)
+                        EB = scat.EvaluateB(E, EY[j], theta, Ex, thetaB);
+                    else
+                        EY[j] = nan;
+                    row[j*NVALUES] = float(EY[j]);
+                    row[j*NVALUES + 1] = float(EB);
+                    row[j*NVALUES + 2] = float(thetaB);
+                }
+            }
+        }));
+    }
+    for (auto &thread : threads)
+        thread.join();
+    values = storage.data();
+    return true;
+}
+
+bool KinematicsMap::Evaluate(const double &theta, const double &Ex, double &EY, double &EB, double &thetaB) const
+{
+    if (!values)
+        return false;
+    double x = (nTheta > 1) ? (theta - thetaMin)*(nTheta - 1)/(thetaMax - thetaMin) : 0;
+    double y = (nEx > 1) ? Ex*(nEx - 1)/ExMax : 0;
+    if (!(x >= 0 && x <= nTheta - 1) || !(y >= 0 && y <= nEx - 1))
+        return false;
+
+    // The last cell also holds its upper edge.
+    int i = std::min(int(x), std::max(nTheta - 2, 0));
+    int j = std::min(int(y), std::max(nEx - 2, 0));
+    double fx = x - i, fy = y - j;
+    int i1 = std::min(i + 1, nTheta - 1), j1 = std::min(j + 1, nEx - 1);
+    double v[NVALUES];
+    for (int k = 0 ; k < NVALUES ; ++k){
+        v[k] = (1 - fx)*((1 - fy)*GetValue(i, j, k) + fy*GetValue(i, j1, k))
+                + fx*((1 - fy)*GetValue(i1, j, k) + fy*GetValue(i1, j1, k));
+    }
+    EY = v[0];
+    EB = v[1];
+    thetaB = v[2];
+    return std::isfinite(EY + EB + thetaB);
+}
+
+bool KinematicsMap::Write(const std::string &file) const
+{
+    std::ofstream output(file.c_str(), std::ios::binary);
+    if (!output){
+        std::cerr << "Unable to open kinematics map '" << file << "'" << std::endl;
+        return false;
+    }
+    uint32_t grid[2] = {uint32_t(nTheta), uint32_t(nEx)};
+    double limits[4] = {E, thetaMin, thetaMax, ExMax};
+    output.write(MAGIC, sizeof(MAGIC));
+    output.write(reinterpret_cast<const char *>(particles), sizeof(particles));
+    output.write(reinterpret_cast<const char *>(grid), sizeof(grid));
+    output.write(reinterpret_cast<const char *>(limits), sizeof(limits));
+    if (values)
+        output.write(reinterpret_cast<const char *>(values), size_t(nTheta)*nEx*NVALUES*sizeof(float));
+    return bool(output);
+}
+
+bool KinematicsMap::Read(const std::string &file)
+{
+    Clear();
+    const char *begin = nullptr;
+    size_t size = 0;
+
+#ifdef KINEMATICSMAP_USE_MMAP
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0){
+        std::cerr << "Unable to open kinematics map '" << file << "'" << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0){
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED){
+            mapped = data;
+            mappedSize = size_t(st.st_size);
+            begin = static_cast<const char *>(data);
+            size = mappedSize;
+        }
+    }
+    close(fd);
+#else
+    std::ifstream input(file.c_str(), std::ios::binary);
+    if (!input){
+        std::cerr << "Unable to open kinematics map '" << file << "'" << std::endl;
+        return false;
+    }
+    std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    begin = content.data();
+    size = content.size();
+#endif // KINEMATICSMAP_USE_MMAP
+
+    uint32_t grid[2] = {0, 0};
+    double limits[4];
+    if (begin && size >= HEADER && memcmp(begin, MAGIC, sizeof(MAGIC)) == 0){
+        const char *p = begin + sizeof(MAGIC);
+        memcpy(particles, p, sizeof(particles));
+        p += sizeof(particles);
+        memcpy(grid, p, sizeof(grid));
+        p += sizeof(grid);
+        memcpy(limits, p, sizeof(limits));
+    }
+    if (grid[0] < 1 || grid[1] < 1 || size != HEADER + size_t(grid[0])*grid[1]*NVALUES*sizeof(float)){
+        std::cerr << "'" << file << "' is not a kinematics map" << std::endl;
+        Clear();
+        return false;
+    }
+    E = limits[0];
+    thetaMin = limits[1];
+    thetaMax = limits[2];
+    ExMax = limits[3];
+    nTheta = int(grid[0]);
+    nEx = int(grid[1]);
+
+#ifdef KINEMATICSMAP_USE_MMAP
+    values = reinterpret_cast<const float *>(begin + HEADER);
+#else
+    storage.resize(size_t(nTheta)*nEx*NVALUES);
+    memcpy(storage.data(), begin + HEADER, storage.size()*sizeof(float));
+    values = storage.data();
+#endif // KINEMATICSMAP_USE_MMAP
+    return true;
+}
@@ -0,0 +1,46 @@
+#include "PunchThrough.h"
+
+#include "RangeTable.h"
+
+PunchThrough::PunchThrough(const RangeTable *dE, const double &_wDE, const RangeTable *E, const double &_wE)
+    : tDE( dE )
+    , tE( E )
+    , wDE( _wDE )
+    , wE( _wE )
+{
+}
+
+double PunchThrough::StopDE() const
+{
+    return tDE->Gain(0, wDE);
+}
+
+double PunchThrough::Punch(const double &Eres) const
+{
+    return tDE->Gain(tE->Gain(Eres, wE), wDE);
+}
+
+double PunchThrough::Lower(const double &Emin) const
+{
+    return tDE->Gain(Emin, wDE);
+}
+
+double PunchThrough::Upper(const double &Emin) const
+{
+    // Above the punch-through energy the deposit in the thick detector
+    // falls with energy, so bisect on that branch for deposit = Emin.
+    double lo = tE->Gain(0, wE);
+    double hi = tE->GetEmax();
+    if (lo <= Emin)
+        return 0;
+    if (hi - tE->Loss(hi, wE) >= Emin)
+        return tDE->Gain(hi, wDE);
+    for (int i = 0 ; i < 100 && hi - lo > 1e-12*hi ; ++i){
+        double x = 0.5*(lo + hi);
+        if (x - tE->Loss(x, wE) >= Emin)
+            lo = x;
+        else
+            hi = x;
+    }
+    return tDE->Gain(lo, wDE);
+}
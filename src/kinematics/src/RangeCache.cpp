@@ -0,0 +1,270 @@
+#include "RangeCache.h"
+
+#include "Material.h"
+#include "Particle.h"
+#include "RangeTable.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RANGECACHE_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // __unix__ || __APPLE__
+
+namespace {
+
+const char MAGIC[8] = {'Q', 'K', 'R', 'A', 'N', 'G', 'E', '1'};
+
+std::mutex cache_mutex;
+std::string directory;
+std::map<std::string, std::shared_ptr<RangeTable>> cache;
+
+template<typename T>
+void append(std::string &key, const T &value)
+{
+    key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// Everything the table depends on, as raw bytes.
+std::string make_key(const StoppingModel::Model_t &model, const StoppingModel::Precision_t &precision,
+                     const Particle *particle, const Material *material, const double &Emin, const double &Emax)
+{
+    std::string key;
+    append(key, RangeCache::VERSION);
+    append(key, int32_t(model));
+    // Only added when fast, so exact tables made before are still found.
+    if (precision != StoppingModel::Exact)
+        append(key, int32_t(precision));
+    append(key, int32_t(particle->GetZ()));
+    append(key, int32_t(particle->GetA()));
+    append(key, particle->GetM_AMU());
+    append(key, particle->Getlfctr());
+    append(key, int32_t(material->GetZ()));
+    append(key, int32_t(material->GetA()));
+    append(key, material->GetM_AMU());
+    append(key, material->Getrho());
+    append(key, material->Getatrho());
+    append(key, material->Getvfermi());
+    append(key, material->GetMeanEx());
+    for (int i = 0 ; i < 9 ; ++i)
+        append(key, material->Getpcoef(i));
+    append(key, Emin);
+    append(key, Emax);
+    return key;
+}
+
+// 64 bit FNV-1a hash of the key, as hex.
+std::string hash_key(const std::string &key)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (const char &c : key){
+        h ^= uint8_t(c);
+        h *= 1099511628211ULL;
+    }
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(h));
+    return std::string(name);
+}
+
+// Parses a table file. The layout is the magic, the size of the key, the
+// number of points, the key, Emin, Emax, Rmin, ln(E) and ln(R).
+std::shared_ptr<RangeTable> parse(const char *begin, const char *end, const std::string &key)
+{
+    const char *p = begin;
+    uint32_t keySize, points;
+    if (size_t(end - p) < sizeof(MAGIC) + 2*sizeof(uint32_t) || memcmp(p, MAGIC, sizeof(MAGIC)) != 0)
+        return nullptr;
+    p += sizeof(MAGIC);
+    memcpy(&keySize, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    memcpy(&points, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    if (keySize != key.size() || points < 2 || size_t(end - p) != keySize + (3 + 2*size_t(points))*sizeof(double))
+        return nullptr;
+    if (memcmp(p, key.data(), keySize) != 0)
+        return nullptr;
+    p += keySize;
+
+    double limits[3];
+    memcpy(limits, p, sizeof(limits));
+    p += sizeof(limits);
+    std::vector<double> u(points), r(points);
+    memcpy(u.data(), p, points*sizeof(double));
+    p += points*sizeof(double);
+    memcpy(r.data(), p, points*sizeof(double));
+    return std::make_shared<RangeTable>(limits[0], limits[1], limits[2], u, r);
+}
+
+} // namespace
+
+void RangeCache::SetDirectory(const std::string &dir)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    directory = dir;
+}
+
+std::string RangeCache::GetDirectory()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return directory;
+}
+
+std::shared_ptr<RangeTable> RangeCache::Get(const StoppingModel::Model_t &model, const StoppingModel::Precision_t &precision,
+                                            const Particle *particle, const Material *material, const double &Emin, const double &Emax, const std::function<std::shared_ptr<RangeTable>()> &make)
+{
+    std::string dir = GetDirectory();
+    if (dir.empty())
+        return make();
+
+    std::string key = make_key(model, precision, particle, material, Emin, Emax);
+    std::string name = hash_key(key);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end())
+            return it->second;
+    }
+
+    std::string path = (std::filesystem::path(dir) / (name + ".rng")).string();
+    std::shared_ptr<RangeTable> table = Read(path, key);
+    if (!table){
+        table = make();
+        if (table && Write(path, key, table.get()))
+            Prune();
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache[key] = table;
+    return table;
+}
+
+void RangeCache::ClearCache()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache.clear();
+}
+
+void RangeCache::Prune(const uintmax_t &maxSize)
+{
+    std::string dir = GetDirectory();
+    if (dir.empty())
+        return;
+
+    // Files that vanish while looking, e.g. pruned by another session, are skipped.
+    std::error_code ec;
+    std::vector<std::tuple<std::filesystem::file_time_type, uintmax_t, std::filesystem::path> > files;
+    uintmax_t total = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(dir, ec)){
+        if (entry.path().extension() != ".rng")
+            continue;
+        uintmax_t size = entry.file_size(ec);
+        std::filesystem::file_time_type time = (ec) ? std::filesystem::file_time_type() : entry.last_write_time(ec);
+        if (ec)
+            continue;
+        files.emplace_back(time, size, entry.path());
+        total += size;
+    }
+
+    std::sort(files.begin(), files.end());
+    for (const auto &[time, size, path] : files){
+        if (total <= maxSize)
+            break;
+        if (std::filesystem::remove(path, ec))
+            total -= size;
+    }
+}
+
+std::shared_ptr<RangeTable> RangeCache::Read(const std::string &path, const std::string &key)
+{
+    std::shared_ptr<RangeTable> table;
+
+#ifdef RANGECACHE_USE_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0){
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED){
+            const char *begin = static_cast<const char *>(data);
+            table = parse(begin, begin + st.st_size, key);
+            munmap(data, st.st_size);
+        } else {
+            std::cerr << "Unable to map range table '" << path << "': " << strerror(errno) << std::endl;
+        }
+    }
+    close(fd);
+#else
+    std::ifstream input(path.c_str(), std::ios::binary);
+    if (!input)
+        return nullptr;
+    std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (!input.bad())
+        table = parse(content.data(), content.data() + content.size(), key);
+#endif // RANGECACHE_USE_MMAP
+
+    if (!table){
+        std::cerr << "Ignoring range table '" << path << "' that does not match" << std::endl;
+        return nullptr;
+    }
+
+    // Marks the table as used, see Prune.
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return table;
+}
+
+bool RangeCache::Write(const std::string &path, const std::string &key, const RangeTable *table)
+{
+    std::error_code ec;
+    std::filesystem::path target(path);
+    std::filesystem::create_directories(target.parent_path(), ec);
+    if (ec){
+        std::cerr << "Unable to create range table directory '" << target.parent_path().string() << "': " << ec.message() << std::endl;
+        return false;
+    }
+
+    // Write next to the target and rename, so other sessions never see half a table.
+    std::string tmp = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    const std::vector<double> &u = table->GetGrid().first;
+    const std::vector<double> &r = table->GetGrid().second;
+    uint32_t keySize = uint32_t(key.size()), points = uint32_t(u.size());
+    double limits[3] = {table->GetEmin(), table->GetEmax(), table->GetRmin()};
+    {
+        std::ofstream output(tmp.c_str(), std::ios::binary | std::ios::trunc);
+        output.write(MAGIC, sizeof(MAGIC));
+        output.write(reinterpret_cast<const char *>(&keySize), sizeof(uint32_t));
+        output.write(reinterpret_cast<const char *>(&points), sizeof(uint32_t));
+        output.write(key.data(), key.size());
+        output.write(reinterpret_cast<const char *>(limits), sizeof(limits));
+        output.write(reinterpret_cast<const char *>(u.data()), points*sizeof(double));
+        output.write(reinterpret_cast<const char *>(r.data()), points*sizeof(double));
+        if (!output){
+            std::cerr << "Unable to write range table '" << tmp << "'" << std::endl;
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec){
+        std::cerr << "Unable to write range table '" << path << "': " << ec.message() << std::endl;
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,102 @@
+#include "RangeTable.h"
+
+#include "Profiler.h"
+
+#include <cmath>
+
+RangeTable::RangeTable(const std::function<double(const double &)> &stopping, const double &emin, const double &emax, const int &points)
+    : Emin( emin )
+    , Emax( emax )
+{
+    // Integrate dR = E/S(E) dlnE with Simpson's rule on each interval.
+    // Below Emin the stopping power is taken to go as sqrt(E), giving
+    // R(Emin) = 2*Emin/S(Emin).
+    u.resize(points);
+    r.resize(points);
+    double du = log(Emax/Emin)/double(points - 1);
+    auto f = [&stopping](const double &lnE){ double e = exp(lnE); return e/stopping(e); };
+
+    u[0] = log(Emin);
+    Rmin = 2*Emin/stopping(Emin);
+    double R = Rmin;
+    double f0 = f(u[0]), f1;
+    r[0] = log(R);
+    for (int i = 1 ; i < points ; ++i){
+        u[i] = u[0] + i*du;
+        f1 = f(u[i]);
+        R += du*(f0 + 4*f(u[i] - 0.5*du) + f1)/6.;
+        r[i] = log(R);
+        f0 = f1;
+    }
+    Profiler::Count(Profiler::Evaluations, 2*points - 1);
+    lnR.set_points(u, r);
+    lnE.set_points(r, u);
+}
+
+RangeTable::RangeTable(const double &emin, const double &emax, const double &rmin, const std::vector<double> &lnEgrid, const std::vector<double> &lnRgrid)
+    : Emin( emin )
+    , Emax( emax )
+    , Rmin( rmin )
+    , u( lnEgrid )
+    , r( lnRgrid )
+{
+    lnR.set_points(u, r);
+    lnE.set_points(r, u);
+}
+
+double RangeTable::Range(const double &E) const
+{
+    if (E <= Emin)
+        return Rmin*sqrt(E/Emin);
+    return exp(lnR(log(E)));
+}
+
+double RangeTable::Energy(const double &R) const
+{
+    if (R <= Rmin)
+        return 0;
+    // The two splines are not exact inverses between the grid points, so
+    // one Newton step on ln(R)(ln(E)) makes Loss and Gain exact inverses.
+    double lr = log(R);
+    double x = lnE(lr);
+    double slope = lnR.deriv(1, x);
+    if (slope > 0)
+        x -= (lnR(x) - lr)/slope;
+    return exp(x);
+}
+
+double RangeTable::Loss(const double &E, const double &width) const
+{
+    if (E <= 0)
+        return 0;
+    return Energy(Range(E) - width);
+}
+
+double RangeTable::Gain(const double &E, const double &width) const
+{
+    return Energy(Range((E > 0) ? E : 0) + width);
+}
+
+void RangeTable::Loss(const double *E, const double *width, double *Eout, const size_t &n) const
+{
+    for (size_t i = 0 ; i < n ; ++i)
+        Eout[i] = std::isnan(E[i]) ? E[i] : Loss(E[i], width[i]);
+}
+
+void RangeTable::Loss(const double *E, const double &width, double *Eout, const size_t &n) const
+{
+    for (size_t i = 0 ; i < n ; ++i)
+        Eout[i] = std::isnan(E[i]) ? E[i] : Loss(E[i], width);
+}
+
+void RangeTable::Gain(const double *E, const double *width, double *Eout, const size_t &n) const
+{
+    for (size_t i = 0 ; i < n ; ++i)
+        Eout[i] = std::isnan(E[i]) ? E[i] : Gain(E[i], width[i]);
+}
+
+void RangeTable::Gain(const double *E, const double &width, double *Eout, const size_t &n) const
+{
+    for (size_t i = 0 ; i < n ; ++i)
+        Eout[i] = std::isnan(E[i]) ? E[i] : Gain(E[i], width);
+}
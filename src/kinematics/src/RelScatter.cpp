@@ -13,46 +13,76 @@ RelScatter::RelScatter(Particle *pA, Particle *pX, Particle *pY, Particle *pB)
 
 RelScatter::~RelScatter(){ }
 
-double RelScatter::EvaluateY(const double &E, const double &theta, const double &Ex) const
+template<typename T>
+T RelScatter::EvaluateYT(const T &E, const T &theta, const T &Ex) const
 {
     double m1 = X->GetM_MeV(), m2 = A->GetM_MeV(), m3 = Y->GetM_MeV(), m4 = B->GetM_MeV();
 
-    double m4ex = m4 + Ex;
+    T m4ex = m4 + Ex;
 
-    double s = (m1+m2)*(m1+m2) + 2*m1*E;
+    T s = (m1+m2)*(m1+m2) + 2*m1*E;
 
-    double pcm = sqrt(((s - m1*m1 - m2*m2)*(s - m1*m1 - m2*m2) - 4*m1*m1*m2*m2)/(4*s));
+    T pcm = sqrt(((s - m1*m1 - m2*m2)*(s - m1*m1 - m2*m2) - 4*m1*m1*m2*m2)/(4*s));
 
-    double chi = log((pcm + sqrt(pcm*pcm + m1*m1))/m1);
+    T chi = log((pcm + sqrt(pcm*pcm + m1*m1))/m1);
 
-    double pcm2 = sqrt(((s - m3*m3 - m4ex*m4ex)*(s - m3*m3 - m4ex*m4ex) - 4*m3*m3*m4ex*m4ex)/(4*s));
+    T pcm2 = sqrt(((s - m3*m3 - m4ex*m4ex)*(s - m3*m3 - m4ex*m4ex) - 4*m3*m3*m4ex*m4ex)/(4*s));
 
-    double p3 = sqrt(pcm2*pcm2 + m3*m3)*cos(theta)*sinh(chi)+sqrt(pcm2*pcm2 - pow(m3*sin(theta)*sinh(chi),2))*cosh(chi);
+    T p3 = sqrt(pcm2*pcm2 + m3*m3)*cos(theta)*sinh(chi)+sqrt(pcm2*pcm2 - pow(m3*sin(theta)*sinh(chi),2))*cosh(chi);
     p3 /= 1 + sin(theta)*sin(theta)*sinh(chi)*sinh(chi);
 
-    double E3 = sqrt(p3*p3 + m3*m3);
+    T E3 = sqrt(p3*p3 + m3*m3);
     return E3 - m3;
 }
 
-adouble RelScatter::EvaluateY(double E, double theta, adouble Ex)
+double RelScatter::EvaluateY(const double &E, const double &theta, const double &Ex) const
 {
-    double m1 = X->GetM_MeV(), m2 = A->GetM_MeV(), m3 = Y->GetM_MeV(), m4 = B->GetM_MeV();
+    return EvaluateYT(E, theta, Ex);
+}
 
-    adouble m4ex = m4 + Ex;
+Dual RelScatter::EvaluateY(const Dual &E, const Dual &theta, const Dual &Ex) const
+{
+    return EvaluateYT(E, theta, Ex);
+}
 
-    double s = (m1+m2)*(m1+m2) + 2*m1*E;
+void RelScatter::EvaluateY(const double &E, const double &theta, const double *Ex, double *EY, const int &n) const
+{
+    Prepare(E, theta)(Ex, EY, n);
+}
 
-    double pcm = sqrt(((s - m1*m1 - m2*m2)*(s - m1*m1 - m2*m2) - 4*m1*m1*m2*m2)/(4*s));
+adouble RelScatter::EvaluateY(double E, double theta, adouble Ex)
+{
+    adouble EY(Ex.size());
+    if (Ex.size() > 0)
+        Prepare(E, theta)(&Ex[0], &EY[0], int(Ex.size()));
+    return EY;
+}
 
-    double chi = log((pcm + sqrt(pcm*pcm + m1*m1))/m1);
+RelScatter::Prepared RelScatter::Prepare(const double &E, const double &theta) const
+{
+    double m1 = X->GetM_MeV(), m2 = A->GetM_MeV();
 
-    adouble pcm2 = sqrt(((s - m3*m3 - m4ex*m4ex)*(s - m3*m3 - m4ex*m4ex) - 4*m3*m3*m4ex*m4ex)/(4*s));
+    Prepared kin;
+    kin.m3 = Y->GetM_MeV();
+    kin.m4 = B->GetM_MeV();
+    kin.s = (m1+m2)*(m1+m2) + 2*m1*E;
+    kin.inv4s = 1/(4*kin.s);
 
-    adouble p3 = sqrt(pcm2*pcm2 + m3*m3)*cos(theta)*sinh(chi)+sqrt(pcm2*pcm2 - pow(m3*sin(theta)*sinh(chi),2))*cosh(chi);
-    p3 /= 1 + sin(theta)*sin(theta)*sinh(chi)*sinh(chi);
+    double pcm = sqrt(((kin.s - m1*m1 - m2*m2)*(kin.s - m1*m1 - m2*m2) - 4*m1*m1*m2*m2)*kin.inv4s);
+    double chi = log((pcm + sqrt(pcm*pcm + m1*m1))/m1);
+    double sh = sinh(chi), sn = sin(theta);
 
-    adouble E3 = sqrt(p3*p3 + m3*m3);
-    return E3 - m3;
+    kin.a = cos(theta)*sh;
+    kin.b = pow(kin.m3*sn*sh, 2);
+    kin.c = cosh(chi);
+    kin.d = 1/(1 + sn*sn*sh*sh);
+    return kin;
+}
+
+void RelScatter::Prepared::operator()(const double *Ex, double *EY, const int &n) const
+{
+    for (int i = 0 ; i < n ; ++i)
+        EY[i] = (*this)(Ex[i]);
 }
 
 double RelScatter::FindMaxEx(const double &E, const double &theta) const
@@ -26,6 +26,12 @@ Scattering::Scattering(Particle *pA, Particle *pX, Particle *pY, Particle *pB)
 
 Scattering::~Scattering(){ }
 
+void Scattering::EvaluateY(const double &E, const double &theta, const double *Ex, double *EY, const int &n) const
+{
+    for (int i = 0 ; i < n ; ++i)
+        EY[i] = EvaluateY(E, theta, Ex[i]);
+}
+
 double Scattering::EvaluateB(const double &EA, const double &EY, const double &thetaY, double &Ex, double &thetaB) const
 {
     double m1 = A->GetM_MeV(), m2 = X->GetM_MeV(), m3 = Y->GetM_MeV(), m4 = B->GetM_MeV();
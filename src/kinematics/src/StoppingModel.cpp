@@ -0,0 +1,120 @@
+#include "StoppingModel.h"
+
+#include "Particle.h"
+#include "RangeCache.h"
+#include "RangeTable.h"
+#include "Ziegler1985.h"
+#include "BetheBlock.h"
+#include "ZieglerBethe.h"
+
+#include <atomic>
+#include <cmath>
+
+static const char *modelNames[StoppingModel::NumModels] = {
+    "Ziegler1985", "BetheBlock", "ZieglerBethe"
+};
+
+static std::atomic<StoppingModel::Precision_t> defaultPrecision(StoppingModel::Exact);
+
+void StoppingModel::SetPrecision(const Precision_t &prec)
+{
+    defaultPrecision = prec;
+}
+
+StoppingModel::Precision_t StoppingModel::GetPrecision()
+{
+    return defaultPrecision;
+}
+
+StoppingModel::Model_t StoppingModel::Choose(const Particle *particle, const Material *material, const double &Emax)
+{
+    if (material->GetZ() > 92 || particle->GetZ() > 92)
+        return Bethe;
+    if (Emax > ZieglerBethe::STITCH*particle->GetM_AMU())
+        return Stitched;
+    return Ziegler;
+}
+
+Material::Unit StoppingModel::Unit(const Model_t &model)
+{
+    return (model == Bethe) ? Material::gcm2 : Material::um;
+}
+
+const char *StoppingModel::Name(const Model_t &model)
+{
+    return modelNames[model];
+}
+
+StoppingPower *StoppingModel::Make(const Material *material, const Particle *particle, const double &Emax, Material::Unit &unit,
+                                   const Precision_t &precision)
+{
+    Model_t model = Choose(particle, material, Emax);
+    bool fast = (precision == Fast);
+    unit = Unit(model);
+    switch (model){
+    case Bethe :
+        return new BetheBlock(material, particle);
+    case Stitched :
+        return new ZieglerBethe(material, particle, fast);
+    default :
+        return new Ziegler1985(material, particle, fast);
+    }
+}
+
+double StoppingModel::TableEmax(const Model_t &model, const Particle *particle, const double &Emax)
+{
+    if (model == Ziegler)
+        return ZieglerBethe::STITCH*particle->GetM_AMU();
+    double top = BETHE_EMAX*particle->GetA();
+    return (Emax > top) ? top*exp2(ceil(log2(Emax/top))) : top;
+}
+
+std::shared_ptr<RangeTable> StoppingModel::MakeTable(const Particle *particle, const Material *material, const double &Emax, double &width,
+                                                     const Precision_t &precision)
+{
+    Model_t model = Choose(particle, material, 2*Emax);
+    width = material->GetWidth(Unit(model));
+    double Emin = (model == Bethe) ? 0.1 : 1e-3;
+    double Etop = TableEmax(model, particle, 2*Emax);
+    Precision_t prec = (model == Bethe) ? Exact : precision;
+    bool fast = (prec == Fast);
+    return RangeCache::Get(model, prec, particle, material, Emin, Etop, [&]() -> std::shared_ptr<RangeTable> {
+        switch (model){
+        case Bethe : {
+            BetheBlock stop(material, particle);
+            return std::make_shared<RangeTable>([&stop](const double &E){ return stop.Stopping(E); }, Emin, Etop);
+        }
+        case Stitched : {
+            ZieglerBethe stop(material, particle, fast);
+            return std::make_shared<RangeTable>([&stop](const double &E){ return stop.Stopping(E); }, Emin, Etop);
+        }
+        default : {
+            Ziegler1985 stop(material, particle, fast);
+            return std::make_shared<RangeTable>([&stop](const double &E){ return stop.Stopping(E); }, Emin, Etop);
+        }
+        }
+    });
+}
+
+std::shared_ptr<RangeTable> StoppingModel::Table(const StoppingPower *stop)
+{
+    Model_t model;
+    Precision_t prec = Exact;
+    if (const Ziegler1985 *z = dynamic_cast<const Ziegler1985 *>(stop)){
+        model = Ziegler;
+        prec = (z->IsFast()) ? Fast : Exact;
+    } else if (const ZieglerBethe *zb = dynamic_cast<const ZieglerBethe *>(stop)){
+        model = Stitched;
+        prec = (zb->IsFast()) ? Fast : Exact;
+    } else if (dynamic_cast<const BetheBlock *>(stop)){
+        model = Bethe;
+    } else {
+        return std::make_shared<RangeTable>([stop](const double &E){ return stop->Stopping(E); },
+                                            stop->GetEmin(), StoppingPower::TABLE_EMAX*stop->GetParticle().GetA());
+    }
+    double Emin = stop->GetEmin();
+    double Etop = TableEmax(model, &stop->GetParticle(), 0);
+    return RangeCache::Get(model, prec, &stop->GetParticle(), &stop->GetMaterial(), Emin, Etop, [&]() -> std::shared_ptr<RangeTable> {
+        return std::make_shared<RangeTable>([stop](const double &E){ return stop->Stopping(E); }, Emin, Etop);
+    });
+}
@@ -2,20 +2,70 @@
 
 #include "Material.h"
 #include "Particle.h"
+#include "StoppingModel.h"
 
 
-StoppingPower::StoppingPower(Material *material, Particle *particle)
+StoppingPower::StoppingPower()
     : AbstractFunction()
-    , pMaterial( material )
-	, pParticle( particle ){ }
+    , cache( std::make_shared<TableCache_t>() ){ }
 
+StoppingPower::StoppingPower(const Material *_material, const Particle *_particle)
+    : AbstractFunction()
+    , material( *_material )
+	, particle( *_particle )
+    , cache( std::make_shared<TableCache_t>() ){ }
+
+Dual StoppingPower::Loss(const Dual &E, const Dual &width, const int &points) const
+{
+    Dual e = Loss(E.value(), width.value(), points);
+    if (e.value() <= 0)
+        return 0;
+    double s0 = Evaluate(E.value());
+    double s1 = Evaluate(e.value());
+    for (int i = 0 ; i < Dual::size() ; ++i)
+        e.setDeriv(i, s1/s0*E.deriv(i) + s1*width.deriv(i));
+    return e;
+}
+
+double StoppingPower::Stopping(const double &E) const
+{
+    return -Evaluate(E);
+}
+
+std::shared_ptr<const RangeTable> StoppingPower::GetTable() const
+{
+    std::call_once(cache->made, [this](){
+        cache->table = StoppingModel::Table(this);
+    });
+    return cache->table;
+}
+
+double StoppingPower::Gain(const double &E) const
+{
+    return Gain(E, material.GetWidth(GetUnit()));
+}
+
+double StoppingPower::Gain(const double &E, const double &width) const
+{
+    return GetTable()->Gain(E, width);
+}
+
+void StoppingPower::Loss(const double *E, const double *width, double *Eout, const size_t &n) const
+{
+    GetTable()->Loss(E, width, Eout, n);
+}
+
+void StoppingPower::Loss(const double *E, const double &width, double *Eout, const size_t &n) const
+{
+    GetTable()->Loss(E, width, Eout, n);
+}
 
-void StoppingPower::setMaterial(Material *material) 
+void StoppingPower::Gain(const double *E, const double *width, double *Eout, const size_t &n) const
 {
-    pMaterial = material;
+    GetTable()->Gain(E, width, Eout, n);
 }
 
-void StoppingPower::setParticle(Particle *particle) 
+void StoppingPower::Gain(const double *E, const double &width, double *Eout, const size_t &n) const
 {
-    pParticle= particle;
+    GetTable()->Gain(E, width, Eout, n);
 }
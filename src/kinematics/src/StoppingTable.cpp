@@ -0,0 +1,199 @@
+#include "StoppingTable.h"
+
+#include <charconv>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define STOPPINGTABLE_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // __unix__ || __APPLE__
+
+namespace {
+
+struct CacheEntry {
+    std::filesystem::file_time_type mtime;
+    std::shared_ptr<const StoppingTable> table;
+};
+
+std::mutex cache_mutex;
+std::map<std::pair<std::string, int>, CacheEntry> cache;
+
+inline bool is_blank(const char &c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+// Returns the factor converting an energy unit to MeV, or 0 if unknown.
+double energy_unit(const char *begin, const char *end)
+{
+    std::string unit(begin, end);
+    if (unit == "eV")
+        return 1e-6;
+    else if (unit == "keV")
+        return 1e-3;
+    else if (unit == "MeV")
+        return 1;
+    else if (unit == "GeV")
+        return 1e3;
+    return 0;
+}
+
+} // namespace
+
+std::shared_ptr<const StoppingTable> StoppingTable::Load(const std::string &path, const int &columns)
+{
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec){
+        std::cerr << "Unable to open stopping power table '" << path << "': " << ec.message() << std::endl;
+        return nullptr;
+    }
+
+    auto key = std::make_pair(path, columns);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end() && it->second.mtime == mtime)
+            return it->second.table;
+    }
+
+    std::shared_ptr<StoppingTable> table(new StoppingTable);
+    bool ok = false;
+
+#ifdef STOPPINGTABLE_USE_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0){
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED){
+            const char *begin = static_cast<const char *>(data);
+            ok = table->Parse(begin, begin + st.st_size, columns, path);
+            munmap(data, st.st_size);
+        } else {
+            std::cerr << "Unable to map stopping power table '" << path << "': " << strerror(errno) << std::endl;
+        }
+    } else {
+        std::cerr << "Unable to read stopping power table '" << path << "'" << std::endl;
+    }
+    if (fd >= 0)
+        close(fd);
+#else
+    std::ifstream input(path.c_str(), std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (input.bad() || content.empty()){
+        std::cerr << "Unable to read stopping power table '" << path << "'" << std::endl;
+    } else {
+        ok = table->Parse(content.data(), content.data() + content.size(), columns, path);
+    }
+#endif // STOPPINGTABLE_USE_MMAP
+
+    if (!ok)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache[key] = {mtime, table};
+    return table;
+}
+
+void StoppingTable::ClearCache()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache.clear();
+}
+
+bool StoppingTable::Parse(const char *begin, const char *end, const int &columns, const std::string &path)
+{
+    energy.clear();
+    stopping.clear();
+
+    int line_no = 0;
+    const char *p = begin;
+    while (p < end){
+        const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (!eol)
+            eol = end;
+        ++line_no;
+
+        while (p < eol && is_blank(*p))
+            ++p;
+
+        double e, s=0, value;
+        auto res = std::from_chars(p, eol, e);
+        if (res.ec != std::errc()){
+            // Header, comment or empty line.
+            p = eol + 1;
+            continue;
+        }
+        p = res.ptr;
+
+        while (p < eol && is_blank(*p))
+            ++p;
+        const char *word = p;
+        while (p < eol && !is_blank(*p) && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')))
+            ++p;
+        const char *word_end = p;
+
+        int n = 0;
+        while (p < eol && (columns == 0 || n < columns)){
+            while (p < eol && is_blank(*p))
+                ++p;
+            res = std::from_chars(p, eol, value);
+            if (res.ec != std::errc())
+                break;
+            p = res.ptr;
+            s += value;
+            ++n;
+        }
+        if (n == 0){
+            // No stopping power, e.g. the table of units at the end of SRIM output.
+            p = eol + 1;
+            continue;
+        }
+        if (word_end != word){
+            double scale = energy_unit(word, word_end);
+            if (scale == 0){
+                std::cerr << path << ":" << line_no << ": unknown energy unit '" << std::string(word, word_end) << "'" << std::endl;
+                return false;
+            }
+            e *= scale;
+        }
+        if (columns > 0 && n < columns){
+            std::cerr << path << ":" << line_no << ": expected " << columns << " stopping power column(s)" << std::endl;
+            return false;
+        }
+        if (!std::isfinite(e) || e <= 0){
+            std::cerr << path << ":" << line_no << ": energy must be positive" << std::endl;
+            return false;
+        }
+        if (!std::isfinite(s) || s < 0){
+            std::cerr << path << ":" << line_no << ": stopping power must be finite and non-negative" << std::endl;
+            return false;
+        }
+        if (!energy.empty() && e <= energy.back()){
+            std::cerr << path << ":" << line_no << ": energies must be strictly increasing" << std::endl;
+            return false;
+        }
+        energy.push_back(e);
+        stopping.push_back(s);
+        p = eol + 1;
+    }
+
+    if (energy.size() < 2){
+        std::cerr << "Stopping power table '" << path << "' needs at least two points" << std::endl;
+        return false;
+    }
+
+    sp.set_points_resampled(energy, stopping);
+    return true;
+}
@@ -0,0 +1,95 @@
+#include "ZieglerBethe.h"
+
+#include "Material.h"
+#include "Particle.h"
+#include "Profiler.h"
+
+#include <cmath>
+
+ZieglerBethe::ZieglerBethe()
+    : StoppingPower()
+    , Estitch( 0 )
+    , scale( 0 ){ }
+
+ZieglerBethe::ZieglerBethe(const Material *material, const Particle *particle, const bool &fast)
+    : StoppingPower(material, particle)
+    , low(material, particle, fast)
+    , high(material, particle)
+    , Estitch( 1e3*STITCH*particle->GetM_AMU() )
+    , scale( 0 )
+{
+    // [MeV cm²/g] -> [keV/µm] is rho*1e-4*1e3, and the rest makes the parts meet.
+    double bethe = high.Evaluate(1e-3*Estitch)*material->Getrho()*1e-1;
+    double ziegler = low.Evaluate(Estitch);
+    scale = material->Getrho()*1e-1;
+    if (bethe < 0 && ziegler < 0)
+        scale *= ziegler/bethe;
+}
+
+template<typename T>
+T ZieglerBethe::EvaluateT(const T &E) const
+{
+    if (E < Estitch)
+        return low.Evaluate(E);
+    return high.Evaluate(1e-3*E)*scale;
+}
+
+double ZieglerBethe::Evaluate(const double &E) const
+{
+    return EvaluateT(E);
+}
+
+Dual ZieglerBethe::Evaluate(const Dual &E) const
+{
+    return EvaluateT(E);
+}
+
+template<typename T>
+T ZieglerBethe::LossT(const T &E, const T &d, const int &points) const
+{
+    T dx = d/points;
+    T e = E*1e3;
+    T R1, R2, R3, R4;
+    int i = 0;
+    for ( ; i < points ; ++i){
+        R1 = dx*Evaluate(e);
+        R2 = dx*Evaluate(e + 0.5*R1);
+        R3 = dx*Evaluate(e + 0.5*R2);
+        R4 = dx*Evaluate(e + R3);
+        e += (R1 + 2*(R2 + R3) + R4)/6.0;
+        if (e < 0 || e != e){
+            e = 0;
+            break;
+        }
+    }
+    Profiler::Steps(i);
+    return e/1e3;
+}
+
+double ZieglerBethe::Loss(const double &E, const int &points) const
+{
+    return LossT(E, material.GetWidth(Material::um), points);
+}
+
+double ZieglerBethe::Loss(const double &E, const double &d, const int &points) const
+{
+    return LossT(E, d, points);
+}
+
+Dual ZieglerBethe::Loss(const Dual &E, const Dual &d, const int &points) const
+{
+    return LossT(E, d, points);
+}
+
+adouble ZieglerBethe::Loss(adouble E, int points)
+{
+    return Loss(E, material.GetWidth(Material::um), points);
+}
+
+adouble ZieglerBethe::Loss(adouble E, double width, int points)
+{
+    adouble e(E.size());
+    for (size_t i = 0 ; i < E.size() ; ++i)
+        e[i] = LossT(E[i], width, points);
+    return e;
+}
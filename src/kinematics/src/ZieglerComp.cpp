@@ -13,7 +13,7 @@ ZieglerComp::ZieglerComp(Material *material, double *weight, const int &n, Parti
 	, density( dens )
 {
 	for (int i = 0 ; i < n_mat ; ++i){
-        Ziegler[i] = Ziegler1985(new Material(*(material + i)), new Particle(*projectile));
+        Ziegler[i] = Ziegler1985(material + i, projectile.get());
 		Weights[i] = weight[i];
 	}
 }
@@ -0,0 +1,25 @@
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+#include <cstddef>
+#include <vector>
+
+//! Pick the points of a curve worth drawing in a window.
+/*! The window [xmin, xmax] is split into columns, and consecutive points
+ *  falling in the same column are reduced to the first, the lowest, the
+ *  highest and the last of them. The drawn curve then looks the same as
+ *  the full one at the resolution of the columns, spikes included. The
+ *  points are taken in their order, so the curve need not be sorted in
+ *  x. The last point before and the first point after each visit to the
+ *  window are kept, so lines leave the window correctly.
+ *  \return the number of points kept.
+ */
+size_t Decimate(const double *x,            /*!< x-values.                              */
+                const double *y,            /*!< y-values.                              */
+                const size_t &n,            /*!< Number of points.                      */
+                const double &xmin,         /*!< Lower edge of the window.              */
+                const double &xmax,         /*!< Upper edge of the window.              */
+                const int &columns,         /*!< Number of columns, e.g. pixels.        */
+                std::vector<size_t> &keep   /*!< Set to the indices of the kept points. */);
+
+#endif // DECIMATE_H
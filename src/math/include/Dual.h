@@ -0,0 +1,179 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <cmath>
+
+//! Dual number for forward-mode automatic differentiation.
+/*! Holds a value and its partial derivatives with respect to N
+ *  parameters. All arithmetic propagates the derivatives by the chain
+ *  rule, so a function written for a generic scalar type returns the
+ *  value and its gradient in one evaluation. Comparisons only look at
+ *  the value.
+ */
+template<int N>
+class DualNumber
+{
+public:
+    //! Constructor. A constant with zero derivatives.
+    DualNumber(const double &value=0 /*!< Value. */)
+        : v( value )
+    {
+        for (int i = 0 ; i < N ; ++i)
+            d[i] = 0;
+    }
+
+    //! Make a parameter.
+    /*! \return a dual number with value and unit derivative in slot n.
+     */
+    static DualNumber Variable(const double &value,  /*!< Value.                         */
+                               const int &n          /*!< Index of the parameter, < N.   */)
+    {
+        DualNumber r(value);
+        r.d[n] = 1;
+        return r;
+    }
+
+    //! \return the value.
+    inline double value() const { return v; }
+
+    //! \return the derivative with respect to parameter n.
+    inline double deriv(const int &n) const { return d[n]; }
+
+    //! Set the derivative with respect to parameter n.
+    inline void setDeriv(const int &n, const double &dv) { d[n] = dv; }
+
+    //! Number of parameters.
+    static constexpr int size() { return N; }
+
+    DualNumber &operator+=(const DualNumber &x)
+    {
+        v += x.v;
+        for (int i = 0 ; i < N ; ++i)
+            d[i] += x.d[i];
+        return *this;
+    }
+
+    DualNumber &operator-=(const DualNumber &x)
+    {
+        v -= x.v;
+        for (int i = 0 ; i < N ; ++i)
+            d[i] -= x.d[i];
+        return *this;
+    }
+
+    DualNumber &operator*=(const DualNumber &x)
+    {
+        for (int i = 0 ; i < N ; ++i)
+            d[i] = d[i]*x.v + v*x.d[i];
+        v *= x.v;
+        return *this;
+    }
+
+    DualNumber &operator/=(const DualNumber &x)
+    {
+        double inv = 1/x.v;
+        v *= inv;
+        for (int i = 0 ; i < N ; ++i)
+            d[i] = (d[i] - v*x.d[i])*inv;
+        return *this;
+    }
+
+    DualNumber operator-() const
+    {
+        DualNumber r(-v);
+        for (int i = 0 ; i < N ; ++i)
+            r.d[i] = -d[i];
+        return r;
+    }
+
+    //! Apply a function with value f and derivative df at the value of x.
+    friend DualNumber chain(const DualNumber &x, const double &f, const double &df)
+    {
+        DualNumber r(f);
+        for (int i = 0 ; i < N ; ++i)
+            r.d[i] = df*x.d[i];
+        return r;
+    }
+
+    friend DualNumber operator+(DualNumber x, const DualNumber &y) { return x += y; }
+    friend DualNumber operator-(DualNumber x, const DualNumber &y) { return x -= y; }
+    friend DualNumber operator*(DualNumber x, const DualNumber &y) { return x *= y; }
+    friend DualNumber operator/(DualNumber x, const DualNumber &y) { return x /= y; }
+
+    friend bool operator<(const DualNumber &x, const DualNumber &y) { return x.v < y.v; }
+    friend bool operator>(const DualNumber &x, const DualNumber &y) { return x.v > y.v; }
+    friend bool operator<=(const DualNumber &x, const DualNumber &y) { return x.v <= y.v; }
+    friend bool operator>=(const DualNumber &x, const DualNumber &y) { return x.v >= y.v; }
+    friend bool operator==(const DualNumber &x, const DualNumber &y) { return x.v == y.v; }
+    friend bool operator!=(const DualNumber &x, const DualNumber &y) { return x.v != y.v; }
+
+private:
+    //! The value.
+    double v;
+
+    //! Partial derivatives.
+    double d[N];
+};
+
+template<int N> inline DualNumber<N> sqrt(const DualNumber<N> &x)
+{
+    double f = std::sqrt(x.value());
+    return chain(x, f, 0.5/f);
+}
+
+template<int N> inline DualNumber<N> exp(const DualNumber<N> &x)
+{
+    double f = std::exp(x.value());
+    return chain(x, f, f);
+}
+
+template<int N> inline DualNumber<N> log(const DualNumber<N> &x)
+{
+    return chain(x, std::log(x.value()), 1/x.value());
+}
+
+template<int N> inline DualNumber<N> log10(const DualNumber<N> &x)
+{
+    return chain(x, std::log10(x.value()), 1/(x.value()*std::log(10.)));
+}
+
+template<int N> inline DualNumber<N> pow(const DualNumber<N> &x, const double &p)
+{
+    double f = std::pow(x.value(), p - 1);
+    return chain(x, f*x.value(), p*f);
+}
+
+template<int N> inline DualNumber<N> sin(const DualNumber<N> &x)
+{
+    return chain(x, std::sin(x.value()), std::cos(x.value()));
+}
+
+template<int N> inline DualNumber<N> cos(const DualNumber<N> &x)
+{
+    return chain(x, std::cos(x.value()), -std::sin(x.value()));
+}
+
+template<int N> inline DualNumber<N> sinh(const DualNumber<N> &x)
+{
+    return chain(x, std::sinh(x.value()), std::cosh(x.value()));
+}
+
+template<int N> inline DualNumber<N> cosh(const DualNumber<N> &x)
+{
+    return chain(x, std::cosh(x.value()), std::sinh(x.value()));
+}
+
+template<int N> inline DualNumber<N> fabs(const DualNumber<N> &x)
+{
+    return (x.value() < 0) ? -x : x;
+}
+
+//! \return the value of a scalar, for code templated on the scalar type.
+inline double value_of(const double &x) { return x; }
+
+template<int N> inline double value_of(const DualNumber<N> &x) { return x.value(); }
+
+//! Dual number with room for all setup parameters of a calculation.
+typedef DualNumber<8> Dual;
+
+#endif // DUAL_H
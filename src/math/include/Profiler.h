@@ -0,0 +1,118 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+//! Class: Profiler
+/*! Collects the time spent in each stage of a calculation, together with
+ *  counters of the expensive operations. The totals are shared by the
+ *  whole program and updated atomically, so timers and counters may be
+ *  used from several threads. A calculation is profiled by taking the
+ *  difference of two reports, \ref Get before and after.
+ */
+class Profiler
+{
+public:
+    //! Stages of a calculation.
+    enum Stage_t {
+        Setup,          //! Particles, materials, stopping powers and range tables.
+        BeamLoss,       //! Energy loss of the beam in the fronting and target.
+        Kinematics,     //! Fragment energies from the reaction kinematics.
+        TargetLayer,    //! Energy loss of the fragment in the target.
+        FrontBackLayer, //! Energy loss of the fragment in the fronting or backing.
+        AbsorberLayer,  //! Energy loss of the fragment in the absorber.
+        Detectors,      //! Energy deposited in the thin and thick detectors.
+        Fitting,        //! Fits of the results.
+        Levels,         //! Look-up of known levels of the residual.
+        NumStages       //! Number of stages.
+    };
+
+    //! Counted operations.
+    enum Counter_t {
+        RK4Steps,       //! Runge-Kutta steps of energy loss integrations.
+        Evaluations,    //! Evaluations of stopping powers.
+        CacheHits,      //! Range tables taken from the cache.
+        CacheMisses,    //! Range tables that had to be made.
+        NumCounters     //! Number of counters.
+    };
+
+    //! Totals of all stages and counters.
+    struct Report_t {
+        double seconds[NumStages];      //! Time spent in each stage [s].
+        uint64_t calls[NumStages];      //! Number of times each stage was entered.
+        uint64_t counts[NumCounters];   //! Value of each counter.
+
+        //! \return the total time of all stages [s].
+        double Total() const;
+
+        //! \return the difference between two reports.
+        Report_t operator-(const Report_t &report) const;
+    };
+
+    //! Times a stage from construction until \ref Stop, or until it goes out of scope.
+    class Timer
+    {
+    public:
+        //! Constructor, starts the timer.
+        Timer(const Stage_t &stage /*!< Stage to add the time to. */)
+            : stage( stage )
+            , running( true )
+            , start( std::chrono::steady_clock::now() ){ }
+
+        //! Destructor, adds the elapsed time to the stage if not stopped.
+        ~Timer(){ Stop(); }
+
+        //! Add the elapsed time to the stage and stop the timer.
+        inline void Stop()
+        {
+            if (running)
+                Add(stage, std::chrono::steady_clock::now() - start);
+            running = false;
+        }
+
+    private:
+        Stage_t stage;
+        bool running;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    //! Increase a counter.
+    static void Count(const Counter_t &counter, /*!< The counter.   */
+                      const uint64_t &n=1       /*!< Increment.     */);
+
+    //! Count Runge-Kutta steps, each with four stopping power evaluations.
+    static inline void Steps(const uint64_t &n /*!< Number of steps. */)
+    {
+        Count(RK4Steps, n);
+        Count(Evaluations, 4*n);
+    }
+
+    //! \return the totals so far.
+    static Report_t Get();
+
+    //! Set all totals to zero.
+    static void Reset();
+
+    //! \return the name of a stage.
+    static const char *Name(const Stage_t &stage);
+
+    //! \return the name of a counter.
+    static const char *Name(const Counter_t &counter);
+
+    //! Write a report as "stage <name> <calls> <seconds>" and
+    //! "counter <name> <value>" lines, for other programs to read.
+    static void Write(std::ostream &out,        /*!< Where to write.        */
+                      const Report_t &report    /*!< The report.            */);
+
+    //! \return a report as a table for people to read.
+    static std::string Summary(const Report_t &report /*!< The report. */);
+
+private:
+    //! Add time to a stage.
+    static void Add(const Stage_t &stage, const std::chrono::steady_clock::duration &time);
+};
+
+#endif // PROFILER_H
@@ -71,10 +71,36 @@ private:
    // interpolation parameters
    // f(x) = a*(x-x_i)^3 + b*(x-x_i)^2 + c*(x-x_i) + y_i
    std::vector<double> m_a,m_b,m_c,m_d;
+   // uniformly spaced knots, x_i = x_0 + i/m_inv_h, allows O(1) look-up
+   bool   m_uniform=false;
+   double m_inv_h=0.0;
+
+   size_t find_closest(double x) const;                  // binary search
+   size_t find_closest(double x, size_t &cursor) const;  // hinted search
+   double interpolate(double x, size_t idx) const;
 public:
    void set_points(const std::vector<double>& x,
                    const std::vector<double>& y, bool cubic_spline=true);
+   // resample onto n uniformly spaced knots spanning [x[0], x[n-1]]
+   void set_uniform_points(const std::vector<double>& x,
+                           const std::vector<double>& y, size_t n,
+                           bool cubic_spline=true);
+   // resample onto a uniform grid fine enough to keep the smallest knot
+   // distance, but only if that needs at most max_factor times more knots
+   void set_points_resampled(const std::vector<double>& x,
+                             const std::vector<double>& y,
+                             double max_factor=4.0, bool cubic_spline=true);
    double operator() (double x) const;
+   // for sequential queries, cursor holds the last interval used and should
+   // be initialised to 0 before the first call
+   double operator() (double x, size_t &cursor) const;
+   // evaluate at many points, fastest if x is sorted
+   std::vector<double> operator() (const std::vector<double>& x) const;
+   // derivative of the given order (1, 2 or 3) at x
+   double deriv(int order, double x) const;
+   bool is_uniform() const {
+      return m_uniform;
+   }
 };
 
 #endif /* _tk_spline_h */
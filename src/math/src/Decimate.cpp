@@ -0,0 +1,57 @@
+#include "Decimate.h"
+
+#include <algorithm>
+
+//! Add an index unless it was the last one added.
+static inline void Add(std::vector<size_t> &keep, const size_t &i)
+{
+    if (keep.empty() || keep.back() != i)
+        keep.push_back(i);
+}
+
+size_t Decimate(const double *x, const double *y, const size_t &n, const double &xmin, const double &xmax,
+                const int &columns, std::vector<size_t> &keep)
+{
+    keep.clear();
+    if (n == 0 || columns <= 0 || !(xmax > xmin))
+        return 0;
+
+    const double scale = columns/(xmax - xmin);
+    size_t first = 0, lo = 0, hi = 0;   // Indices in the current run.
+    long column = -1;                   // Column of the current run, -1 if outside.
+
+    for (size_t i = 0 ; i < n ; ++i){
+        long c = -1;
+        if (x[i] >= xmin && x[i] <= xmax)
+            c = std::min(long((x[i] - xmin)*scale), long(columns - 1));
+
+        if (c == column && c >= 0){
+            if (y[i] < y[lo])
+                lo = i;
+            if (y[i] > y[hi])
+                hi = i;
+            continue;
+        }
+
+        // End the current run, keeping its extremes in their order.
+        if (column >= 0){
+            Add(keep, first);
+            Add(keep, std::min(lo, hi));
+            Add(keep, std::max(lo, hi));
+            Add(keep, i - 1);
+            if (c < 0)
+                Add(keep, i);   // Where the curve leaves the window.
+        } else if (c >= 0 && i > 0){
+            Add(keep, i - 1);   // Where the curve enters the window.
+        }
+        column = c;
+        first = lo = hi = i;
+    }
+    if (column >= 0){
+        Add(keep, first);
+        Add(keep, std::min(lo, hi));
+        Add(keep, std::max(lo, hi));
+        Add(keep, n - 1);
+    }
+    return keep.size();
+}
@@ -0,0 +1,110 @@
+#include "Profiler.h"
+
+#include <atomic>
+#include <cstdio>
+
+static std::atomic<int64_t> nanoseconds[Profiler::NumStages];
+static std::atomic<uint64_t> calls[Profiler::NumStages];
+static std::atomic<uint64_t> counts[Profiler::NumCounters];
+
+static const char *stageNames[Profiler::NumStages] = {
+    "setup", "beam", "kinematics", "target", "front_back", "absorber", "detectors", "fit", "levels"
+};
+
+static const char *counterNames[Profiler::NumCounters] = {
+    "rk4_steps", "evaluations", "cache_hits", "cache_misses"
+};
+
+double Profiler::Report_t::Total() const
+{
+    double total = 0;
+    for (int i = 0 ; i < NumStages ; ++i)
+        total += seconds[i];
+    return total;
+}
+
+Profiler::Report_t Profiler::Report_t::operator-(const Report_t &report) const
+{
+    Report_t r;
+    for (int i = 0 ; i < NumStages ; ++i){
+        r.seconds[i] = seconds[i] - report.seconds[i];
+        r.calls[i] = calls[i] - report.calls[i];
+    }
+    for (int i = 0 ; i < NumCounters ; ++i)
+        r.counts[i] = counts[i] - report.counts[i];
+    return r;
+}
+
+void Profiler::Add(const Stage_t &stage, const std::chrono::steady_clock::duration &time)
+{
+    nanoseconds[stage].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(), std::memory_order_relaxed);
+    calls[stage].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Profiler::Count(const Counter_t &counter, const uint64_t &n)
+{
+    counts[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+Profiler::Report_t Profiler::Get()
+{
+    Report_t r;
+    for (int i = 0 ; i < NumStages ; ++i){
+        r.seconds[i] = 1e-9*double(nanoseconds[i].load(std::memory_order_relaxed));
+        r.calls[i] = calls[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0 ; i < NumCounters ; ++i)
+        r.counts[i] = counts[i].load(std::memory_order_relaxed);
+    return r;
+}
+
+void Profiler::Reset()
+{
+    for (int i = 0 ; i < NumStages ; ++i){
+        nanoseconds[i] = 0;
+        calls[i] = 0;
+    }
+    for (int i = 0 ; i < NumCounters ; ++i)
+        counts[i] = 0;
+}
+
+const char *Profiler::Name(const Stage_t &stage)
+{
+    return stageNames[stage];
+}
+
+const char *Profiler::Name(const Counter_t &counter)
+{
+    return counterNames[counter];
+}
+
+void Profiler::Write(std::ostream &out, const Report_t &report)
+{
+    for (int i = 0 ; i < NumStages ; ++i)
+        out << "stage " << stageNames[i] << " " << report.calls[i] << " " << report.seconds[i] << "\n";
+    for (int i = 0 ; i < NumCounters ; ++i)
+        out << "counter " << counterNames[i] << " " << report.counts[i] << "\n";
+}
+
+std::string Profiler::Summary(const Report_t &report)
+{
+    std::string summary;
+    char line[128];
+    double total = report.Total();
+    snprintf(line, sizeof(line), "%-12s %10s %12s %7s\n", "Stage", "Calls", "Time [ms]", "Share");
+    summary += line;
+    for (int i = 0 ; i < NumStages ; ++i){
+        if (report.calls[i] == 0)
+            continue;
+        snprintf(line, sizeof(line), "%-12s %10llu %12.1f %6.1f%%\n", stageNames[i], (unsigned long long)report.calls[i],
+                 1e3*report.seconds[i], (total > 0) ? 100*report.seconds[i]/total : 0.);
+        summary += line;
+    }
+    snprintf(line, sizeof(line), "%-12s %10s %12.1f\n", "total", "", 1e3*total);
+    summary += line;
+    for (int i = 0 ; i < NumCounters ; ++i){
+        snprintf(line, sizeof(line), "%-12s %10llu\n", counterNames[i], (unsigned long long)report.counts[i]);
+        summary += line;
+    }
+    return summary;
+}
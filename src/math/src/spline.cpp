@@ -25,6 +25,8 @@
 
 #include "spline.h"
 
+#include <cmath>
+
 
 band_matrix::band_matrix(int dim, int n_u, int n_l) {
    resize(dim, n_u, n_l);
@@ -219,26 +221,144 @@ void spline::set_points(const std::vector<double>& x,
    // m_b[n-1] is determined by the boundary condition
    m_a[n-1]=0.0;
    m_c[n-1]=3.0*m_a[n-2]*h*h+2.0*m_b[n-2]*h+m_c[n-2];   // = f'_{n-2}(x_{n-1})
+
+   // check if the knots are evenly spaced
+   h=(x[n-1]-x[0])/double(n-1);
+   m_uniform=true;
+   for(int i=0; i<n-1 && m_uniform; i++) {
+      m_uniform=( fabs(x[i+1]-x[i]-h) <= 1e-9*h );
+   }
+   m_inv_h = (m_uniform) ? 1.0/h : 0.0;
 }
 
-double spline::operator() (double x) const {
+void spline::set_uniform_points(const std::vector<double>& x,
+                                const std::vector<double>& y, size_t n,
+                                bool cubic_spline) {
+   assert(n>=2);
+   set_points(x,y,cubic_spline);
+   std::vector<double> xu(n), yu(n);
+   double h=(x.back()-x.front())/double(n-1);
+   size_t cursor=0;
+   for(size_t i=0; i<n; i++) {
+      xu[i]=x.front()+i*h;
+      yu[i]=(*this)(xu[i], cursor);
+   }
+   xu[n-1]=x.back();
+   yu[n-1]=y.back();
+   set_points(xu,yu,cubic_spline);
+}
+
+void spline::set_points_resampled(const std::vector<double>& x,
+                                  const std::vector<double>& y,
+                                  double max_factor, bool cubic_spline) {
+   assert(x.size()>=2);
+   double min_h=x[1]-x[0];
+   for(size_t i=1; i<x.size()-1; i++) {
+      min_h=std::min(min_h, x[i+1]-x[i]);
+   }
+   // knots that are not strictly increasing are left to set_points
+   double n=(min_h>0.0) ? ceil((x.back()-x.front())/min_h)+1 : HUGE_VAL;
+   if(n<=max_factor*x.size()) {
+      set_uniform_points(x,y,size_t(n),cubic_spline);
+   } else {
+      set_points(x,y,cubic_spline);
+   }
+}
+
+size_t spline::find_closest(double x) const {
    size_t n=m_x.size();
+   if(m_uniform) {
+      double k=floor((x-m_x[0])*m_inv_h);
+      if(k<0) return 0;
+      return (k<n-2) ? size_t(k) : n-2;
+   }
    // find the closest point m_x[idx] < x, idx=0 even if x<m_x[0]
    std::vector<double>::const_iterator it;
    it=std::lower_bound(m_x.begin(),m_x.end(),x);
-   int idx=std::max( int(it-m_x.begin())-1, 0);
+   return std::max( int(it-m_x.begin())-1, 0);
+}
+
+size_t spline::find_closest(double x, size_t &cursor) const {
+   size_t n=m_x.size();
+   size_t idx=std::min(cursor, n-1);
+   if(m_uniform) {
+      idx=find_closest(x);
+   } else if(x>=m_x[idx]) {
+      // walk a few intervals to the right before giving up
+      for(int step=0; step<4 && idx<n-1 && x>m_x[idx+1]; step++) idx++;
+      if(idx<n-1 && x>m_x[idx+1]) idx=find_closest(x);
+   } else {
+      for(int step=0; step<4 && idx>0 && x<m_x[idx]; step++) idx--;
+      if(x<m_x[idx]) idx=find_closest(x);
+   }
+   cursor=idx;
+   return idx;
+}
 
-   double h=x-m_x[idx];
+double spline::interpolate(double x, size_t idx) const {
+   size_t n=m_x.size();
+   double h;
    double interpol;
    if(x<m_x[0]) {
       // extrapolation to the left
+      h=x-m_x[0];
       interpol=((m_b[0])*h + m_c[0])*h + m_y[0];
    } else if(x>m_x[n-1]) {
       // extrapolation to the right
+      h=x-m_x[n-1];
       interpol=((m_b[n-1])*h + m_c[n-1])*h + m_y[n-1];
    } else {
       // interpolation
+      h=x-m_x[idx];
       interpol=((m_a[idx]*h + m_b[idx])*h + m_c[idx])*h + m_y[idx];
    }
    return interpol;
 }
+
+double spline::operator() (double x) const {
+   return interpolate(x, find_closest(x));
+}
+
+double spline::operator() (double x, size_t &cursor) const {
+   return interpolate(x, find_closest(x, cursor));
+}
+
+double spline::deriv(int order, double x) const {
+   assert(order>0);
+   size_t n=m_x.size();
+   size_t idx=find_closest(x);
+   double h;
+   if(x<m_x[0] || x>m_x[n-1]) {
+      // extrapolation is quadratic
+      size_t i=(x<m_x[0]) ? 0 : n-1;
+      h=x-m_x[i];
+      switch(order) {
+      case 1:
+         return 2.0*m_b[i]*h + m_c[i];
+      case 2:
+         return 2.0*m_b[i];
+      default:
+         return 0.0;
+      }
+   }
+   h=x-m_x[idx];
+   switch(order) {
+   case 1:
+      return (3.0*m_a[idx]*h + 2.0*m_b[idx])*h + m_c[idx];
+   case 2:
+      return 6.0*m_a[idx]*h + 2.0*m_b[idx];
+   case 3:
+      return 6.0*m_a[idx];
+   default:
+      return 0.0;
+   }
+}
+
+std::vector<double> spline::operator() (const std::vector<double>& x) const {
+   std::vector<double> y(x.size());
+   size_t cursor=0;
+   for(size_t i=0; i<x.size(); i++) {
+      y[i]=interpolate(x[i], find_closest(x[i], cursor));
+   }
+   return y;
+}
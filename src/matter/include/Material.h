@@ -4,10 +4,15 @@
 
 #include <cmath>
 
+#include "ziegler1985_table.h"
+
 //! Class to contain information about an material.
 /*! When initilized, this class will retrive all the
  *  data required for both calculations using Ziegler
- *  or the Bethe-Block calculations.
+ *  or the Bethe-Block calculations. The Ziegler data is
+ *  not copied, but pointed to in the table. A material can
+ *  not be changed after it is made, and copies are cheap and
+ *  independent, so it is safe to share between threads.
  */
 class Material
 {
@@ -29,23 +34,10 @@ public:
              Unit _currUnit=none        /*!< Unit of the width parameter.       */);
 
     //! Copy constructor.
-    Material(const Material &material);
-
-	//! Destructor.
-	~Material();
+    Material(const Material &material) = default;
 
     //! Assign operator.
-    Material &operator=(const Material &material);
-
-	//! Set/change material.
-    void setMaterial(const int &_Z, /*!< Element number of material.                    */
-                     const int &_A,	/*!< Mass number of material.                       */
-                     const double &_width = -1, /*!< Width of the material in [unit].   */
-                     Unit _currUnit=none        /*!< Unit of the width parameter.       */);
-
-    //! Change width.
-    void setWidth(const double &_width, /*!< New width of the material.     */
-                  Unit _currUnit        /*!< Unit of the new width.         */);
+    Material &operator=(const Material &material) = default;
 
 	// Functions to get the different values needed for performing of stopping-power calculations.
 
@@ -88,7 +80,7 @@ public:
 
     //! Get pointer to pcoef.
     /*! \return proton stopping cross section coefficients. */
-    double *Getpcoef_ptr() const;
+    const double *Getpcoef_ptr() const;
 
     //! Get the width of the material.
     /*! \return Width of material in [g/cm²].
@@ -109,34 +101,14 @@ private:
 	//! Variable to contain the weight of the material in [MeV/c²].
 	double mMeV;
 
-	//! Variable to contain the density of the material [g/cm³].
-	double rho;
-
-	//! Variable to contain the density of the material [1e22/cm³].
-	double atrho;
-
-	//! Variable to contain the vfermi of the material [Bohr v].
-	double vfermi;
-
-	//! Variable to contain the proton stopping cross section coefficients.
-	double *pcoef;
-
-	//! Variable telling if data needed for Ziegler1985 excists.
-	bool Ziegler;
+    //! Ziegler 1985 data of the element, never nullptr.
+    const ZieglerElement_t *element;
 
     //! Variable to store the width of the target.
     double width;
 
     //! Variable to tell what units are used.
     Unit currUnit;
-
-    //! Variable telling if retrival of variable was successful or not.
-    bool retrive;
-
-	//! Helper function to retrive variables.
-	/*! \return true if successful, false otherwise.
-	 */
-	bool retriveVariables();
 };
 
 inline int Material::GetZ() const { return Z; }
@@ -147,11 +119,11 @@ inline double Material::GetM_AMU() const { return mAMU; }
 
 inline double Material::GetM_MeV() const { return mMeV; }
 
-inline double Material::Getrho() const { return rho; }
+inline double Material::Getrho() const { return element->rho; }
 
-inline double Material::Getatrho() const { return atrho; }
+inline double Material::Getatrho() const { return element->atrho; }
 
-inline double Material::Getvfermi() const { return vfermi; }
+inline double Material::Getvfermi() const { return element->vfermi; }
 
 inline double Material::GetMeanEx() const
 {
@@ -161,8 +133,8 @@ inline double Material::GetMeanEx() const
         return Z*(9.76 + 58.8*pow(Z, -1.19))*1e-6;
 }
 
-inline double Material::Getpcoef(const int &i) const { return pcoef[i]; }
-inline double *Material::Getpcoef_ptr() const { return pcoef; }
+inline double Material::Getpcoef(const int &i) const { return element->pcoef[i]; }
+inline const double *Material::Getpcoef_ptr() const { return element->pcoef; }
 
 inline double Material::GetWidth(Unit what) const
 {
@@ -173,13 +145,13 @@ inline double Material::GetWidth(Unit what) const
     else if (what == mgcm2 && currUnit == gcm2)
         return width*1e3;
     else if (what == gcm2 && currUnit == um)
-        return width*rho*1e-4;
+        return width*Getrho()*1e-4;
     else if (what == um && currUnit == gcm2)
-        return width/(rho*1e-4);
+        return width/(Getrho()*1e-4);
     else if (what == mgcm2 && currUnit == um)
-        return width*rho/10.;
+        return width*Getrho()/10.;
     else if (what == um && currUnit == mgcm2)
-        return width*10./rho;
+        return width*10./Getrho();
     else
         return -1;
 }
@@ -1,6 +1,10 @@
 #ifndef PARTICLE_H
 #define PARTICLE_H
 
+//! Class to contain information about a particle.
+/*! A particle can not be changed after it is made, and copies are
+ *  independent, so it is safe to share between threads.
+ */
 class Particle
 {
 public:
@@ -12,17 +16,10 @@ public:
 			 const int &_A  /*!< Mass number of particle. 	 */);
 
     //! Copy constructor.
-    Particle(const Particle &particle);
-
-	//! Destructor
-	~Particle();
+    Particle(const Particle &particle) = default;
 
     //! Assign operator.
-    Particle &operator=(const Particle &particle);
-
-	//! Function to set/change particle.
-	void setParticle(const int &_Z, /*!< Element number of particle. */
-			 		 const int &_A  /*!< Mass number of particle. 	 */);
+    Particle &operator=(const Particle &particle) = default;
 
 	//! Get element number.
 	/*! \return the element number of the particle. */
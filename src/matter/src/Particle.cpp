@@ -7,7 +7,11 @@
 
 Particle::Particle()
     : Z( 0 )
-    , A( 0 ){}
+    , A( 0 )
+    , mAMU( 0 )
+    , mMeV( 0 )
+    , lfctr( -1 )
+    , Ziegler( false ){}
 
 Particle::Particle(const int &_Z, const int &_A)
 	: Z( _Z )
@@ -18,26 +22,6 @@ Particle::Particle(const int &_Z, const int &_A)
         std::cerr << "Warning: Unable to retrive parameters for Ziegler stopping-power. Shure element(A,Z) (" << A << ", " << Z << ") is a valid isotope? Falling back on Bethe-Block." << std::endl;
 }
 
-Particle::Particle(const Particle &particle)
-    : Particle(particle.Z, particle.A){}
-
-Particle::~Particle() { }
-
-Particle &Particle::operator=(const Particle &particle)
-{
-    this->setParticle(particle.Z, particle.A);
-    return *this;
-}
-
-void Particle::setParticle(const int &_Z, const int &_A)
-{
-	Z = _Z;
-	A = _A;
-	Ziegler = retriveVariables();
-	if (!Ziegler)
-        std::cerr << "Warning: Unable to retrive parameters for Ziegler stopping-power. Shure element(A,Z) (" << A << ", " << Z << ") is a valid isotope? Falling back on Bethe-Block." << std::endl;
-}
-
 bool Particle::retriveVariables()
 {
 	mAMU = get_mass_amu(A, Z);
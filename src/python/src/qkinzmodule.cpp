@@ -0,0 +1,849 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "Geometry.h"
+#include "Material.h"
+#include "Particle.h"
+#include "RangeCache.h"
+#include "RangeTable.h"
+#include "RelScatter.h"
+#include "StoppingModel.h"
+#include "StoppingPower.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Python module 'qkinz': particles, materials, stopping powers, range
+// tables, two-body kinematics and the response of a telescope. Arrays are
+// taken through the buffer protocol (NumPy arrays of float64 without a
+// copy), and given back as NumPy arrays if NumPy is installed, else as
+// array.array('d'). Calculations are done without the GIL on all cores.
+
+namespace {
+
+const double PI = acos(-1);
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+//! Runs fn(i) for i from 0 to n on several threads, without the GIL.
+template<typename F>
+void ParallelFor(const Py_ssize_t &n, const int &threads, const F &fn)
+{
+    const Py_ssize_t BLOCK = 1024;
+    Py_ssize_t blocks = (n + BLOCK - 1)/BLOCK;
+    Py_ssize_t nthreads = (threads > 0) ? threads : Py_ssize_t(std::thread::hardware_concurrency());
+    nthreads = std::max<Py_ssize_t>(std::min(nthreads, blocks), 1);
+
+    Py_BEGIN_ALLOW_THREADS
+    std::atomic<Py_ssize_t> next(0);
+    auto work = [&](){
+        for (Py_ssize_t b = next++ ; b < blocks ; b = next++){
+            for (Py_ssize_t i = b*BLOCK ; i < std::min(n, (b + 1)*BLOCK) ; ++i)
+                fn(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (Py_ssize_t t = 1 ; t < nthreads ; ++t)
+        pool.push_back(std::thread(work));
+    work();
+    for (auto &thread : pool)
+        thread.join();
+    Py_END_ALLOW_THREADS
+}
+
+//! Read-only array of doubles from a buffer, a sequence or a number.
+class Input
+{
+public:
+    Input() : data( nullptr ), size( 0 ), hasView( false ){ }
+    ~Input(){ if (hasView) PyBuffer_Release(&view); }
+
+    Input(const Input &) = delete;
+    Input &operator=(const Input &) = delete;
+
+    //! \return false, with a Python exception set, if obj is not numbers.
+    bool Parse(PyObject *obj)
+    {
+        if (PyObject_CheckBuffer(obj) && PyObject_GetBuffer(obj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == 0){
+            const char *format = view.format ? view.format : "B";
+            if (*format == '@' || *format == '=')
+                ++format;
+            if (strcmp(format, "d") == 0 && view.itemsize == sizeof(double)){
+                hasView = true;
+                data = static_cast<const double *>(view.buf);
+                size = view.len/Py_ssize_t(sizeof(double));
+                return true;
+            }
+            if (strcmp(format, "f") == 0 && view.itemsize == sizeof(float)){
+                const float *f = static_cast<const float *>(view.buf);
+                copy.assign(f, f + view.len/Py_ssize_t(sizeof(float)));
+                PyBuffer_Release(&view);
+                return Done();
+            }
+            PyBuffer_Release(&view);
+        }
+        PyErr_Clear();
+
+        if (PyNumber_Check(obj) && !PySequence_Check(obj)){
+            copy.assign(1, PyFloat_AsDouble(obj));
+            return !PyErr_Occurred() && Done();
+        }
+        PyObject *seq = PySequence_Fast(obj, "expected a number or an array of numbers");
+        if (!seq)
+            return false;
+        Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+        PyObject **items = PySequence_Fast_ITEMS(seq);
+        copy.resize(n);
+        for (Py_ssize_t i = 0 ; i < n && !PyErr_Occurred() ; ++i)
+            copy[i] = PyFloat_AsDouble(items[i]);
+        Py_DECREF(seq);
+        return !PyErr_Occurred() && Done();
+    }
+
+    //! \return element i, a single number is the same for all i.
+    inline double operator[](const Py_ssize_t &i) const { return data[(size == 1) ? 0 : i]; }
+
+    //! \return the largest finite element, 0 if none.
+    double Max() const
+    {
+        double m = 0;
+        for (Py_ssize_t i = 0 ; i < size ; ++i)
+            m = (std::isfinite(data[i]) && data[i] > m) ? data[i] : m;
+        return m;
+    }
+
+    const double *data;
+    Py_ssize_t size;
+
+private:
+    bool Done()
+    {
+        data = copy.data();
+        size = Py_ssize_t(copy.size());
+        return true;
+    }
+
+    Py_buffer view;
+    bool hasView;
+    std::vector<double> copy;
+};
+
+//! \return the common length of the inputs, -1 with a ValueError if they differ.
+Py_ssize_t Broadcast(std::initializer_list<const Input *> inputs)
+{
+    Py_ssize_t n = 1;
+    for (const Input *input : inputs){
+        if (input->size == 1 || input->size == n)
+            continue;
+        if (n != 1){
+            PyErr_SetString(PyExc_ValueError, "arrays of different lengths");
+            return -1;
+        }
+        n = input->size;
+    }
+    return n;
+}
+
+//! \return a new array of n doubles, data set to its elements. nullptr on errors.
+PyObject *NewArray(const Py_ssize_t &n, double *&data)
+{
+    static PyObject *numpy = nullptr, *array = nullptr;
+    PyObject *result = nullptr;
+    if (!numpy && !array){
+        numpy = PyImport_ImportModule("numpy");
+        if (!numpy){
+            PyErr_Clear();
+            array = PyImport_ImportModule("array");
+            if (!array)
+                return nullptr;
+        }
+    }
+    if (numpy){
+        result = PyObject_CallMethod(numpy, "empty", "n", n);
+    } else {
+        PyObject *bytes = PyBytes_FromStringAndSize(nullptr, n*Py_ssize_t(sizeof(double)));
+        if (!bytes)
+            return nullptr;
+        result = PyObject_CallMethod(array, "array", "sO", "d", bytes);
+        Py_DECREF(bytes);
+    }
+    if (!result)
+        return nullptr;
+
+    // The memory is owned by the new array, which nobody else has yet.
+    Py_buffer view;
+    if (PyObject_GetBuffer(result, &view, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) != 0){
+        Py_DECREF(result);
+        return nullptr;
+    }
+    data = static_cast<double *>(view.buf);
+    PyBuffer_Release(&view);
+    return result;
+}
+
+//! \return false, with a ValueError, if the unit is not um, mgcm2 or gcm2.
+bool ParseUnit(const char *name, Material::Unit &unit)
+{
+    std::string u(name);
+    if (u == "um")
+        unit = Material::um;
+    else if (u == "mgcm2")
+        unit = Material::mgcm2;
+    else if (u == "gcm2")
+        unit = Material::gcm2;
+    else {
+        PyErr_Format(PyExc_ValueError, "unknown unit '%s', expected um, mgcm2 or gcm2", name);
+        return false;
+    }
+    return true;
+}
+
+const char *UnitName(const Material::Unit &unit)
+{
+    return (unit == Material::mgcm2) ? "mgcm2" : (unit == Material::gcm2) ? "gcm2" : "um";
+}
+
+// ---- Particle ----
+
+typedef struct {
+    PyObject_HEAD
+    Particle *particle;
+} ParticleObject;
+
+PyTypeObject *ParticleType = nullptr;
+
+int Particle_init(ParticleObject *self, PyObject *args, PyObject *kwds)
+{
+    static const char *keywords[] = {"Z", "A", nullptr};
+    int Z, A;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "ii", const_cast<char **>(keywords), &Z, &A))
+        return -1;
+    Particle particle(Z, A);
+    if (!(particle.GetM_AMU() > 0)){
+        PyErr_Format(PyExc_ValueError, "no mass of A=%d, Z=%d in the mass table", A, Z);
+        return -1;
+    }
+    delete self->particle;
+    self->particle = new Particle(particle);
+    return 0;
+}
+
+void Particle_dealloc(ParticleObject *self)
+{
+    delete self->particle;
+    PyTypeObject *type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+PyObject *Particle_repr(ParticleObject *self)
+{
+    if (!self->particle)
+        return PyUnicode_FromString("Particle()");
+    return PyUnicode_FromFormat("Particle(Z=%d, A=%d)", self->particle->GetZ(), self->particle->GetA());
+}
+
+PyObject *Particle_get(ParticleObject *self, void *what)
+{
+    if (!self->particle){
+        PyErr_SetString(PyExc_RuntimeError, "particle not initialised");
+        return nullptr;
+    }
+    std::string name(static_cast<const char *>(what));
+    if (name == "Z")
+        return PyLong_FromLong(self->particle->GetZ());
+    else if (name == "A")
+        return PyLong_FromLong(self->particle->GetA());
+    return PyFloat_FromDouble(self->particle->GetM_AMU());
+}
+
+PyGetSetDef Particle_getset[] = {
+    {"Z", reinterpret_cast<getter>(Particle_get), nullptr, "Element number.", const_cast<char *>("Z")},
+    {"A", reinterpret_cast<getter>(Particle_get), nullptr, "Mass number.", const_cast<char *>("A")},
+    {"mass", reinterpret_cast<getter>(Particle_get), nullptr, "Mass [u].", const_cast<char *>("mass")},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}
+};
+
+PyType_Slot Particle_slots[] = {
+    {Py_tp_doc, const_cast<char *>("Particle(Z, A)\n\nA nucleus, with the mass from AME2012.")},
+    {Py_tp_new, reinterpret_cast<void *>(PyType_GenericNew)},
+    {Py_tp_init, reinterpret_cast<void *>(Particle_init)},
+    {Py_tp_dealloc, reinterpret_cast<void *>(Particle_dealloc)},
+    {Py_tp_repr, reinterpret_cast<void *>(Particle_repr)},
+    {Py_tp_getset, Particle_getset},
+    {0, nullptr}
+};
+
+PyType_Spec Particle_spec = {"qkinz.Particle", sizeof(ParticleObject), 0, Py_TPFLAGS_DEFAULT, Particle_slots};
+
+//! \return the particle of obj, nullptr with a TypeError if not a Particle.
+const Particle *GetParticle(PyObject *obj)
+{
+    if (!PyObject_TypeCheck(obj, ParticleType) || !reinterpret_cast<ParticleObject *>(obj)->particle){
+        PyErr_SetString(PyExc_TypeError, "expected a qkinz.Particle");
+        return nullptr;
+    }
+    return reinterpret_cast<ParticleObject *>(obj)->particle;
+}
+
+// ---- Material ----
+
+typedef struct {
+    PyObject_HEAD
+    Material *material;
+    Material::Unit unit;
+} MaterialObject;
+
+PyTypeObject *MaterialType = nullptr;
+
+int Material_init(MaterialObject *self, PyObject *args, PyObject *kwds)
+{
+    static const char *keywords[] = {"Z", "width", "unit", "A", nullptr};
+    int Z, A = 0;
+    double width = 0;
+    const char *unit = "um";
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "i|dsi", const_cast<char **>(keywords), &Z, &width, &unit, &A))
+        return -1;
+    if (Z < 1 || Z > 92 || !(Get_mm2(Z) > 0)){
+        PyErr_Format(PyExc_ValueError, "no stopping powers of Z=%d, expected 1 to 92", Z);
+        return -1;
+    }
+    if (!ParseUnit(unit, self->unit))
+        return -1;
+    // The most abundant isotope, as for the telescope layers.
+    if (A < 1)
+        A = int(Get_mm2(Z));
+    delete self->material;
+    self->material = new Material(Z, A, width, self->unit);
+    return 0;
+}
+
+void Material_dealloc(MaterialObject *self)
+{
+    delete self->material;
+    PyTypeObject *type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+PyObject *Material_repr(MaterialObject *self)
+{
+    if (!self->material)
+        return PyUnicode_FromString("Material()");
+    PyObject *width = PyFloat_FromDouble(self->material->GetWidth(Material::none));
+    PyObject *repr = PyUnicode_FromFormat("Material(Z=%d, width=%R, unit='%s', A=%d)", self->material->GetZ(), width,
+                                          UnitName(self->unit), self->material->GetA());
+    Py_XDECREF(width);
+    return repr;
+}
+
+PyObject *Material_get(MaterialObject *self, void *what)
+{
+    if (!self->material){
+        PyErr_SetString(PyExc_RuntimeError, "material not initialised");
+        return nullptr;
+    }
+    std::string name(static_cast<const char *>(what));
+    if (name == "Z")
+        return PyLong_FromLong(self->material->GetZ());
+    else if (name == "A")
+        return PyLong_FromLong(self->material->GetA());
+    else if (name == "width")
+        return PyFloat_FromDouble(self->material->GetWidth(Material::none));
+    else if (name == "unit")
+        return PyUnicode_FromString(UnitName(self->unit));
+    return PyFloat_FromDouble(self->material->Getrho());
+}
+
+PyGetSetDef Material_getset[] = {
+    {"Z", reinterpret_cast<getter>(Material_get), nullptr, "Element number.", const_cast<char *>("Z")},
+    {"A", reinterpret_cast<getter>(Material_get), nullptr, "Mass number.", const_cast<char *>("A")},
+    {"width", reinterpret_cast<getter>(Material_get), nullptr, "Width, in unit.", const_cast<char *>("width")},
+    {"unit", reinterpret_cast<getter>(Material_get), nullptr, "Unit of the widths: um, mgcm2 or gcm2.", const_cast<char *>("unit")},
+    {"density", reinterpret_cast<getter>(Material_get), nullptr, "Density [g/cm3].", const_cast<char *>("density")},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}
+};
+
+PyType_Slot Material_slots[] = {
+    {Py_tp_doc, const_cast<char *>("Material(Z, width=0, unit='um', A=most abundant)\n\n"
+                                   "A layer of an element. Widths given to the functions of the module are in its unit.")},
+    {Py_tp_new, reinterpret_cast<void *>(PyType_GenericNew)},
+    {Py_tp_init, reinterpret_cast<void *>(Material_init)},
+    {Py_tp_dealloc, reinterpret_cast<void *>(Material_dealloc)},
+    {Py_tp_repr, reinterpret_cast<void *>(Material_repr)},
+    {Py_tp_getset, Material_getset},
+    {0, nullptr}
+};
+
+PyType_Spec Material_spec = {"qkinz.Material", sizeof(MaterialObject), 0, Py_TPFLAGS_DEFAULT, Material_slots};
+
+//! \return the material object of obj, nullptr with a TypeError if not a Material.
+MaterialObject *GetMaterial(PyObject *obj)
+{
+    if (!PyObject_TypeCheck(obj, MaterialType) || !reinterpret_cast<MaterialObject *>(obj)->material){
+        PyErr_SetString(PyExc_TypeError, "expected a qkinz.Material");
+        return nullptr;
+    }
+    return reinterpret_cast<MaterialObject *>(obj);
+}
+
+//! \return the width of one unit of the material in another unit.
+double Scale(const MaterialObject *m, const Material::Unit &to)
+{
+    return Material(m->material->GetZ(), m->material->GetA(), 1., m->unit).GetWidth(to);
+}
+
+// ---- RangeTable ----
+
+typedef struct {
+    PyObject_HEAD
+    std::shared_ptr<RangeTable> *table;
+    double width;   // Width of the material in table units.
+    double scale;   // Table units per unit of the material.
+} RangeTableObject;
+
+int RangeTable_init(RangeTableObject *self, PyObject *args, PyObject *kwds)
+{
+    static const char *keywords[] = {"particle", "material", "Emax", nullptr};
+    PyObject *p, *m;
+    double Emax;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOd", const_cast<char **>(keywords), &p, &m, &Emax))
+        return -1;
+    const Particle *particle = GetParticle(p);
+    MaterialObject *material = (particle) ? GetMaterial(m) : nullptr;
+    if (!material)
+        return -1;
+    if (!(Emax > 0)){
+        PyErr_SetString(PyExc_ValueError, "Emax must be positive");
+        return -1;
+    }
+    std::shared_ptr<RangeTable> table;
+    double width;
+    Py_BEGIN_ALLOW_THREADS
+    table = StoppingModel::MakeTable(particle, material->material, Emax, width);
+    Py_END_ALLOW_THREADS
+    delete self->table;
+    self->table = new std::shared_ptr<RangeTable>(table);
+    self->width = width;
+    self->scale = Scale(material, StoppingModel::Unit(StoppingModel::Choose(particle, material->material, 2*Emax)));
+    return 0;
+}
+
+void RangeTable_dealloc(RangeTableObject *self)
+{
+    delete self->table;
+    PyTypeObject *type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+//! Loss, gain, range or energy of a table, for arrays.
+template<int WHAT>
+PyObject *RangeTable_apply(RangeTableObject *self, PyObject *args, PyObject *kwds)
+{
+    static const char *keywords[] = {"E", "width", "threads", nullptr};
+    PyObject *e, *w = nullptr;
+    int threads = 0;
+    if (!self->table){
+        PyErr_SetString(PyExc_RuntimeError, "range table not initialised");
+        return nullptr;
+    }
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|Oi", const_cast<char **>(keywords), &e, &w, &threads))
+        return nullptr;
+    Input E, width;
+    if (!E.Parse(e))
+        return nullptr;
+    if (w && w != Py_None){
+        if (!width.Parse(w))
+            return nullptr;
+    }
+    Py_ssize_t n = (width.size > 0) ? Broadcast({&E, &width}) : E.size;
+    double *out;
+    PyObject *result = (n >= 0) ? NewArray(n, out) : nullptr;
+    if (!result)
+        return nullptr;
+
+    const RangeTable *table = self->table->get();
+    const double scale = self->scale, w0 = self->width;
+    const bool own = (width.size == 0);
+    ParallelFor(n, threads, [&](const Py_ssize_t &i){
+        double wi = own ? w0 : width[i]*scale;
+        if (WHAT == 0)
+            out[i] = table->Loss(E[i], wi);
+        else if (WHAT == 1)
+            out[i] = table->Gain(E[i], wi);
+        else if (WHAT == 2)
+            out[i] = table->Range(E[i])/scale;
+        else
+            out[i] = table->Energy(E[i]*scale);
+    });
+    return result;
+}
+
+PyMethodDef RangeTable_methods[] = {
+    {"loss", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(RangeTable_apply<0>)), METH_VARARGS | METH_KEYWORDS,
+     "loss(E, width=material width, threads=all)\n\nEnergies [MeV] after a layer of the material."},
+    {"gain", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(RangeTable_apply<1>)), METH_VARARGS | METH_KEYWORDS,
+     "gain(E, width=material width, threads=all)\n\nEnergies [MeV] before a layer of the material, the inverse of loss."},
+    {"range", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(RangeTable_apply<2>)), METH_VARARGS | METH_KEYWORDS,
+     "range(E, threads=all)\n\nRanges in the unit of the material of particles with energies E [MeV]."},
+    {"energy", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(RangeTable_apply<3>)), METH_VARARGS | METH_KEYWORDS,
+     "energy(R, threads=all)\n\nEnergies [MeV] of particles with ranges R in the unit of the material."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyObject *RangeTable_get(RangeTableObject *self, void *what)
+{
+    if (!self->table){
+        PyErr_SetString(PyExc_RuntimeError, "range table not initialised");
+        return nullptr;
+    }
+    return PyFloat_FromDouble((strcmp(static_cast<const char *>(what), "Emin") == 0) ? (*self->table)->GetEmin() : (*self->table)->GetEmax());
+}
+
+PyGetSetDef RangeTable_getset[] = {
+    {"Emin", reinterpret_cast<getter>(RangeTable_get), nullptr, "Lowest energy of the table [MeV].", const_cast<char *>("Emin")},
+    {"Emax", reinterpret_cast<getter>(RangeTable_get), nullptr, "Highest energy of the table [MeV].", const_cast<char *>("Emax")},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}
+};
+
+PyType_Slot RangeTable_slots[] = {
+    {Py_tp_doc, const_cast<char *>("RangeTable(particle, material, Emax)\n\n"
+                                   "Tabulated range of a particle in a material, up to at least 2*Emax [MeV]. The\n"
+                                   "tables are the same for all Emax of a model, and are kept in the cache directory,\n"
+                                   "see set_cache_dir.")},
+    {Py_tp_new, reinterpret_cast<void *>(PyType_GenericNew)},
+    {Py_tp_init, reinterpret_cast<void *>(RangeTable_init)},
+    {Py_tp_dealloc, reinterpret_cast<void *>(RangeTable_dealloc)},
+    {Py_tp_methods, RangeTable_methods},
+    {Py_tp_getset, RangeTable_getset},
+    {0, nullptr}
+};
+
+PyType_Spec RangeTable_spec = {"qkinz.RangeTable", sizeof(RangeTableObject), 0, Py_TPFLAGS_DEFAULT, RangeTable_slots};
+
+// ---- Telescope ----
+
+typedef struct {
+    PyObject_HEAD
+    Particle *fragment;
+    RelScatter *scat;
+    Particle *reaction[3];      // Beam, target and residual.
+    std::shared_ptr<RangeTable> *tables[5];  // Target, front, back, absorber, dE and E.
+    double widths[5];           // Widths of the layers in table units.
+    std::shared_ptr<RangeTable> *tE;
+    double wE;
+    double Ehalf;               // Beam energy in the middle of the target.
+    double normal;              // Angle of the normal of the telescope to the beam [rad].
+} TelescopeObject;
+
+enum { TARGET, FRONT, BACK, ABSORBER, DE };
+
+void Telescope_clear(TelescopeObject *self)
+{
+    delete self->scat;
+    delete self->fragment;
+    for (int i = 0 ; i < 3 ; ++i)
+        delete self->reaction[i];
+    for (int i = 0 ; i < 5 ; ++i)
+        delete self->tables[i];
+    delete self->tE;
+    memset(reinterpret_cast<char *>(self) + sizeof(PyObject), 0, sizeof(TelescopeObject) - sizeof(PyObject));
+}
+
+int Telescope_init(TelescopeObject *self, PyObject *args, PyObject *kwds)
+{
+    static const char *keywords[] = {"beam", "energy", "target", "fragment", "dE", "E",
+                                     "absorber", "front", "back", "normal", nullptr};
+    PyObject *b, *t, *f, *de, *e, *a = Py_None, *fr = Py_None, *ba = Py_None;
+    double energy, normal = Geometry::NORMAL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OdOOOO|OOOd", const_cast<char **>(keywords),
+                                     &b, &energy, &t, &f, &de, &e, &a, &fr, &ba, &normal))
+        return -1;
+    const Particle *beam = GetParticle(b), *fragment = (beam) ? GetParticle(f) : nullptr;
+    MaterialObject *layers[6] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+    PyObject *objects[6] = {t, fr, ba, a, de, e};
+    if (!fragment)
+        return -1;
+    for (int i = 0 ; i < 6 ; ++i){
+        if (objects[i] != Py_None && !(layers[i] = GetMaterial(objects[i])))
+            return -1;
+    }
+    if (!layers[TARGET] || !layers[DE] || !layers[5]){
+        PyErr_SetString(PyExc_TypeError, "target, dE and E must be qkinz.Material");
+        return -1;
+    }
+    const Material *target = layers[TARGET]->material;
+    Particle targetIso(target->GetZ(), target->GetA());
+    Particle residual(beam->GetZ() + target->GetZ() - fragment->GetZ(), beam->GetA() + target->GetA() - fragment->GetA());
+    if (!(targetIso.GetM_AMU() > 0) || !(residual.GetM_AMU() > 0)){
+        PyErr_SetString(PyExc_ValueError, "the target or the residual nucleus is not in the mass table");
+        return -1;
+    }
+
+    Telescope_clear(self);
+    self->fragment = new Particle(*fragment);
+    self->reaction[0] = new Particle(*beam);
+    self->reaction[1] = new Particle(targetIso);
+    self->reaction[2] = new Particle(residual);
+    self->scat = new RelScatter(self->reaction[0], self->reaction[1], self->fragment, self->reaction[2]);
+    self->normal = normal;
+
+    Py_BEGIN_ALLOW_THREADS
+    // Beam energy in the middle of the target, as when sorting.
+    double w;
+    self->Ehalf = energy;
+    if (layers[FRONT])
+        self->Ehalf = StoppingModel::MakeTable(self->reaction[0], layers[FRONT]->material, energy, w)->Loss(self->Ehalf, w);
+    self->Ehalf = StoppingModel::MakeTable(self->reaction[0], target, energy, w)->Loss(self->Ehalf, w/2.);
+
+    // The fragment never has more energy than at the angle giving the most.
+    double Emax = 0;
+    for (int i = 0 ; i <= 180 ; ++i){
+        double ey = self->scat->EvaluateY(energy, i*PI/180., 0);
+        if (ey > Emax)
+            Emax = ey;
+    }
+    for (int i = 0 ; i < 5 ; ++i){
+        if (layers[i])
+            self->tables[i] = new std::shared_ptr<RangeTable>(StoppingModel::MakeTable(self->fragment, layers[i]->material, Emax, self->widths[i]));
+    }
+    self->tE = new std::shared_ptr<RangeTable>(StoppingModel::MakeTable(self->fragment, layers[5]->material, Emax, self->wE));
+    Py_END_ALLOW_THREADS
+    return 0;
+}
+
+void Telescope_dealloc(TelescopeObject *self)
+{
+    Telescope_clear(self);
+    PyTypeObject *type = Py_TYPE(self);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+//! Energies of the fragment in the thin and thick detectors.
+PyObject *Telescope_response(TelescopeObject *self, PyObject *args, PyObject *kwds)
+{
+    static const char *keywords[] = {"theta", "Ex", "threads", nullptr};
+    PyObject *t, *x;
+    int threads = 0;
+    if (!self->scat){
+        PyErr_SetString(PyExc_RuntimeError, "telescope not initialised");
+        return nullptr;
+    }
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|i", const_cast<char **>(keywords), &t, &x, &threads))
+        return nullptr;
+    Input theta, Ex;
+    if (!theta.Parse(t) || !Ex.Parse(x))
+        return nullptr;
+    Py_ssize_t n = Broadcast({&theta, &Ex});
+    double *dE, *E;
+    PyObject *rdE = (n >= 0) ? NewArray(n, dE) : nullptr;
+    PyObject *rE = (rdE) ? NewArray(n, E) : nullptr;
+    if (!rE){
+        Py_XDECREF(rdE);
+        return nullptr;
+    }
+
+    const TelescopeObject *tel = self;
+    auto Table = [tel](const int &i){ return (tel->tables[i]) ? tel->tables[i]->get() : nullptr; };
+    const RangeTable *tTarget = Table(TARGET), *tFront = Table(FRONT), *tBack = Table(BACK), *tAbs = Table(ABSORBER);
+    const RangeTable *tdE = Table(DE), *tE = self->tE->get();
+    ParallelFor(n, threads, [&](const Py_ssize_t &i){
+        double angle = theta[i];
+        double inc = Geometry::IncAngle(angle, tel->normal);
+        double e = tel->scat->EvaluateY(tel->Ehalf, angle, Ex[i]);
+        if (!(e > 0) || !(cos(inc) > 0)){
+            dE[i] = E[i] = NaN;
+            return;
+        }
+        e = tTarget->Loss(e, Geometry::HalfPath(tel->widths[TARGET], angle));
+        if (Geometry::ThroughFront(angle, tFront))
+            e = tFront->Loss(e, Geometry::Path(tel->widths[FRONT], angle));
+        else if (tBack)
+            e = tBack->Loss(e, Geometry::Path(tel->widths[BACK], angle));
+        if (tAbs)
+            e = tAbs->Loss(e, Geometry::TelescopePath(tel->widths[ABSORBER], inc));
+        double e1 = tdE->Loss(e, Geometry::TelescopePath(tel->widths[DE], inc));
+        dE[i] = e - e1;
+        E[i] = e1 - tE->Loss(e1, Geometry::TelescopePath(tel->wE, inc));
+    });
+    return Py_BuildValue("NN", rdE, rE);
+}
+
+PyMethodDef Telescope_methods[] = {
+    {"response", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(Telescope_response)), METH_VARARGS | METH_KEYWORDS,
+     "response(theta, Ex, threads=all)\n\nEnergies [MeV] deposited in the dE and E detectors by the fragment at\n"
+     "scattering angles theta [rad] with the residual at excitation energies Ex [MeV].\n"
+     "NaN where the reaction is not possible or the telescope is not seen. Returns (dE, E)."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyType_Slot Telescope_slots[] = {
+    {Py_tp_doc, const_cast<char *>("Telescope(beam, energy, target, fragment, dE, E, absorber=None, front=None, back=None, normal=47 deg)\n\n"
+                                   "Response of a particle telescope to the fragment of a reaction. The reaction is\n"
+                                   "in the middle of the target, and the fragment leaves through the fronting at\n"
+                                   "backward angles if given, else through the backing, as in Qkinz. The normal of\n"
+                                   "the telescope is at the angle normal [rad] to the beam, mirrored at backward angles.")},
+    {Py_tp_new, reinterpret_cast<void *>(PyType_GenericNew)},
+    {Py_tp_init, reinterpret_cast<void *>(Telescope_init)},
+    {Py_tp_dealloc, reinterpret_cast<void *>(Telescope_dealloc)},
+    {Py_tp_methods, Telescope_methods},
+    {0, nullptr}
+};
+
+PyType_Spec Telescope_spec = {"qkinz.Telescope", sizeof(TelescopeObject), 0, Py_TPFLAGS_DEFAULT, Telescope_slots};
+
+// ---- Functions ----
+
+PyObject *qkinz_loss(PyObject *, PyObject *args, PyObject *kwds)
+{
+    static const char *keywords[] = {"particle", "material", "E", "width", "points", "threads", nullptr};
+    PyObject *p, *m, *e, *w = nullptr;
+    int points = 1001, threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO|Oii", const_cast<char **>(keywords), &p, &m, &e, &w, &points, &threads))
+        return nullptr;
+    const Particle *particle = GetParticle(p);
+    MaterialObject *material = (particle) ? GetMaterial(m) : nullptr;
+    Input E, width;
+    if (!material || !E.Parse(e) || (w && w != Py_None && !width.Parse(w)))
+        return nullptr;
+    if (points < 1){
+        PyErr_SetString(PyExc_ValueError, "points must be positive");
+        return nullptr;
+    }
+    Py_ssize_t n = (width.size > 0) ? Broadcast({&E, &width}) : E.size;
+    double *out;
+    PyObject *result = (n >= 0) ? NewArray(n, out) : nullptr;
+    if (!result)
+        return nullptr;
+
+    Material::Unit unit;
+    std::unique_ptr<StoppingPower> stop(StoppingModel::Make(material->material, particle, E.Max(), unit));
+    const StoppingPower *sp = stop.get();
+    const double scale = Scale(material, unit), w0 = material->material->GetWidth(unit);
+    const bool own = (width.size == 0);
+    ParallelFor(n, threads, [&](const Py_ssize_t &i){
+        out[i] = sp->Loss(E[i], own ? w0 : width[i]*scale, points);
+    });
+    return result;
+}
+
+PyObject *qkinz_kinematics(PyObject *, PyObject *args, PyObject *kwds)
+{
+    static const char *keywords[] = {"beam", "target", "fragment", "E", "theta", "Ex", "threads", nullptr};
+    PyObject *b, *t, *f, *e, *th, *x = nullptr;
+    int threads = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOOOO|Oi", const_cast<char **>(keywords), &b, &t, &f, &e, &th, &x, &threads))
+        return nullptr;
+    const Particle *beam = GetParticle(b);
+    const Particle *target = (beam) ? GetParticle(t) : nullptr;
+    const Particle *fragment = (target) ? GetParticle(f) : nullptr;
+    Input E, theta, Ex;
+    // False is the number 0, the ground state.
+    if (!fragment || !E.Parse(e) || !theta.Parse(th) || !Ex.Parse(x ? x : Py_False))
+        return nullptr;
+    Particle residual(beam->GetZ() + target->GetZ() - fragment->GetZ(), beam->GetA() + target->GetA() - fragment->GetA());
+    if (!(residual.GetM_AMU() > 0)){
+        PyErr_SetString(PyExc_ValueError, "the residual nucleus is not in the mass table");
+        return nullptr;
+    }
+    Py_ssize_t n = Broadcast({&E, &theta, &Ex});
+    double *out;
+    PyObject *result = (n >= 0) ? NewArray(n, out) : nullptr;
+    if (!result)
+        return nullptr;
+
+    Particle pA(*beam), pX(*target), pY(*fragment);
+    RelScatter scat(&pA, &pX, &pY, &residual);
+    ParallelFor(n, threads, [&](const Py_ssize_t &i){
+        out[i] = scat.EvaluateY(E[i], theta[i], Ex[i]);
+    });
+    return result;
+}
+
+PyObject *qkinz_set_precision(PyObject *, PyObject *arg)
+{
+    const char *name = PyUnicode_AsUTF8(arg);
+    if (!name)
+        return nullptr;
+    if (strcmp(name, "exact") == 0)
+        StoppingModel::SetPrecision(StoppingModel::Exact);
+    else if (strcmp(name, "fast") == 0)
+        StoppingModel::SetPrecision(StoppingModel::Fast);
+    else {
+        PyErr_Format(PyExc_ValueError, "unknown precision '%s', expected exact or fast", name);
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *qkinz_set_cache_dir(PyObject *, PyObject *arg)
+{
+    const char *dir = PyUnicode_AsUTF8(arg);
+    if (!dir)
+        return nullptr;
+    RangeCache::SetDirectory(dir);
+    Py_RETURN_NONE;
+}
+
+PyMethodDef qkinz_methods[] = {
+    {"loss", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(qkinz_loss)), METH_VARARGS | METH_KEYWORDS,
+     "loss(particle, material, E, width=material width, points=1001, threads=all)\n\n"
+     "Energies [MeV] after a layer, integrating the stopping power in points steps."},
+    {"kinematics", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(qkinz_kinematics)), METH_VARARGS | METH_KEYWORDS,
+     "kinematics(beam, target, fragment, E, theta, Ex=0, threads=all)\n\n"
+     "Energies [MeV] of the fragment of target(beam, fragment)residual at beam energies E [MeV],\n"
+     "scattering angles theta [rad] and excitation energies Ex [MeV] of the residual."},
+    {"set_precision", qkinz_set_precision, METH_O,
+     "set_precision(name)\n\nPrecision of the stopping powers made from now on, 'exact' (default) or 'fast'."},
+    {"set_cache_dir", qkinz_set_cache_dir, METH_O,
+     "set_cache_dir(path)\n\nKeep range tables in a directory across sessions, '' to stop."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyModuleDef qkinz_module = {
+    PyModuleDef_HEAD_INIT, "qkinz",
+    "Kinematics, stopping powers and telescope response of Qkinz.\n\n"
+    "Functions take numbers, sequences or arrays (float64 arrays without a copy), with\n"
+    "single numbers used for all elements, and run without the GIL on all cores.",
+    -1, qkinz_methods, nullptr, nullptr, nullptr, nullptr
+};
+
+//! \return false if the type could not be made and added to the module.
+bool AddType(PyObject *module, PyType_Spec *spec, PyTypeObject **type)
+{
+    PyObject *t = PyType_FromSpec(spec);
+    if (!t)
+        return false;
+    *type = reinterpret_cast<PyTypeObject *>(t);
+    const char *name = strrchr(spec->name, '.') + 1;
+    Py_INCREF(t);
+    if (PyModule_AddObject(module, name, t) < 0){
+        Py_DECREF(t);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_qkinz()
+{
+    PyObject *module = PyModule_Create(&qkinz_module);
+    if (!module)
+        return nullptr;
+    PyTypeObject *rangeTableType, *telescopeType;
+    if (!AddType(module, &Particle_spec, &ParticleType) || !AddType(module, &Material_spec, &MaterialType)
+            || !AddType(module, &RangeTable_spec, &rangeTableType) || !AddType(module, &Telescope_spec, &telescopeType)){
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -4,10 +4,15 @@
 #include <QObject>
 #include <QThread>
 #include <QString>
+#include <ostream>
 #include <string>
+#include <vector>
 #include "types.h"
 #include "worker.h"
 #include "CustomPower.h"
+#include "PIDGates.h"
+#include "Profiler.h"
+#include "StoppingModel.h"
 
 class BatchReader : public QObject
 {
@@ -25,9 +30,53 @@ signals:
     void curr_prog(double);
 
 private:
+    //! A parameter varied by a 'scan' command.
+    struct Scan_t {
+        std::string name;   //! Name of the parameter, as given in the batch file.
+        double *value;      //! The parameter to set.
+        double min;         //! First value.
+        double max;         //! Last value.
+        int n;              //! Number of values.
+    };
+
     bool readBatchFile(const std::string &batchFile);
+
+    //! Write the profile of a run to the output file name followed by '.profile'.
+    void WriteProfile(const Profiler::Report_t &report, /*!< Stages and counters of the run.   */
+                      const double &wall                /*!< Wall-clock time of the run [s].    */);
+
 	void Run();
 
+    //! Fit the parameters given by 'fit' commands to the peaks in peakfile.
+    void RunFit();
+
+    //! Reconstruct the excitation energy of the events in eventfile.
+    void RunSort();
+
+    //! Calculate the dE-E band over the acceptance of each SiRi strip.
+    void RunBand();
+
+    //! Calculate where the band of every open exit channel is seen, at all angles.
+    void RunChannels();
+
+    //! Make particle identification gates for each strip, \see PIDGates.
+    void RunGates();
+
+    //! Tabulate the kinematics of the reaction, \see KinematicsMap.
+    void RunMap();
+
+    //! Look up a setup parameter by the name used in the batch file.
+    /*! \return pointer to the value, or nullptr if the name is unknown.
+     */
+    double *Parameter(const std::string &name,  /*!< Name of the parameter.    */
+                      Param_t &param            /*!< Set to the parameter.     */);
+
+    //! Calculate all angles for the current setup.
+    void RunAngles(std::ostream &outputData,    /*!< Where to write the results.                */
+                   const std::string &prefix,   /*!< Written at the start of every line.        */
+                   const double &prog_start,    /*!< Progress at start, in percent.             */
+                   const double &prog_step      /*!< Progress for all angles, in percent.       */);
+
 	bool next_commandline(std::istream &in, std::string &cmd_line);
     bool next_command(const std::string &line);
 
@@ -73,6 +122,64 @@ private:
 
     std::string anglefile;
     std::string outfile;
+
+    //! Parameters to scan. All combinations are calculated.
+    std::vector<Scan_t> scans;
+
+    //! Parameters to fit.
+    std::vector<std::string> fits;
+
+    //! File with measured peaks to fit.
+    std::string peakfile;
+
+    //! List-mode file to sort, and where to write the excitation energy of each event.
+    std::string eventfile, exfile;
+
+    //! Binning of the excitation energy histograms.
+    double histMin, histMax;
+    int histBins;
+
+    //! Acceptance of the strips, used if 'acceptance' is given.
+    Acceptance_t acceptance;
+    bool want_band;
+
+    //! True if 'channels' is given.
+    bool want_channels;
+
+    //! Excitation energies of the band, from 0 to bandMax in bandPoints steps.
+    double bandMax;
+    int bandPoints;
+
+    //! File to write the gates to, given by 'pid'.
+    std::string pidfile;
+
+    //! Range and binning of the gates.
+    double pidMaxdE, pidMaxE;
+    int pidBins;
+
+    //! Resolution of the telescope for the gates.
+    PIDGates::Resolution_t pidResolution;
+
+    //! Fragments to make gates for, given by 'gate'.
+    std::vector<std::pair<int, int> > gateFragments;
+
+    //! File to write the kinematics map to, given by 'kinmap'.
+    std::string mapfile;
+
+    //! Grid of the kinematics map, angles in [rad].
+    double mapThetaMin, mapThetaMax, mapExMax;
+    int mapNTheta, mapNEx;
+
+    //! Number of adaptively placed points of each curve and the relative
+    //! bend they resolve, given by 'points'.
+    int curvePoints;
+    double curveTolerance;
+
+    //! True if range tables are used for the telescope layers, given by 'tables'.
+    bool layerTables;
+
+    //! Precision of the stopping powers, given by 'precision'.
+    StoppingModel::Precision_t precision;
 };
 
 #endif // BATCHREADER
@@ -0,0 +1,107 @@
+#ifndef PIDGATES_H
+#define PIDGATES_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <QVector>
+
+class Worker;
+
+//! Class: PIDGates
+/*! Makes particle identification gates in the dE-E plane for each strip,
+ *  from the bands calculated by \ref Worker::Curve widened by the
+ *  resolution of the telescope. The plane is divided in bins x bins
+ *  cells, and each cell holds the number of the fragment whose band is
+ *  closest (in units of the resolution), 0 if no band is within the
+ *  width of the gates. A sorter can then label an event with a single
+ *  lookup, \see Label. The strips are calculated in parallel.
+ *
+ *  The file written by \ref Write holds, in the native byte order:
+ *  "QKPID001", the number of strips, fragments and bins (32 bit
+ *  unsigned), the highest dE and E in [MeV] (64 bit floats), A and Z of
+ *  each fragment (32 bit signed) and the labels (8 bit unsigned) of each
+ *  strip, with E changing fastest.
+ */
+class PIDGates
+{
+public:
+    //! Resolution of the telescope, sigma^2 = c^2 + (r*energy)^2 for each detector.
+    struct Resolution_t {
+        double dEConst;     //! Constant part for the thin detector [MeV].
+        double dERel;       //! Relative part for the thin detector.
+        double EConst;      //! Constant part for the thick detector [MeV].
+        double ERel;        //! Relative part for the thick detector.
+        double nSigma;      //! Half width of the gates in standard deviations.
+    };
+
+    //! Magic bytes at the start of a file.
+    static constexpr char MAGIC[9] = "QKPID001";
+
+    //! Constructor.
+    PIDGates(Worker *worker,        /*!< Worker calculating the bands.          */
+             const double &dEMax,   /*!< Highest energy in thin detector [MeV]. */
+             const double &EMax,    /*!< Highest energy in thick detector [MeV].*/
+             const int &bins        /*!< Number of bins along each axis.        */);
+
+    //! Set the resolution of the telescope. The default is 50 keV and 1% in both detectors, 3 sigma.
+    void setResolution(const Resolution_t &res /*!< Resolution. */);
+
+    //! Add a fragment to make gates for. Labels are given in the order added, starting at 1.
+    void addFragment(const int &A,  /*!< Mass number of the fragment.       */
+                     const int &Z   /*!< Element number of the fragment.    */);
+
+    //! Make the gates of all strips.
+    /*! \return false if there are no fragments or strips.
+     */
+    bool Build(const QVector<double> &angles    /*!< Scattering angle at the centre of each strip. */);
+
+    //! \return the label of an event, 0 if it is in no gate.
+    inline uint8_t Label(const int &strip,      /*!< Strip number.                  */
+                         const double &dE,      /*!< Energy in thin detector [MeV]. */
+                         const double &E        /*!< Energy in thick detector [MeV].*/) const
+    {
+        double x = E*scaleE, y = dE*scaledE;
+        if (strip < 0 || strip >= nStrips || !(x >= 0 && x < nBins) || !(y >= 0 && y < nBins))
+            return 0;
+        return labels[(size_t(strip)*nBins + size_t(y))*nBins + size_t(x)];
+    }
+
+    //! \return the number of cells of a strip with a label.
+    size_t GetCells(const int &strip,   /*!< Strip number.      */
+                    const uint8_t &label/*!< Label to count.    */) const;
+
+    //! Write the gates to a binary file.
+    /*! \return false if the file could not be written.
+     */
+    bool Write(const std::string &file /*!< File to write. */) const;
+
+private:
+    //! Make the gates of a strip.
+    void BuildStrip(const int &strip,       /*!< Strip number.                  */
+                    const double &angle     /*!< Scattering angle of the strip. */);
+
+    //! Worker calculating the bands.
+    Worker *worker;
+
+    //! Fragments, A and Z.
+    std::vector<std::pair<int, int> > fragments;
+
+    //! Resolution of the telescope.
+    Resolution_t resolution;
+
+    //! Range of the plane [MeV].
+    double dEMax, EMax;
+
+    //! Bins per MeV.
+    double scaledE, scaleE;
+
+    //! Number of bins along each axis, and number of strips.
+    int nBins, nStrips;
+
+    //! Labels of all strips, strips*bins*bins.
+    std::vector<uint8_t> labels;
+};
+
+#endif // PIDGATES_H
@@ -0,0 +1,102 @@
+#ifndef PEAKFITTER_H
+#define PEAKFITTER_H
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+class Worker;
+
+//! A measured peak of a known state in the telescope.
+struct Peak_t {
+    int strip;          //! Strip number, the angle is 40 + 2*strip degrees.
+    double Ex;          //! Excitation energy of the state in [MeV].
+    double dE;          //! Measured centroid in the thin detector in [MeV].
+    double E;           //! Measured centroid in the thick detector in [MeV].
+    double sigma_dE;    //! Uncertainty of dE.
+    double sigma_E;     //! Uncertainty of E.
+};
+
+//! Class: PeakFitter
+/*! Fits setup parameters (beam energy, target and detector widths) to
+ *  measured peak positions with the Levenberg-Marquardt method. The
+ *  derivatives are taken from \ref Worker::Response, and the peaks of
+ *  each strip are calculated in a thread of their own.
+ */
+class PeakFitter
+{
+public:
+    //! Constructor.
+    PeakFitter(const Worker *worker,    /*!< Worker calculating the response.           */
+               const int &fA,           /*!< Mass number of the fragment.               */
+               const int &fZ,           /*!< Element number of the fragment.            */
+               const bool &backward     /*!< True if the telescope is at backward angles. */);
+
+    //! Add a parameter to vary. The value is changed in place by \ref Fit.
+    void addParameter(const Param_t &param, /*!< Which parameter.              */
+                      double *value         /*!< The setup value to vary.      */);
+
+    //! Read peaks from file.
+    /*! Each line holds "<strip> <Ex> <dE> <E>", optionally followed by the
+     *  uncertainties "<sigma dE> <sigma E>" (default 1). Energies in [MeV].
+     *  \return false if the file could not be read.
+     */
+    bool readPeaks(const std::string &file /*!< File with the peaks. */);
+
+    //! Minimise chi^2.
+    /*! \return true if the fit converged.
+     */
+    bool Fit(const int &maxIter=100 /*!< Maximum number of iterations. */);
+
+    //! \return the number of parameters.
+    inline int GetNParams() const { return int(params.size()); }
+
+    //! \return the parameter with index i.
+    inline Param_t GetParam(const int &i) const { return params[i]; }
+
+    //! \return the value of parameter i.
+    inline double GetValue(const int &i) const { return *values[i]; }
+
+    //! \return the uncertainty of parameter i, from the covariance matrix.
+    inline double GetError(const int &i) const { return errors[i]; }
+
+    //! \return chi^2 of the last evaluation.
+    inline double GetChi2() const { return chi2; }
+
+    //! \return the number of degrees of freedom.
+    inline int GetNdf() const { return 2*int(peaks.size()) - GetNParams(); }
+
+private:
+    //! Calculate residuals and their derivatives at the current parameters.
+    /*! \return false if any peak could not be calculated.
+     */
+    bool Evaluate(std::vector<double> &r,               /*!< Weighted residuals.                */
+                  std::vector<std::vector<double> > &J  /*!< Derivatives of the residuals.      */) const;
+
+    //! Worker calculating the response.
+    const Worker *worker;
+
+    //! Fragment.
+    int fragA, fragZ;
+
+    //! Telescope at backward angles.
+    bool backward;
+
+    //! Parameters to vary.
+    std::vector<Param_t> params;
+
+    //! Values of the parameters.
+    std::vector<double *> values;
+
+    //! Uncertainties of the parameters.
+    std::vector<double> errors;
+
+    //! Measured peaks.
+    std::vector<Peak_t> peaks;
+
+    //! chi^2 at the current parameters.
+    double chi2;
+};
+
+#endif // PEAKFITTER_H
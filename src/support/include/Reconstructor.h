@@ -0,0 +1,118 @@
+#ifndef RECONSTRUCTOR_H
+#define RECONSTRUCTOR_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "StoppingModel.h"
+#include "types.h"
+
+class Particle;
+class RangeTable;
+class RelScatter;
+
+//! An event in list-mode data, as stored on file (12 bytes, native byte order).
+struct Event_t {
+    int16_t telescope;  //! Telescope number, not used for the excitation energy.
+    int16_t strip;      //! Strip number, the angle is 40 + 2*strip degrees.
+    float dE;           //! Calibrated energy in the thin detector in [MeV].
+    float E;            //! Calibrated energy in the thick detector in [MeV].
+};
+
+static_assert(sizeof(Event_t) == 12, "Event_t must match the file format");
+
+//! Class: Reconstructor
+/*! Reconstructs the excitation energy of the residual nucleus event by
+ *  event. The energy seen by the telescope is corrected back through the
+ *  absorber, the backing (or fronting at backward angles) and half the
+ *  target with range tables built once for the setup, and the excitation
+ *  energy is found from \ref Scattering::EvaluateB with the beam energy in
+ *  the middle of the target. Files are sorted in blocks shared between
+ *  all cores.
+ */
+class Reconstructor
+{
+public:
+    //! Constructor.
+    Reconstructor(Beam_t *beam,             /*!< Beam settings.                                 */
+                  Target_t *target,         /*!< Target settings.                               */
+                  Extra_t *front,           /*!< Target fronting settings.                      */
+                  Extra_t *back,            /*!< Target backing settings.                       */
+                  Telescope_t *telescope,   /*!< Telescope settings.                            */
+                  const int &fA,            /*!< Mass number of the fragment.                   */
+                  const int &fZ,            /*!< Element number of the fragment.                */
+                  const bool &backward,     /*!< True if the telescope is at backward angles.   */
+                  const StoppingModel::Precision_t &precision=StoppingModel::Exact /*!< Precision of the stopping powers. */);
+
+    //! Destructor.
+    ~Reconstructor();
+
+    Reconstructor(const Reconstructor &) = delete;
+    Reconstructor &operator=(const Reconstructor &) = delete;
+
+    //! Set the binning of the excitation energy histograms.
+    void setHistogram(const double &min,    /*!< Lower edge of the first bin in [MeV].  */
+                      const double &max,    /*!< Upper edge of the last bin in [MeV].   */
+                      const int &bins       /*!< Number of bins.                        */);
+
+    //! Excitation energy of a single event.
+    /*! \return the excitation energy in [MeV], NaN if it can not be found.
+     */
+    double Ex(const Event_t &event /*!< The event. */) const;
+
+    //! Sort a list-mode file into the histograms.
+    /*! \return false if the files could not be read or written.
+     */
+    bool Sort(const std::string &events,        /*!< File with events.                                          */
+              const std::string &output=""      /*!< If given, the excitation energy of each event is written
+                                                 *   here as a float in [MeV] (NaN if not found).               */);
+
+    //! Write the histograms, one column per strip followed by their sum.
+    void WriteHistogram(std::ostream &out /*!< Where to write. */) const;
+
+    //! \return the number of events sorted.
+    inline uint64_t GetEvents() const { return nEvents; }
+
+private:
+    //! Number of strips.
+    static const int NSTRIPS = 8;
+
+    //! Reconstruct a block of events and add them to a histogram.
+    void Reconstruct(const Event_t *events,         /*!< Events.                                        */
+                     float *ex,                     /*!< Excitation energies, one for each event.       */
+                     const size_t &n,               /*!< Number of events.                              */
+                     std::vector<uint64_t> &hist    /*!< Histogram, bins*NSTRIPS.                       */) const;
+
+    //! Particles of the reaction.
+    std::unique_ptr<Particle> beam, targetIso, fragment, residual;
+
+    //! Kinematics.
+    std::unique_ptr<RelScatter> scat;
+
+    //! Beam energy in the middle of the target.
+    double Ehalf;
+
+    //! Range tables of the fragment in the target, backing (or fronting) and absorber.
+    std::shared_ptr<RangeTable> tTarget, tBack, tAbs;
+
+    //! Scattering angle of each strip.
+    double angle[NSTRIPS];
+
+    //! Path lengths through half the target, backing and absorber for each strip, in table units.
+    double wTarget[NSTRIPS], wBack[NSTRIPS], wAbs[NSTRIPS];
+
+    //! Histogram binning.
+    double hmin, hmax;
+    int nbins;
+
+    //! Histograms of all strips, bins*NSTRIPS.
+    std::vector<uint64_t> histogram;
+
+    //! Number of events sorted.
+    uint64_t nEvents;
+};
+
+#endif // RECONSTRUCTOR_H
@@ -1,14 +1,20 @@
-
-
 #ifndef TABLEMAKERHTML_H
 #define TABLEMAKERHTML_H
 
 #include <QVector>
 #include <QString>
+#include <QStringList>
+
+class QTextStream;
 
 //! Class TableMakerHTML
-//! A class to take calculated data and
-//! creates html file with the data.
+//! A class to keep the calculated data, and to write
+//! it as a html or txt table.
+/*! The data is kept as given (the vectors are implicitly shared),
+ *  \ref ResultModel shows it in a view and \ref WriteHTML and
+ *  \ref WriteTXT write it straight to a stream. Component 0 holds the
+ *  target isotope, the others its contaminants, \see Worker::setContaminants.
+ */
 class TableMakerHTML
 {
 public:
@@ -22,47 +28,10 @@ public:
         Other       //! If Other.
     };
 
-    //! Constructor.
-    TableMakerHTML();
-
-    //! Function to reset all data.
-    inline void Reset()
-    {
-        protons.Reset();
-        cProtons.clear();
-        deutrons.Reset();
-        cDeutrons.clear();
-        tritons.Reset();
-        cTritons.clear();
-        He3s.Reset();
-        cHe3s.clear();
-        alphas.Reset();
-        cAlphas.clear();
-    }
-
-    //! Set the calculated data.
-    void setData(QVector<double> Ex,    /*!< Excitation energy.                                 */
-                 QVector<double> dE,    /*!< Energy deposited in dE detector.                   */
-                 QVector<double> d_dE,  /*!< Uncertainty in energy deposited in dE detector.    */
-                 QVector<double> E,     /*!< Energy deposited in E detector.                    */
-                 QVector<double> d_E,   /*!< Uncertainty in energy deposited in E detector.     */
-                 Particle_t what        /*!< Which particle.                                    */);
-
-    //! Set the raw curve data.
-    void setCurve(QVector<double> ex, QVector<double> x, QVector<double> y, Particle_t what);
-
-    //! Set the coefficients to the fitted Ex(e+de) curve.
-    void setCoeff(QVector<double> Coeff,    /*!< Vector containing the three coefficients.  */
-                  Particle_t what           /*!< Whitch particle.                            */);
-
-    //! Returns the created page as HTML code.
-    QString getHTMLCode();
+    //! Number of particles.
+    static const int NPARTICLES = Other + 1;
 
-    //! Returns the created page as txt file table.
-    QString getTXT();
-
-private:
-    //! Internal structure to hold data recived by the class.
+    //! Structure to hold the known states of a particle.
     struct Result_t {
         QVector<double> Ex;                 //! Excitation energy.
         QVector<double> dE;                 //! Energy in dE detector.
@@ -71,113 +40,94 @@ private:
         QVector<double> d_E;                //! Uncertainty in energy for E detector.
         bool is_set;                        //! If the data is set or not.
         Result_t() : is_set( false ){}      //! Constructor.
-        void Reset()                        //! Resets the strucure (zeroing all vectors).
-        {
-            Ex.clear();
-            dE.clear();
-            d_dE.clear();
-            E.clear();
-            d_E.clear();
-            is_set = false;
-        }
     };
 
+    //! Structure to hold the curve of a particle.
     struct Res_t {
-        QVector<double> ex;
-        QVector<double> x, y;
+        QVector<double> ex;                 //! Excitation energy.
+        QVector<double> x, y;               //! Energy in E and dE detector.
     };
 
-    //! Data for protons.
-    Result_t protons;
-
-    //! Coeff. for protons.
-    QVector<double> cProtons;
-
-    //! More data
-    Res_t protons_res;
-
-    //! Data for deutrons.
-    Result_t deutrons;
+    //! Results of one isotope of the target.
+    struct Component_t {
+        QString name;                       //! Name used in the headings, empty for the target.
+        Result_t results[NPARTICLES];       //! Known states of each particle.
+        Res_t curves[NPARTICLES];           //! Curve of each particle.
+        QVector<double> coeffs[NPARTICLES]; //! Coefficients of each particle.
+    };
 
-    //! Coeff. for deutrons.
-    QVector<double> cDeutrons;
+    //! Constructor.
+    TableMakerHTML();
 
-    //! More data
-    Res_t deutrons_res;
+    //! Function to reset all data.
+    void Reset(const QStringList &contaminants = QStringList() /*!< Names of the contaminants, if any. */);
 
-    //! Data for tritons.
-    Result_t tritons;
+    //! \return the number of components, the target and its contaminants.
+    inline int getNComponents() const { return int(components.size()); }
 
-    //! Coeff. for tritons.
-    QVector<double> cTritons;
+    //! \return the name of a component, empty for the target.
+    inline const QString &getComponentName(const int &component) const { return components[component].name; }
 
-    //! More data
-    Res_t tritons_res;
+    //! Set the calculated data.
+    void setData(const QVector<double> &Ex,     /*!< Excitation energy.                                 */
+                 const QVector<double> &dE,     /*!< Energy deposited in dE detector.                   */
+                 const QVector<double> &d_dE,   /*!< Uncertainty in energy deposited in dE detector.    */
+                 const QVector<double> &E,      /*!< Energy deposited in E detector.                    */
+                 const QVector<double> &d_E,    /*!< Uncertainty in energy deposited in E detector.     */
+                 Particle_t what,               /*!< Which particle.                                    */
+                 const int &component=0         /*!< Which component.                                   */);
 
-    //! Data for Helium-3.
-    Result_t He3s;
+    //! Set the raw curve data.
+    void setCurve(const QVector<double> &ex,    /*!< Excitation energy.                 */
+                  const QVector<double> &x,     /*!< Energy deposited in E detector.    */
+                  const QVector<double> &y,     /*!< Energy deposited in dE detector.   */
+                  Particle_t what,              /*!< Which particle.                    */
+                  const int &component=0        /*!< Which component.                   */);
 
-    //! Coeff. for helium-3.
-    QVector<double> cHe3s;
+    //! Set the coefficients to the fitted Ex(e+de) curve.
+    void setCoeff(const QVector<double> &Coeff, /*!< Vector containing the three coefficients and chi^2.    */
+                  Particle_t what,              /*!< Whitch particle.                                      */
+                  const int &component=0        /*!< Which component.                                      */);
 
-    //! More data
-    Res_t He3s_res;
+    //! \return the known states of a particle.
+    inline const Result_t &getResult(Particle_t what, const int &component=0) const { return components[component].results[what]; }
 
-    //! Data for alphas.
-    Result_t alphas;
+    //! \return the curve of a particle.
+    inline const Res_t &getCurve(Particle_t what, const int &component=0) const { return components[component].curves[what]; }
 
-    //! Coeff. for alphas.
-    QVector<double> cAlphas;
+    //! \return the coefficients of a particle, empty if not fitted.
+    inline const QVector<double> &getCoeff(Particle_t what, const int &component=0) const { return components[component].coeffs[what]; }
 
-    //! More data
-    Res_t alphas_res;
+    //! \return the name of a particle, as used in the headings.
+    static const char *Name(Particle_t what);
 
-    //! Data for other.
-    Result_t others;
+    //! Write the page as HTML code.
+    void WriteHTML(QTextStream &out /*!< Where to write. */) const;
 
-    //! Coeff. for other.
-    QVector<double> cOthers;
+    //! Write the page as a txt file table.
+    void WriteTXT(QTextStream &out /*!< Where to write. */) const;
 
-    //! More data
-    Res_t others_res;
+private:
+    //! The target followed by its contaminants.
+    QVector<Component_t> components;
 
-    //! Function to set a strucure with values.
-    inline void setResult(QVector<double> Ex,   /*!< Excitation energy.                                 */
-                          QVector<double> dE,   /*!< Energy deposited in dE detector.                   */
-                          QVector<double> d_dE, /*!< Uncertainty in energy deposited in dE detector.    */
-                          QVector<double> E,    /*!< Energy deposited in E detector.                    */
-                          QVector<double> d_E,  /*!< Uncertainty in energy deposited in E detector.     */
-                          Result_t &where       /*!< Structure to store the data.                       */)
-    {
-        where.Ex = Ex;
-        where.dE = dE;
-        where.d_dE = d_dE;
-        where.E = E;
-        where.d_E = d_E;
-        where.is_set = true;
-    }
+    //! \return the heading of a particle in a component.
+    QString Heading(const int &particle, const Component_t &component) const;
 
-    //! Function to make a table from a result structure.
-    /*! \return the html code for the table.
-     */
-    QString makeTable(Result_t what /*!< Strucure containing the data to write to table.    */);
+    //! Function to write a table from a result structure.
+    void WriteTable(QTextStream &out, const Result_t &data) const;
 
-    QString makeCurve(Res_t data);
+    //! Function to write a table from a curve.
+    void WriteCurve(QTextStream &out, const Res_t &data) const;
 
-    //! Fuction to make a table from a result structure.
-    /*! \return the txt string used for the table.
-     */
-    QString makeTableTXT(Result_t what /*!< Structure containing the data to write to table.    */);
+    //! Function to write a txt table from a result structure.
+    void WriteTableTXT(QTextStream &out, const Result_t &data) const;
 
-    //! Function to make html code from the coefficients.
-    /*! \return the html code for nice output of the coefficients.
-     */
-    QString makeCoeff(QVector<double> coeff /*!< Vector containing the coefficients.    */);
+    //! Function to write html code for the coefficients.
+    void WriteCoeff(QTextStream &out, const QVector<double> &coeff) const;
 
-    //! Function to make txt code from the coefficients.
-    /*! \return the txt string for nice output of the coefficients.
-     */
-    QString makeCoeffTXT(QVector<double> coeff /*!< Vector containing the coefficients. */);
+    //! Function to write txt for the coefficients.
+    void WriteCoeffTXT(QTextStream &out, const QVector<double> &coeff) const;
 };
 
 #endif // TABLEMAKERHTML_H
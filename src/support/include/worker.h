@@ -3,14 +3,30 @@
 
 #include <QObject>
 #include <QThread>
+#include <QVector>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 #include "CustomPower.h"
+#include "Dual.h"
+#include "RangeTable.h"
+#include "StoppingModel.h"
 #include "types.h"
 
+class Material;
+class Particle;
+
 
 //! Worker class.
 //! This class handles all of the actual calls to other object that performs the calculations.
+//! Every calculation copies the settings when it starts (\ref Snapshot), so the
+//! owner may change them between calculations without a running one seeing a mix.
+//! The settings given to the constructor are read without a lock, and must be
+//! changed in the thread of the worker. An owner in another thread, such as the
+//! GUI, hands over copies with \ref setSetup instead.
 class Worker : public QObject
 {
     Q_OBJECT
@@ -23,12 +39,119 @@ public:
            Extra_t *back,           /*!< Current target backing settings.   */
            Telescope_t *telescope   /*!< Current telescope settings.        */);
 
+    //! Constructor of a worker with settings of its own, given by \ref setSetup.
+    Worker();
+
+    //! Use a copy of the settings, contaminants included, from now on. An owner
+    //! in another thread sends it with a queued signal whenever the settings
+    //! change, and the worker takes it between calculations.
+    void setSetup(const Setup_t &setup /*!< The settings. */);
+
     //! For batch use only! The function enables the use of custom stopping power
     //! classes for the target. (eg. tabulated values).
     void setCustomTarget(CustomPower *projectile, CustomPower *fragment);
 
+    //! The contaminants of the target, calculated alongside it by \ref Run.
+    //! Their bands are sent with component i + 1 for contaminant i. The list
+    //! is copied, so an owner in another thread hands it over with a queued signal.
+    void setContaminants(const QVector<Contaminant_t> &contaminants /*!< Contaminants, empty for none. */);
+
     bool getCoeff(const double &angle, const int &fA, const int &fZ, QVector<double> &coeff);
 
+    //! Energy deposited in the telescope by a fragment, together with the
+    //! derivatives with respect to the setup parameters (\ref Param_t),
+    //! calculated in a single pass.
+    /*! \return false if the state can not be reached, or if tabulated
+     *  stopping powers are used for the target.
+     */
+    bool Response(const double &angle,  /*!< Scattering angle.                      */
+                  const int &fA,        /*!< Mass number of the fragment.           */
+                  const int &fZ,        /*!< Element number of the fragment.        */
+                  const double &Ex,     /*!< Excitation energy of the residual.     */
+                  Dual &dE,             /*!< Energy deposited in thin detector.     */
+                  Dual &E               /*!< Energy deposited in thick detector.    */) const;
+
+    //! Energy deposited in the telescope, averaged over the acceptance of a strip.
+    /*! The strip is sampled evenly across its width, and the beam spot
+     *  (a uniform disc) shifts the angle seen from the target by its
+     *  offset in the scattering plane. All samples share the range
+     *  tables of the layers, which are kept as with \ref setLayerTables.
+     *  Points that do not reach the thick detector for all samples are
+     *  set to NaN.
+     *  \return false if the reaction is not possible.
+     */
+    bool Band(const QVector<double> &Ex,        /*!< Excitation energies of the residual.                       */
+              QVector<double> &dE,              /*!< Mean energy deposited in thin detector.                    */
+              QVector<double> &E,               /*!< Mean energy deposited in thick detector.                   */
+              QVector<double> &sigma_dE,        /*!< Spread (standard deviation) of dE.                         */
+              QVector<double> &sigma_E,         /*!< Spread of E.                                               */
+              QVector<double> &sigma_Ex,        /*!< Spread of dE + E, in excitation energy at the centre angle. */
+              const double &Angle,              /*!< Scattering angle at the centre of the strip.               */
+              const double &incAngle,           /*!< Incident angle on the telescope at the centre.             */
+              const int &fA,                    /*!< Mass number of the fragment.                               */
+              const int &fZ,                    /*!< Element number of the fragment.                            */
+              const Acceptance_t &acceptance    /*!< Acceptance of the strip.                                   */);
+
+    //! Same as above, with the incident angle on the telescope of the batch mode.
+    bool Band(const QVector<double> &Ex,        /*!< Excitation energies of the residual.                       */
+              QVector<double> &dE,              /*!< Mean energy deposited in thin detector.                    */
+              QVector<double> &E,               /*!< Mean energy deposited in thick detector.                   */
+              QVector<double> &sigma_dE,        /*!< Spread (standard deviation) of dE.                         */
+              QVector<double> &sigma_E,         /*!< Spread of E.                                               */
+              QVector<double> &sigma_Ex,        /*!< Spread of dE + E, in excitation energy at the centre angle. */
+              const double &Angle,              /*!< Scattering angle at the centre of the strip.               */
+              const int &fA,                    /*!< Mass number of the fragment.                               */
+              const int &fZ,                    /*!< Element number of the fragment.                            */
+              const Acceptance_t &acceptance    /*!< Acceptance of the strip.                                   */);
+
+    //! Bands of every open two-body exit channel of the beam and target.
+    /*! The channels are found with \ref ExitChannels, and their bands are
+     *  calculated as with \ref Run, in parallel. The range tables of the
+     *  telescope layers are shared between the channels and kept as with
+     *  \ref setLayerTables. Channels reaching the thick detector at the
+     *  most angles come first, then those with the highest Q-value.
+     *  Tabulated stopping powers of the fragment are for one fragment only,
+     *  and should not be set.
+     *  \return false if the beam or target is not in the mass table.
+     */
+    bool Channels(const QVector<double> &angles,        /*!< Scattering angles.                     */
+                  std::vector<ChannelBand_t> &bands     /*!< Set to the bands of the channels.      */);
+
+    //! Function to calculate using continious excitation energy, with the
+    //! incident angle on the telescope of the batch mode. Safe to call from
+    //! several threads at once, \see PIDGates.
+    /*! \return true if reaction possible. false otherwise.
+     */
+    bool Curve(QVector<double> &Ex,     /*!< Excitation energy.                     */
+               QVector<double> &dE,     /*!< Energy deposited in thin detector.     */
+               QVector<double> &E,      /*!< Energy deposited in thick detector.    */
+               QVector<double> &coeff,  /*!< Fit of the data.                       */
+               const double &Angle,     /*!< Scattering angle.                      */
+               const int &fA,           /*!< Mass number of the fragment.           */
+               const int &fZ            /*!< Element number of the framgent.        */);
+
+    //! Use tabulated ranges for the telescope layers, \see RangeTable.
+    //! The tables depend only on the fragment and the layer material, and are
+    //! kept between calls to \ref getCoeff. Off by default, when the stopping
+    //! power is integrated for every layer.
+    void setLayerTables(const bool &use /*!< True to enable. */);
+
+    //! Sample the excitation energies of \ref Curve adaptively.
+    /*! With n > 0 at most n excitation energies are sampled, placed where
+     *  the band bends or where the fragment starts punching through, rather
+     *  than the POINTS evenly spaced ones of the default, 0. The fit then
+     *  weights the bends more than the straight parts. An interval is split
+     *  while the band bends away from the chord of its neighbours by more
+     *  than the tolerance, relative to the largest dE and E of the curve.
+     */
+    void setCurvePoints(const int &n,                   /*!< Number of points, 0 for even spacing.  */
+                        const double &tolerance = 1e-4  /*!< Relative bend to resolve.              */);
+
+    //! Precision of the stopping powers of this worker's calculations,
+    //! \see StoppingModel. Exact by default, whatever is set for the whole
+    //! program, so a batch file does not change the calculations of the GUI.
+    void setPrecision(const StoppingModel::Precision_t &prec /*!< Precision. */);
+
 public slots:
 
     //! Slot to indicate that the class have to perform the calculations.
@@ -64,7 +187,8 @@ signals:
                      const QVector<double> &x,      /*!< The x-value result.    */
                      const QVector<double> &y,      /*!< The y-value result.    */
                      const QVector<double> &coeff,  /*!< Calculated fit.        */
-                     const Fragment_t &what         /*!< For what fragment.     */);
+                     const Fragment_t &what,        /*!< For what fragment.     */
+                     const int &component           /*!< 0 for the target, i + 1 for contaminant i. */);
 
     //! Emitting the result of calculations for discrete points, \see Known.
     void ResultScatter(const QVector<double> &x,    /*!< The x-value result.        */
@@ -72,7 +196,11 @@ signals:
                        const QVector<double> &y,    /*!< The y-value result.        */
                        const QVector<double> &dy,   /*!< Unvertainty in y-value.    */
                        const QVector<double> &ex,   /*!< Excitation energy.         */
-                       const Fragment_t &what       /*!< Indicating the fragment.   */);
+                       const Fragment_t &what,      /*!< Indicating the fragment.   */
+                       const int &component         /*!< 0 for the target, i + 1 for contaminant i. */);
+
+    //! Emitting a summary of where the time of \ref Run went so far, after each fragment, \see Profiler.
+    void Profiled(const QString &summary /*!< Table of the stages and counters, followed by the time of each fragment. */);
 
     //! Signal emitted when all calculations are complete.
     void FinishedAll();
@@ -80,6 +208,11 @@ signals:
     void curr_prog(double);
 
 private:
+    //! Copy of the current settings.
+    /*! \return the beam, target, fronting, backing and telescope as they are now.
+     */
+    Setup_t Snapshot() const;
+
     //! The current beam.
     Beam_t *theBeam;
 
@@ -95,23 +228,48 @@ private:
     //! The current telescope.
     Telescope_t *theTelescope;
 
+    //! Contaminants of the target.
+    QVector<Contaminant_t> theContaminants;
+
+    //! Settings of the worker itself, \see setSetup.
+    Setup_t ownSetup;
+
     std::unique_ptr<CustomPower> proCustom;
     std::unique_ptr<CustomPower> fragCustom;
     bool haveCpro, haveCfrag;
 
-    //! Function to calculate using continious excitation energy.
-    /*! \return true if reaction possible. false otherwise.
+    //! True if range tables should be used for the telescope layers.
+    bool useLayerTables;
+
+    //! Number of adaptively placed points of a curve, 0 for evenly spaced.
+    int curvePoints;
+
+    //! Relative bend of the band to resolve with the adaptive points.
+    double curveTolerance;
+
+    //! Precision of the stopping powers made.
+    StoppingModel::Precision_t precision;
+
+    //! Range tables of the telescope layers, keyed on fragment A, Z, layer Z, A,
+    //! the unit of the widths of the table and the precision of the stopping powers.
+    std::map<std::tuple<int, int, int, int, int, int>, std::shared_ptr<RangeTable> > layerTables;
+
+    //! Guards layerTables when several channels are calculated at once.
+    std::mutex tableMutex;
+
+    //! Get the range table of a fragment in a telescope layer.
+    /*! \return the table, built if not cached or if it does not reach Emax.
      */
-    bool Curve(QVector<double> &Ex,     /*!< Excitation energy.                     */
-               QVector<double> &dE,     /*!< Energy deposited in thin detector.     */
-               QVector<double> &E,      /*!< Energy deposited in thick detector.    */
-               QVector<double> &coeff,  /*!< Fit of the data.                       */
-               const double &Angle,     /*!< Scattering angle.                      */
-               const int &fA,           /*!< Mass number of the fragment.           */
-               const int &fZ            /*!< Element number of the framgent.        */);
+    std::shared_ptr<RangeTable> LayerTable(Particle *fragment,  /*!< Fragment passing the layer.                */
+                                           Material *layer,     /*!< Layer (with width).                        */
+                                           const double &Emax,  /*!< Highest energy of the fragment.            */
+                                           double &width        /*!< Set to the width in the units of the table. */);
 
     //! Function to calculate using continious excitation energy.
-    /*! \return true if reaction possible. false otherwise.
+    /*! The excitation energies are sampled between the thresholds where
+     *  the fragment stops in the thin detector and where it leaves too
+     *  little energy in the thick detector after punching through.
+     *  \return true if reaction possible. false otherwise.
      */
     bool Curve(QVector<double> &Ex,     /*!< Excitation energy.                     */
                QVector<double> &dE,     /*!< Energy deposited in thin detector.     */
@@ -120,7 +278,8 @@ private:
                const double &Angle,     /*!< Scattering angle.                      */
                const double &incAngle,  /*!< Incident angle on telescope.           */
                const int &fA,           /*!< Mass number of the fragment.           */
-               const int &fZ            /*!< Element number of the framgent.        */);
+               const int &fZ,           /*!< Element number of the framgent.        */
+               const int &component=0   /*!< Isotope reacting, see \ref ResultCurve. */);
 
     //! Function to calculate using known states in the residual nucleus.
     /*! \return true if reaction possible. false otherwise.
@@ -145,7 +304,8 @@ private:
                const double &Angle,         /*!< Scattering angle.              */
                const double &incAngle,      /*!< Incident angle on telescope.   */
                const int &fA,               /*!< Mass number of fragment.       */
-               const int &fZ                /*!< Element number of fragment.    */);
+               const int &fZ,               /*!< Element number of fragment.    */
+               const int &component=0       /*!< Isotope reacting, see \ref ResultCurve. */);
 
 };
 
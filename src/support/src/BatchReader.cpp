@@ -1,9 +1,16 @@
 #include "BatchReader.h"
+#include "KinematicsMap.h"
+#include "Particle.h"
+#include "PeakFitter.h"
+#include "Reconstructor.h"
+#include "Profiler.h"
+#include "StoppingModel.h"
 
 #include <istream>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <chrono>
 #include <QVector>
 //#include <algorithm>
 
@@ -48,13 +55,50 @@ BatchReader::BatchReader()
     , angleIndices( 0 )
     , want_SiRi( true )
     , dir_siri( 'f' )
+    , histMin( -2 )
+    , histMax( 20 )
+    , histBins( 2200 )
+    , want_band( false )
+    , want_channels( false )
+    , bandMax( 10 )
+    , bandPoints( 21 )
+    , pidMaxdE( 0 )
+    , pidMaxE( 0 )
+    , pidBins( 0 )
+    , pidResolution( {0.05, 0.01, 0.05, 0.01, 3} )
+    , mapThetaMin( 0 )
+    , mapThetaMax( 0 )
+    , mapExMax( 0 )
+    , mapNTheta( 0 )
+    , mapNEx( 0 )
+    , curvePoints( 0 )
+    , curveTolerance( 1e-4 )
+    , layerTables( false )
+    , precision( StoppingModel::Exact )
 {
 }
 
 void BatchReader::Start(const QString &batchFile)
 {
     if (readBatchFile(batchFile.toStdString())){
-        Run();
+        Profiler::Report_t start = Profiler::Get();
+        auto wallStart = std::chrono::steady_clock::now();
+        if (!eventfile.empty())
+            RunSort();
+        else if (want_band)
+            RunBand();
+        else if (want_channels)
+            RunChannels();
+        else if (!pidfile.empty())
+            RunGates();
+        else if (!mapfile.empty())
+            RunMap();
+        else if (fits.empty())
+            Run();
+        else
+            RunFit();
+        std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+        WriteProfile(Profiler::Get() - start, wall.count());
     } else {
         // Add something that notifies the user that something went horrobly wrong.
     }
@@ -73,14 +117,63 @@ BatchReader::~BatchReader()
         delete worker;
 }
 
+void BatchReader::WriteProfile(const Profiler::Report_t &report, const double &wall)
+{
+    std::string file = outfile + ".profile";
+    std::ofstream output(file.c_str());
+    if (!output){
+        std::cerr << "Unable to write profile '" << file << "'" << std::endl;
+        return;
+    }
+    output << "# Profile of '" << outfile << "'\n";
+    output << "fragment " << fragA << " " << fragZ << "\n";
+    output << "wall " << wall << "\n";
+    Profiler::Write(output, report);
+}
+
 void BatchReader::Run()
 {
-    std::ifstream inputAngle(anglefile.c_str());
     std::ofstream outputData(outfile.c_str());
+    if (scans.empty()){
+        outputData << "<index> <a0> <a1> <a2> <chiSq>\n";
+        RunAngles(outputData, "", 0, 100);
+        outputData.close();
+        return;
+    }
+
+    // The first scan varies slowest, the last fastest.
+    int total = 1;
+    for (size_t s = 0 ; s < scans.size() ; ++s){
+        outputData << "<" << scans[s].name << "> ";
+        total *= scans[s].n;
+    }
+    outputData << "<index> <a0> <a1> <a2> <chiSq>\n";
+
+    std::vector<int> idx(scans.size());
+    for (int k = 0 ; k < total ; ++k){
+        int rest = k;
+        for (int s = int(scans.size()) - 1 ; s >= 0 ; --s){
+            idx[s] = rest % scans[s].n;
+            rest /= scans[s].n;
+        }
+        std::ostringstream prefix;
+        for (size_t s = 0 ; s < scans.size() ; ++s){
+            const Scan_t &scan = scans[s];
+            *scan.value = (scan.n > 1) ? scan.min + idx[s]*(scan.max - scan.min)/double(scan.n - 1) : scan.min;
+            prefix << *scan.value << " ";
+        }
+        std::cout << "Running scan point: " << prefix.str() << std::endl;
+        RunAngles(outputData, prefix.str(), 100*double(k)/double(total), 100/double(total));
+    }
+    outputData.close();
+}
+
+void BatchReader::RunAngles(std::ostream &outputData, const std::string &prefix, const double &prog_start, const double &prog_step)
+{
+    std::ifstream inputAngle(anglefile.c_str());
     double x;
     int i, j, k=0;
     QVector<double> coef(4);
-    outputData << "<index> <a0> <a1> <a2> <chiSq>\n";
     size_t length = count_line(inputAngle);
     if (want_SiRi){
         double angle;
@@ -89,15 +182,15 @@ void BatchReader::Run()
             if (dir_siri == 'b')
                 angle = PI - angle;
             if (worker->getCoeff(angle, fragA, fragZ, coef)){
-                outputData << i << " ";
+                outputData << prefix << i << " ";
                 outputData << coef[0] << " ";
                 outputData << coef[1] << " ";
                 outputData << coef[2] << " ";
                 outputData << coef[3] << "\n";
             } else {
-                outputData << i << " 0 0 0 0\n";
+                outputData << prefix << i << " 0 0 0 0\n";
             }
-            emit curr_prog(100*double(i+1)/8.);
+            emit curr_prog(prog_start + prog_step*double(i+1)/8.);
         }
     } else {
         while (inputAngle){
@@ -105,51 +198,250 @@ void BatchReader::Run()
                 inputAngle >> x;
                 std::cout << "Running angle: " << x << std::endl;
                 if (worker->getCoeff(x, fragA, fragZ, coef)){
-                    outputData << x << " ";
+                    outputData << prefix << x << " ";
                     outputData << coef[0] << " ";
                     outputData << coef[1] << " ";
                     outputData << coef[2] << " ";
                     outputData << coef[3] << "\n";
                 } else {
-                    outputData << x << " 0 0 0 0\n";
+                    outputData << prefix << x << " 0 0 0 0\n";
                 }
             } else if (angleIndices == 1){
                 inputAngle >> i;
                 inputAngle >> x;
                 std::cout << "Running angle: " << x << std::endl;
                 if (worker->getCoeff(x, fragA, fragZ, coef)){
-                    outputData << i << " ";
+                    outputData << prefix << i << " ";
                     outputData << coef[0] << " ";
                     outputData << coef[1] << " ";
                     outputData << coef[2] << " ";
                     outputData << coef[3] << "\n";
                 } else {
-                    outputData << i << " 0 0 0 0\n";
+                    outputData << prefix << i << " 0 0 0 0\n";
                 }
             } else if (angleIndices == 2){
                 inputAngle >> i >> j;
                 inputAngle >> x;
                 std::cout << "Running angle: " << x << std::endl;
                 if (worker->getCoeff(x, fragA, fragZ, coef)){
-                    outputData << i << " " << j << " ";
+                    outputData << prefix << i << " " << j << " ";
                     outputData << coef[0] << " ";
                     outputData << coef[1] << " ";
                     outputData << coef[2] << " ";
                     outputData << coef[3] << "\n";
                 } else {
-                    outputData << i << " " << j << " 0 0 0 0\n";
+                    outputData << prefix << i << " " << j << " 0 0 0 0\n";
                 }
             }
             ++k;
-            emit curr_prog(100*double(k)/double(length));
+            emit curr_prog(prog_start + prog_step*double(k)/double(length));
         }
     }
-    outputData.close();
     inputAngle.close();
-    return;
 }
 
 
+void BatchReader::RunFit()
+{
+    std::ofstream outputData(outfile.c_str());
+    PeakFitter fitter(worker, fragA, fragZ, dir_siri == 'b');
+    for (size_t i = 0 ; i < fits.size() ; ++i){
+        Param_t param;
+        double *value = Parameter(fits[i], param);
+        fitter.addParameter(param, value);
+    }
+    if (!fitter.readPeaks(peakfile)){
+        outputData << "# Unable to read peaks from '" << peakfile << "'\n";
+        outputData.close();
+        return;
+    }
+    emit curr_prog(0);
+    Profiler::Timer fitTimer(Profiler::Fitting);
+    bool converged = fitter.Fit();
+    fitTimer.Stop();
+    outputData << "# chi2 = " << fitter.GetChi2() << ", ndf = " << fitter.GetNdf();
+    outputData << ((converged) ? "\n" : ", did not converge\n");
+    outputData << "<parameter> <value> <error>\n";
+    for (int i = 0 ; i < fitter.GetNParams() ; ++i)
+        outputData << fits[i] << " " << fitter.GetValue(i) << " " << fitter.GetError(i) << "\n";
+    outputData.close();
+    emit curr_prog(100);
+}
+
+void BatchReader::RunSort()
+{
+    if (CustomPowerPro || CustomPowerFrag)
+        std::cout << "Warning: custom stopping powers are not used when sorting events." << std::endl;
+    Reconstructor sorter(theBeam, theTarget, theFront, theBack, theTelescope, fragA, fragZ, dir_siri == 'b', precision);
+    sorter.setHistogram(histMin, histMax, histBins);
+    emit curr_prog(0);
+    std::ofstream outputData(outfile.c_str());
+    if (!sorter.Sort(eventfile, exfile)){
+        outputData << "# Unable to sort '" << eventfile << "'\n";
+        outputData.close();
+        return;
+    }
+    outputData << "# " << sorter.GetEvents() << " events\n";
+    sorter.WriteHistogram(outputData);
+    outputData.close();
+    emit curr_prog(100);
+}
+
+void BatchReader::RunBand()
+{
+    std::ofstream outputData(outfile.c_str());
+    outputData << "<index> <Ex> <dE> <E> <sigma dE> <sigma E> <sigma Ex>\n";
+    QVector<double> Ex(bandPoints), dE, E, sigma_dE, sigma_E, sigma_Ex;
+    for (int i = 0 ; i < bandPoints ; ++i)
+        Ex[i] = (bandPoints > 1) ? i*bandMax/double(bandPoints - 1) : 0;
+    for (int i = 0 ; i < 8 ; ++i){
+        double angle = (i*2. + 40.)*PI/180.;
+        if (dir_siri == 'b')
+            angle = PI - angle;
+        if (worker->Band(Ex, dE, E, sigma_dE, sigma_E, sigma_Ex, angle, fragA, fragZ, acceptance)){
+            for (int j = 0 ; j < bandPoints ; ++j){
+                if (E[j] != E[j])
+                    continue;
+                outputData << i << " " << Ex[j] << " " << dE[j] << " " << E[j] << " ";
+                outputData << sigma_dE[j] << " " << sigma_E[j] << " " << sigma_Ex[j] << "\n";
+            }
+        }
+        emit curr_prog(100*double(i+1)/8.);
+    }
+    outputData.close();
+}
+
+void BatchReader::RunChannels()
+{
+    std::ofstream outputData(outfile.c_str());
+    if (CustomPowerFrag){
+        outputData << "# Custom stopping powers of the fragment can not be used when scanning channels\n";
+        outputData.close();
+        return;
+    }
+
+    QVector<double> angles;
+    if (want_SiRi){
+        for (int i = 0 ; i < 8 ; ++i)
+            angles.push_back((dir_siri == 'b') ? PI - (i*2. + 40.)*PI/180. : (i*2. + 40.)*PI/180.);
+    } else {
+        std::ifstream inputAngle(anglefile.c_str());
+        double x;
+        int i;
+        while (inputAngle){
+            for (int k = 0 ; k < angleIndices ; ++k)
+                inputAngle >> i;
+            if (inputAngle >> x)
+                angles.push_back(x);
+        }
+    }
+
+    emit curr_prog(0);
+    std::vector<ChannelBand_t> bands;
+    if (!worker->Channels(angles, bands)){
+        outputData << "# Beam or target not in the mass table\n";
+        outputData.close();
+        return;
+    }
+    outputData << "# " << bands.size() << " open channels, " << angles.size() << " angles\n";
+    outputData << "<A> <Z> <residual A> <residual Z> <Q> <angles> <Ex min> <Ex max> <dE min> <dE max> <E min> <E max>\n";
+    for (const ChannelBand_t &band : bands){
+        outputData << band.A << " " << band.Z << " " << band.resA << " " << band.resZ << " " << band.Q << " " << band.angles;
+        if (band.angles > 0){
+            outputData << " " << band.ExMin << " " << band.ExMax << " " << band.dEMin << " " << band.dEMax;
+            outputData << " " << band.EMin << " " << band.EMax << "\n";
+        } else {
+            outputData << " 0 0 0 0 0 0\n";
+        }
+    }
+    outputData.close();
+    emit curr_prog(100);
+}
+
+void BatchReader::RunGates()
+{
+    std::ofstream outputData(outfile.c_str());
+    PIDGates gates(worker, pidMaxdE, pidMaxE, pidBins);
+    gates.setResolution(pidResolution);
+    std::vector<std::pair<int, int> > frags = gateFragments;
+    if (frags.empty())
+        frags = {{1, 1}, {2, 1}, {3, 1}, {3, 2}, {4, 2}};
+    if (CustomPowerFrag && frags.size() > 1){
+        outputData << "# Custom stopping powers of the fragment can not be used for more than one gate\n";
+        outputData.close();
+        return;
+    }
+    for (const auto &frag : frags)
+        gates.addFragment(frag.first, frag.second);
+
+    QVector<double> angles;
+    for (int i = 0 ; i < 8 ; ++i)
+        angles.push_back((dir_siri == 'b') ? PI - (i*2. + 40.)*PI/180. : (i*2. + 40.)*PI/180.);
+
+    emit curr_prog(0);
+    if (!gates.Build(angles) || !gates.Write(pidfile)){
+        outputData << "# Unable to make the gates '" << pidfile << "'\n";
+        outputData.close();
+        return;
+    }
+    outputData << "# Gates written to '" << pidfile << "', " << pidBins << "x" << pidBins << " bins\n";
+    outputData << "<strip> <label> <A> <Z> <cells>\n";
+    for (int i = 0 ; i < angles.size() ; ++i){
+        for (size_t f = 0 ; f < frags.size() ; ++f){
+            outputData << i << " " << f + 1 << " " << frags[f].first << " " << frags[f].second << " ";
+            outputData << gates.GetCells(i, uint8_t(f + 1)) << "\n";
+        }
+    }
+    outputData.close();
+    emit curr_prog(100);
+}
+
+void BatchReader::RunMap()
+{
+    std::ofstream outputData(outfile.c_str());
+    Particle beam(proZ, proA), target(tZ, tA), fragment(fragZ, fragA), residual(proZ + tZ - fragZ, proA + tA - fragA);
+    KinematicsMap map;
+    emit curr_prog(0);
+    if (!map.Make(&beam, &target, &fragment, &residual, proE, mapThetaMin, mapThetaMax, mapNTheta, mapExMax, mapNEx) || !map.Write(mapfile)){
+        outputData << "# Unable to make the kinematics map '" << mapfile << "'\n";
+        outputData.close();
+        return;
+    }
+
+    // The highest excitation energy reached at each angle.
+    outputData << "# Kinematics map written to '" << mapfile << "', " << mapNTheta << "x" << mapNEx << " points\n";
+    outputData << "<theta> <Ex max> <E fragment at Ex = 0>\n";
+    for (int i = 0 ; i < map.GetNTheta() ; ++i){
+        int j = 0;
+        while (j + 1 < map.GetNEx() && map.GetValue(i, j + 1, 0) == map.GetValue(i, j + 1, 0))
+            ++j;
+        outputData << map.GetTheta(i)*180./PI << " " << map.GetEx(j) << " " << map.GetValue(i, 0, 0) << "\n";
+    }
+    outputData.close();
+    emit curr_prog(100);
+}
+
+double *BatchReader::Parameter(const std::string &name, Param_t &param)
+{
+    if (name == "beam_energy"){
+        param = BeamEnergy;
+        return &theBeam->E;
+    } else if (name == "target_width"){
+        param = TargetWidth;
+        return &theTarget->width;
+    } else if (name == "dE_width"){
+        param = dEWidth;
+        return &theTelescope->dEdetector.width;
+    } else if (name == "E_width"){
+        param = EWidth;
+        return &theTelescope->Edetector.width;
+    } else if (name == "absorber_width"){
+        param = AbsorberWidth;
+        return &theTelescope->Absorber.width;
+    }
+    return nullptr;
+}
+
 bool BatchReader::next_command(const std::string &cmd)
 {
     std::istringstream icmd(cmd.c_str());
@@ -208,12 +500,12 @@ bool BatchReader::next_command(const std::string &cmd)
             icmd >> tmp2;
             tStopPro = new CustomPower(tmp2);
             CustomPowerPro = true;
-            return true;
+            return tStopPro->IsValid();
         } else if (tmp1 == "fragment"){
             icmd >> tmp2;
             tStopFrag = new CustomPower(tmp2);
             CustomPowerFrag = true;
-            return true;
+            return tStopFrag->IsValid();
         }
     } else if (name == "projectile"){
         icmd >> proA;
@@ -238,6 +530,124 @@ bool BatchReader::next_command(const std::string &cmd)
             tU = Unit_t::mgcm2;
         }
         return true;
+    } else if (name == "scan"){
+        Scan_t scan;
+        icmd >> scan.name;
+        icmd >> scan.min;
+        icmd >> scan.max;
+        icmd >> scan.n;
+        if (!icmd || scan.n < 1)
+            return false;
+        Param_t param;
+        scan.value = Parameter(scan.name, param);
+        if (!scan.value)
+            return false;
+        scans.push_back(scan);
+        return true;
+    } else if (name == "fit"){
+        std::string tmp;
+        Param_t param;
+        icmd >> tmp;
+        if (!Parameter(tmp, param))
+            return false;
+        fits.push_back(tmp);
+        return true;
+    } else if (name == "peaks"){
+        icmd >> peakfile;
+        return true;
+    } else if (name == "sort"){
+        icmd >> eventfile;
+        icmd >> exfile;
+        return !eventfile.empty();
+    } else if (name == "acceptance"){
+        double width;
+        icmd >> width;
+        icmd >> acceptance.spotRadius;
+        icmd >> acceptance.distance;
+        icmd >> bandMax;
+        icmd >> bandPoints;
+        acceptance.stripWidth = width*PI/180.;
+        bool ok = icmd && bandPoints > 0 && acceptance.distance > 0;
+
+        // Samples across the strip and the beam spot, 7 of each if not given.
+        int n;
+        acceptance.nAngle = 7;
+        acceptance.nSpot = 7;
+        if (icmd >> n){
+            acceptance.nAngle = n;
+            if (icmd >> n)
+                acceptance.nSpot = n;
+        }
+        icmd >> std::ws;
+        want_band = true;
+        return ok && icmd.eof() && acceptance.nAngle > 0 && acceptance.nSpot > 0;
+    } else if (name == "precision"){
+        std::string tmp;
+        icmd >> tmp;
+        if (tmp == "exact")
+            precision = StoppingModel::Exact;
+        else if (tmp == "fast")
+            precision = StoppingModel::Fast;
+        else
+            return false;
+        return true;
+    } else if (name == "tables"){
+        std::string tmp;
+        icmd >> tmp;
+        if (tmp == "on")
+            layerTables = true;
+        else if (tmp == "off")
+            layerTables = false;
+        else
+            return false;
+        return true;
+    } else if (name == "points"){
+        icmd >> curvePoints;
+        bool ok = icmd && curvePoints >= 0;
+
+        // Relative bend to resolve, 1e-4 if not given.
+        double tol;
+        curveTolerance = 1e-4;
+        if (icmd >> tol)
+            curveTolerance = tol;
+        icmd >> std::ws;
+        return ok && icmd.eof() && curveTolerance > 0;
+    } else if (name == "channels"){
+        want_channels = true;
+        return true;
+    } else if (name == "pid"){
+        icmd >> pidfile;
+        icmd >> pidBins;
+        icmd >> pidMaxdE;
+        icmd >> pidMaxE;
+        return icmd && !pidfile.empty() && pidBins > 0 && pidMaxdE > 0 && pidMaxE > 0;
+    } else if (name == "kinmap"){
+        icmd >> mapfile;
+        icmd >> mapThetaMin;
+        icmd >> mapThetaMax;
+        icmd >> mapNTheta;
+        icmd >> mapExMax;
+        icmd >> mapNEx;
+        mapThetaMin *= PI/180.;
+        mapThetaMax *= PI/180.;
+        return icmd && !mapfile.empty() && mapNTheta > 0 && mapNEx > 0 && mapExMax >= 0;
+    } else if (name == "gate"){
+        int A, Z;
+        icmd >> A;
+        icmd >> Z;
+        if (!icmd || A < 1 || Z < 1)
+            return false;
+        gateFragments.push_back(std::make_pair(A, Z));
+        return true;
+    } else if (name == "resolution"){
+        PIDGates::Resolution_t &res = pidResolution;
+        icmd >> res.dEConst >> res.dERel >> res.EConst >> res.ERel >> res.nSigma;
+        return icmd && res.nSigma > 0;
+    } else if (name == "histogram"){
+        icmd >> histMin;
+        icmd >> histMax;
+        icmd >> histBins;
+        return icmd && histBins > 0 && histMax > histMin;
     } else if (name == "angle"){
         std::string tmp;
         icmd >> tmp;
@@ -262,6 +672,9 @@ bool BatchReader::next_command(const std::string &cmd)
 
 bool BatchReader::readBatchFile(const std::string &batchFile)
 {
+    // The precision is chosen for each file, exact unless asked for.
+    precision = StoppingModel::Exact;
+
     std::ifstream batch_file(batchFile.c_str());
     std::string batch_line;
     while (next_commandline(batch_file, batch_line)){
@@ -305,6 +718,9 @@ bool BatchReader::readBatchFile(const std::string &batchFile)
 
     worker = new Worker(theBeam, theTarget, theFront, theBack, theTelescope);
     worker_set = true;
+    worker->setLayerTables(layerTables);
+    worker->setCurvePoints(curvePoints, curveTolerance);
+    worker->setPrecision(precision);
     if (CustomPowerPro && CustomPowerFrag){
         worker->setCustomTarget(tStopPro, tStopFrag);
     }
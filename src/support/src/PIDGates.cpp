@@ -0,0 +1,135 @@
+#include "PIDGates.h"
+
+#include "worker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+PIDGates::PIDGates(Worker *worker, const double &dEMax, const double &EMax, const int &bins)
+    : worker( worker )
+    , resolution( {0.05, 0.01, 0.05, 0.01, 3} )
+    , dEMax( dEMax )
+    , EMax( EMax )
+    , scaledE( bins/dEMax )
+    , scaleE( bins/EMax )
+    , nBins( bins )
+    , nStrips( 0 )
+{
+}
+
+void PIDGates::setResolution(const Resolution_t &res)
+{
+    resolution = res;
+}
+
+void PIDGates::addFragment(const int &A, const int &Z)
+{
+    if (fragments.size() >= 255){
+        std::cerr << "Too many fragments for the gates, " << A << " " << Z << " ignored." << std::endl;
+        return;
+    }
+    fragments.push_back(std::make_pair(A, Z));
+}
+
+bool PIDGates::Build(const QVector<double> &angles)
+{
+    if (fragments.empty() || angles.isEmpty() || nBins < 1)
+        return false;
+    nStrips = int(angles.size());
+    labels.assign(size_t(nStrips)*nBins*nBins, 0);
+
+    // Each thread takes the next strip not yet done.
+    unsigned nthreads = std::thread::hardware_concurrency();
+    if (nthreads == 0)
+        nthreads = 1;
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0 ; t < nthreads && int(t) < nStrips ; ++t){
+        threads.push_back(std::thread([this, &angles, &next](){
+            for (int i = next++ ; i < nStrips ; i = next++)
+                BuildStrip(i, angles[i]);
+        }));
+    }
+    for (auto &thread : threads)
+        thread.join();
+    return true;
+}
+
+void PIDGates::BuildStrip(const int &strip, const double &angle)
+{
+    uint8_t *cells = labels.data() + size_t(strip)*nBins*nBins;
+
+    // Distance to the closest band so far, in standard deviations.
+    std::vector<float> closest(size_t(nBins)*nBins, std::numeric_limits<float>::infinity());
+    auto Sigma = [](const double &c, const double &r, const double &energy, const double &bin){
+        return std::max(sqrt(c*c + r*energy*r*energy), 0.5*bin);
+    };
+
+    QVector<double> ex, dE, E, coeff;
+    for (size_t f = 0 ; f < fragments.size() ; ++f){
+        if (!worker->Curve(ex, dE, E, coeff, angle, fragments[f].first, fragments[f].second))
+            continue;
+        for (int k = 0 ; k < E.size() ; ++k){
+            // Segment from point k to the next, a single point at the end.
+            int l = (k + 1 < E.size()) ? k + 1 : k;
+            if (!std::isfinite(E[k] + dE[k] + E[l] + dE[l]) || (l == k && k > 0))
+                continue;
+            double sE = Sigma(resolution.EConst, resolution.ERel, 0.5*(E[k] + E[l]), 1/scaleE);
+            double sdE = Sigma(resolution.dEConst, resolution.dERel, 0.5*(dE[k] + dE[l]), 1/scaledE);
+            double w = resolution.nSigma;
+
+            int x0 = std::max(int(floor((std::min(E[k], E[l]) - w*sE)*scaleE)), 0);
+            int x1 = std::min(int(ceil((std::max(E[k], E[l]) + w*sE)*scaleE)), nBins - 1);
+            int y0 = std::max(int(floor((std::min(dE[k], dE[l]) - w*sdE)*scaledE)), 0);
+            int y1 = std::min(int(ceil((std::max(dE[k], dE[l]) + w*sdE)*scaledE)), nBins - 1);
+            double dx = (E[l] - E[k])/sE, dy = (dE[l] - dE[k])/sdE;
+            double len2 = dx*dx + dy*dy;
+            for (int y = y0 ; y <= y1 ; ++y){
+                double py = ((y + 0.5)/scaledE - dE[k])/sdE;
+                for (int x = x0 ; x <= x1 ; ++x){
+                    double px = ((x + 0.5)/scaleE - E[k])/sE;
+                    double t = (len2 > 0) ? std::clamp((px*dx + py*dy)/len2, 0., 1.) : 0.;
+                    float d = float(hypot(px - t*dx, py - t*dy));
+                    size_t i = size_t(y)*nBins + x;
+                    if (d < w && d < closest[i]){
+                        closest[i] = d;
+                        cells[i] = uint8_t(f + 1);
+                    }
+                }
+            }
+        }
+    }
+}
+
+size_t PIDGates::GetCells(const int &strip, const uint8_t &label) const
+{
+    if (strip < 0 || strip >= nStrips)
+        return 0;
+    auto first = labels.begin() + size_t(strip)*nBins*nBins;
+    return size_t(std::count(first, first + size_t(nBins)*nBins, label));
+}
+
+bool PIDGates::Write(const std::string &file) const
+{
+    std::ofstream output(file.c_str(), std::ios::binary);
+    if (!output){
+        std::cerr << "Unable to open gate file '" << file << "'" << std::endl;
+        return false;
+    }
+    uint32_t header[3] = {uint32_t(nStrips), uint32_t(fragments.size()), uint32_t(nBins)};
+    double range[2] = {dEMax, EMax};
+    output.write(MAGIC, 8);
+    output.write(reinterpret_cast<const char *>(header), sizeof(header));
+    output.write(reinterpret_cast<const char *>(range), sizeof(range));
+    for (const auto &fragment : fragments){
+        int32_t AZ[2] = {fragment.first, fragment.second};
+        output.write(reinterpret_cast<const char *>(AZ), sizeof(AZ));
+    }
+    output.write(reinterpret_cast<const char *>(labels.data()), labels.size());
+    return bool(output);
+}
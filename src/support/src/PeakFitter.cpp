@@ -0,0 +1,192 @@
+#include "PeakFitter.h"
+
+#include "worker.h"
+#include "Matrix.h"
+#include "Vector.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+const double PI = acos(-1);
+
+PeakFitter::PeakFitter(const Worker *_worker, const int &fA, const int &fZ, const bool &_backward)
+    : worker( _worker )
+    , fragA( fA )
+    , fragZ( fZ )
+    , backward( _backward )
+    , chi2( 0 )
+{
+}
+
+void PeakFitter::addParameter(const Param_t &param, double *value)
+{
+    params.push_back(param);
+    values.push_back(value);
+    errors.push_back(0);
+}
+
+bool PeakFitter::readPeaks(const std::string &file)
+{
+    std::ifstream input(file.c_str());
+    if (!input){
+        std::cerr << "Unable to open peak file '" << file << "'" << std::endl;
+        return false;
+    }
+    std::string line;
+    while (getline(input, line)){
+        if (line.size() == 0 || line[0] == '#')
+            continue;
+        std::istringstream iline(line);
+        Peak_t peak;
+        if (!(iline >> peak.strip >> peak.Ex >> peak.dE >> peak.E)){
+            std::cerr << "Cannot understand peak '" << line << "'" << std::endl;
+            return false;
+        }
+        if (!(iline >> peak.sigma_dE >> peak.sigma_E)){
+            peak.sigma_dE = 1;
+            peak.sigma_E = 1;
+        }
+        peaks.push_back(peak);
+    }
+    return !peaks.empty();
+}
+
+bool PeakFitter::Evaluate(std::vector<double> &r, std::vector<std::vector<double> > &J) const
+{
+    int n = int(peaks.size());
+    r.assign(2*n, 0);
+    J.assign(2*n, std::vector<double>(params.size(), 0));
+
+    // Group the peaks by strip, and let one thread do each strip.
+    std::map<int, std::vector<int> > strips;
+    for (int i = 0 ; i < n ; ++i)
+        strips[peaks[i].strip].push_back(i);
+
+    std::vector<char> ok(n, 0);
+    std::vector<std::thread> threads;
+    for (auto &strip : strips){
+        const std::vector<int> *index = &strip.second;
+        threads.push_back(std::thread([this, index, &r, &J, &ok](){
+            for (int i : *index){
+                const Peak_t &peak = peaks[i];
+                double angle = (peak.strip*2. + 40.)*PI/180.;
+                if (backward)
+                    angle = PI - angle;
+                Dual dE, E;
+                if (!worker->Response(angle, fragA, fragZ, peak.Ex, dE, E))
+                    continue;
+                r[2*i] = (dE.value() - peak.dE)/peak.sigma_dE;
+                r[2*i+1] = (E.value() - peak.E)/peak.sigma_E;
+                for (size_t j = 0 ; j < params.size() ; ++j){
+                    J[2*i][j] = dE.deriv(params[j])/peak.sigma_dE;
+                    J[2*i+1][j] = E.deriv(params[j])/peak.sigma_E;
+                }
+                ok[i] = 1;
+            }
+        }));
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    for (int i = 0 ; i < n ; ++i){
+        if (!ok[i]){
+            std::cerr << "Peak at Ex = " << peaks[i].Ex << " MeV in strip " << peaks[i].strip << " can not be calculated." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PeakFitter::Fit(const int &maxIter)
+{
+    int np = GetNParams();
+    if (np == 0 || peaks.empty()){
+        std::cerr << "Nothing to fit." << std::endl;
+        return false;
+    }
+
+    std::vector<double> r, r_new;
+    std::vector<std::vector<double> > J, J_new;
+    if (!Evaluate(r, J))
+        return false;
+    chi2 = 0;
+    for (double v : r)
+        chi2 += v*v;
+
+    double lambda = 1e-3;
+    bool converged = false;
+    Matrix A(np, np);
+    for (int iter = 0 ; iter < maxIter && !converged ; ++iter){
+        // Normal equations, J^T J and J^T r.
+        Vector g(np, 0.0);
+        for (int j = 0 ; j < np ; ++j){
+            for (int k = 0 ; k < np ; ++k){
+                A[j][k] = 0;
+                for (size_t i = 0 ; i < r.size() ; ++i)
+                    A[j][k] += J[i][j]*J[i][k];
+            }
+            for (size_t i = 0 ; i < r.size() ; ++i)
+                g[j] += J[i][j]*r[i];
+        }
+
+        // Try steps until chi^2 decreases.
+        std::vector<double> old(np);
+        for (int j = 0 ; j < np ; ++j)
+            old[j] = *values[j];
+        bool improved = false;
+        while (!improved && lambda < 1e10){
+            Matrix B(A);
+            for (int j = 0 ; j < np ; ++j)
+                B[j][j] = A[j][j]*(1 + lambda);
+            Vector delta = B.inv()*g;
+
+            bool valid = true;
+            for (int j = 0 ; j < np ; ++j){
+                *values[j] = old[j] - delta[j];
+                if (params[j] != BeamEnergy && *values[j] < 0)
+                    valid = false;
+            }
+
+            double chi2_new = 0;
+            if (valid && Evaluate(r_new, J_new)){
+                for (double v : r_new)
+                    chi2_new += v*v;
+            } else {
+                valid = false;
+            }
+
+            if (valid && chi2_new <= chi2){
+                converged = (chi2 - chi2_new) <= 1e-8*(chi2 + 1e-12);
+                chi2 = chi2_new;
+                r.swap(r_new);
+                J.swap(J_new);
+                lambda /= 10;
+                improved = true;
+            } else {
+                for (int j = 0 ; j < np ; ++j)
+                    *values[j] = old[j];
+                lambda *= 10;
+            }
+        }
+        if (!improved)
+            converged = true; // No step reduces chi^2, we are at the minimum.
+    }
+
+    // Uncertainties from the covariance matrix (J^T J)^-1.
+    for (int j = 0 ; j < np ; ++j){
+        for (int k = 0 ; k < np ; ++k){
+            A[j][k] = 0;
+            for (size_t i = 0 ; i < r.size() ; ++i)
+                A[j][k] += J[i][j]*J[i][k];
+        }
+    }
+    Matrix cov = A.inv();
+    for (int j = 0 ; j < np ; ++j)
+        errors[j] = sqrt(fabs(cov[j][j]));
+
+    return converged;
+}
@@ -0,0 +1,208 @@
+#include "Reconstructor.h"
+
+#include "Geometry.h"
+#include "Particle.h"
+#include "Material.h"
+#include "RangeTable.h"
+#include "RelScatter.h"
+#include "StoppingModel.h"
+#include "ziegler1985_table.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+const double PI = acos(-1);
+
+Reconstructor::Reconstructor(Beam_t *theBeam, Target_t *theTarget, Extra_t *theFront, Extra_t *theBack, Telescope_t *theTelescope,
+                             const int &fA, const int &fZ, const bool &backward, const StoppingModel::Precision_t &precision)
+    : beam( new Particle(theBeam->Z, theBeam->A) )
+    , targetIso( new Particle(theTarget->Z, theTarget->A) )
+    , fragment( new Particle(fZ, fA) )
+    , residual( new Particle(theBeam->Z+theTarget->Z-fZ, theBeam->A+theTarget->A-fA) )
+    , scat( new RelScatter(beam.get(), targetIso.get(), fragment.get(), residual.get()) )
+    , nEvents( 0 )
+{
+    setHistogram(-2, 20, 2200);
+
+    // Beam energy in the middle of the target.
+    double w;
+    Ehalf = theBeam->E;
+    if (theFront->is_present){
+        Material front(theFront->Z, theFront->A, theFront->width, Geometry::MatUnit(theFront->unit));
+        Ehalf = StoppingModel::MakeTable(beam.get(), &front, Ehalf, w, precision)->Loss(Ehalf, w);
+    }
+    Material target(theTarget->Z, theTarget->A, theTarget->width, Geometry::MatUnit(theTarget->unit));
+    Ehalf = StoppingModel::MakeTable(beam.get(), &target, Ehalf, w, precision)->Loss(Ehalf, w/2.);
+
+    // The fragment never has more energy than at the most forward angle.
+    double Emax = 0;
+    for (int i = 0 ; i < NSTRIPS ; ++i){
+        angle[i] = (40 + 2*i)*PI/180.;
+        if (backward)
+            angle[i] = PI - angle[i];
+        double e = scat->EvaluateY(theBeam->E, angle[i], 0);
+        if (e > Emax)
+            Emax = e;
+    }
+
+    // Range tables, with the path lengths in the table units for each strip.
+    double wT, wB = 0, wA = 0;
+    tTarget = StoppingModel::MakeTable(fragment.get(), &target, Emax, wT, precision);
+    if (Geometry::ThroughFront(angle[0], theFront->is_present)){
+        Material front(theFront->Z, theFront->A, theFront->width, Geometry::MatUnit(theFront->unit));
+        tBack = StoppingModel::MakeTable(fragment.get(), &front, Emax, wB, precision);
+    } else if (theBack->is_present){
+        Material back(theBack->Z, theBack->A, theBack->width, Geometry::MatUnit(theBack->unit));
+        tBack = StoppingModel::MakeTable(fragment.get(), &back, Emax, wB, precision);
+    }
+    if (theTelescope->has_absorber){
+        const Telescope_t::Element_str &abs = theTelescope->Absorber;
+        Material absorber(abs.Z, Get_mm2(abs.Z), abs.width, Geometry::MatUnit(abs.unit));
+        tAbs = StoppingModel::MakeTable(fragment.get(), &absorber, Emax, wA, precision);
+    }
+    for (int i = 0 ; i < NSTRIPS ; ++i){
+        wTarget[i] = Geometry::HalfPath(wT, angle[i]);
+        wBack[i] = Geometry::Path(wB, angle[i]);
+        wAbs[i] = Geometry::TelescopePath(wA, Geometry::IncAngle(angle[i]));
+    }
+}
+
+Reconstructor::~Reconstructor() = default;
+
+void Reconstructor::setHistogram(const double &min, const double &max, const int &bins)
+{
+    hmin = min;
+    hmax = max;
+    nbins = bins;
+    histogram.assign(size_t(nbins)*NSTRIPS, 0);
+}
+
+double Reconstructor::Ex(const Event_t &event) const
+{
+    if (event.strip < 0 || event.strip >= NSTRIPS)
+        return std::numeric_limits<double>::quiet_NaN();
+    int i = event.strip;
+    double e = double(event.dE) + double(event.E);
+    if (!(e > 0))
+        return std::numeric_limits<double>::quiet_NaN();
+
+    if (tAbs)
+        e = tAbs->Gain(e, wAbs[i]);
+    if (tBack)
+        e = tBack->Gain(e, wBack[i]);
+    e = tTarget->Gain(e, wTarget[i]);
+
+    double ex, thetaB;
+    scat->EvaluateB(Ehalf, e, angle[i], ex, thetaB);
+    return ex;
+}
+
+void Reconstructor::Reconstruct(const Event_t *events, float *ex, const size_t &n, std::vector<uint64_t> &hist) const
+{
+    // The energies of the whole block are tracked back through each layer
+    // in turn, events that can not be reconstructed are NaN.
+    std::vector<double> e(n), w(n);
+    for (size_t i = 0 ; i < n ; ++i){
+        double sum = double(events[i].dE) + double(events[i].E);
+        bool ok = events[i].strip >= 0 && events[i].strip < NSTRIPS && sum > 0;
+        e[i] = (ok) ? sum : std::numeric_limits<double>::quiet_NaN();
+    }
+    auto Back = [&](const RangeTable *table, const double *width){
+        for (size_t i = 0 ; i < n ; ++i)
+            w[i] = (std::isnan(e[i])) ? 0 : width[events[i].strip];
+        table->Gain(e.data(), w.data(), e.data(), n);
+    };
+    if (tAbs)
+        Back(tAbs.get(), wAbs);
+    if (tBack)
+        Back(tBack.get(), wBack);
+    Back(tTarget.get(), wTarget);
+
+    double scale = nbins/(hmax - hmin);
+    for (size_t i = 0 ; i < n ; ++i){
+        double x = e[i], thetaB;
+        if (!std::isnan(x))
+            scat->EvaluateB(Ehalf, e[i], angle[events[i].strip], x, thetaB);
+        ex[i] = float(x);
+        x = (x - hmin)*scale;
+        if (x >= 0 && x < nbins)
+            ++hist[size_t(events[i].strip)*nbins + size_t(x)];
+    }
+}
+
+bool Reconstructor::Sort(const std::string &events, const std::string &output)
+{
+    std::ifstream input(events.c_str(), std::ios::binary);
+    if (!input){
+        std::cerr << "Unable to open event file '" << events << "'" << std::endl;
+        return false;
+    }
+    std::ofstream exOut;
+    if (!output.empty()){
+        exOut.open(output.c_str(), std::ios::binary);
+        if (!exOut){
+            std::cerr << "Unable to open output file '" << output << "'" << std::endl;
+            return false;
+        }
+    }
+
+    unsigned nthreads = std::thread::hardware_concurrency();
+    if (nthreads == 0)
+        nthreads = 1;
+    std::vector<std::vector<uint64_t> > hists(nthreads, std::vector<uint64_t>(histogram.size(), 0));
+
+    // Read blocks of events and let each thread do a part of the block.
+    const size_t BLOCK = 1 << 20;
+    std::vector<Event_t> block(BLOCK);
+    std::vector<float> ex(BLOCK);
+    while (input){
+        input.read(reinterpret_cast<char *>(block.data()), BLOCK*sizeof(Event_t));
+        size_t n = size_t(input.gcount())/sizeof(Event_t);
+        if (size_t(input.gcount()) % sizeof(Event_t) != 0)
+            std::cerr << "Warning: event file '" << events << "' ends with an incomplete event." << std::endl;
+        if (n == 0)
+            break;
+
+        size_t chunk = (n + nthreads - 1)/nthreads;
+        std::vector<std::thread> threads;
+        for (unsigned t = 0 ; t < nthreads && t*chunk < n ; ++t){
+            size_t first = t*chunk;
+            size_t count = (n - first < chunk) ? n - first : chunk;
+            threads.push_back(std::thread(&Reconstructor::Reconstruct, this, block.data() + first,
+                                          ex.data() + first, count, std::ref(hists[t])));
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        if (exOut.is_open())
+            exOut.write(reinterpret_cast<const char *>(ex.data()), n*sizeof(float));
+        nEvents += n;
+    }
+
+    for (const auto &hist : hists){
+        for (size_t i = 0 ; i < histogram.size() ; ++i)
+            histogram[i] += hist[i];
+    }
+    return !exOut.is_open() || bool(exOut);
+}
+
+void Reconstructor::WriteHistogram(std::ostream &out) const
+{
+    out << "<Ex>";
+    for (int s = 0 ; s < NSTRIPS ; ++s)
+        out << " <strip " << s << ">";
+    out << " <sum>\n";
+    double width = (hmax - hmin)/nbins;
+    for (int b = 0 ; b < nbins ; ++b){
+        uint64_t sum = 0;
+        out << hmin + (b + 0.5)*width;
+        for (int s = 0 ; s < NSTRIPS ; ++s){
+            out << " " << histogram[size_t(s)*nbins + b];
+            sum += histogram[size_t(s)*nbins + b];
+        }
+        out << " " << sum << "\n";
+    }
+}
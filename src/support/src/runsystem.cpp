@@ -9,8 +9,7 @@
 #include "DickNorbury.h"
 #include "RelScatter.h"
 #include "StoppingPower.h"
-#include "Ziegler1985.h"
-#include "BetheBlock.h"
+#include "StoppingModel.h"
 #include "ame2012_masses.h"
 
 #include <cmath>
@@ -52,52 +51,25 @@ RunSystem::~RunSystem()
 int RunSystem::Run(const double &Energy, const double &Angle) const
 {
     RelScatter  *scat = new RelScatter(beam, scatIso, fragment, residual);
-    StoppingPower *stopTargetB;
-    StoppingPower *stopTargetF;
-    StoppingPower *stopAbsor;
-    StoppingPower *stopDE;
-    StoppingPower *stopE;
-
-    if ( target->GetZ() <= 92 ){
-        stopTargetB = new Ziegler1985(target, beam);
-        stopTargetF = new Ziegler1985(target, fragment);
-    } else {
-        stopTargetB = new BetheBlock(target, beam);
-        stopTargetF = new BetheBlock(target, fragment);
-        std::cout << "Warning: Target Z= " << target->GetZ();
-        std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-        std::cout << std::endl;
-    }
-
-    if ( absorber->GetZ() <= 92 ){
-        stopAbsor = new Ziegler1985(absorber, fragment);
-    } else {
-        stopAbsor = new BetheBlock(absorber, fragment);
-        std::cout << "Warning: Absorber Z= " << absorber->GetZ();
-        std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-        std::cout << std::endl;
-    }
-
-    if ( dEmaterial->GetZ() <= 92 ){
-        stopDE = new Ziegler1985(dEmaterial, fragment);
-    } else {
-        stopDE = new BetheBlock(dEmaterial, fragment);
-        std::cout << "Warning: dE detector Z= " << dEmaterial->GetZ();
-        std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-        std::cout << std::endl;
-
-    }
-
-    if ( Ematerial->GetZ() <= 92 ){
-        stopE = new Ziegler1985(Ematerial, fragment);
-    } else {
-        stopE = new BetheBlock(Ematerial, fragment);
-        std::cout << "Warning: E detector Z= " << Ematerial->GetZ();
-        std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-        std::cout << std::endl;
+    Material::Unit tUnitB, tUnit, aUnit, dUnit, eUnit;
+    StoppingPower *stopTargetB = StoppingModel::Make(target, beam, Energy, tUnitB);
+    StoppingPower *stopTargetF = StoppingModel::Make(target, fragment, Energy, tUnit);
+    StoppingPower *stopAbsor = StoppingModel::Make(absorber, fragment, Energy, aUnit);
+    StoppingPower *stopDE = StoppingModel::Make(dEmaterial, fragment, Energy, dUnit);
+    StoppingPower *stopE = StoppingModel::Make(Ematerial, fragment, Energy, eUnit);
+
+    const std::pair<const char *, const Material *> layers[] = {
+        {"Target", target}, {"Absorber", absorber}, {"dE detector", dEmaterial}, {"E detector", Ematerial}
+    };
+    for (const auto &layer : layers){
+        if (StoppingModel::Choose(fragment, layer.second, Energy) == StoppingModel::Bethe){
+            std::cout << "Warning: " << layer.first << " Z= " << layer.second->GetZ();
+            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
+            std::cout << std::endl;
+        }
     }
 
-    double Ehalf = stopTargetB->Loss(Energy, target->GetWidth(), INTPOINTS);
+    double Ehalf = stopTargetB->Loss(Energy, target->GetWidth(tUnitB), INTPOINTS);
     double Ehole = stopTargetB->Loss(Energy, INTPOINTS);
     double Exmax = scat->FindMaxEx(Ehalf, Angle);
 
@@ -114,8 +86,8 @@ int RunSystem::Run(const double &Energy, const double &Angle) const
         m = scat->EvaluateY(Ehalf, Angle, Ex[i]);
         b = scat->EvaluateY(Ehole, Angle, Ex[i]);
 
-        f = stopTargetF->Loss(f, target->GetWidth()/fabs(cos(Angle)), INTPOINTS);
-        m = stopTargetF->Loss(m, target->GetWidth()/fabs(2*cos(Angle)), INTPOINTS);
+        f = stopTargetF->Loss(f, target->GetWidth(tUnit)/fabs(cos(Angle)), INTPOINTS);
+        m = stopTargetF->Loss(m, target->GetWidth(tUnit)/fabs(2*cos(Angle)), INTPOINTS);
 
         f = stopAbsor->Loss(f, INTPOINTS);
         m = stopAbsor->Loss(m, INTPOINTS);
@@ -1,286 +1,181 @@
 #include "tablemakerhtml.h"
 
+#include <QTextStream>
+
 #include <cmath>
 
+//! Format a number as printf's %f, as the tables have always been written.
+static inline QString num(const double &x)
+{
+    return QString::number(x, 'f', 6);
+}
+
+static const char *particleNames[TableMakerHTML::NPARTICLES] = {
+    "Protons", "Deutrons", "Tritons", "Helium-3", "Alphas", "Others"
+};
+
 TableMakerHTML::TableMakerHTML()
+    : components( 1 )
 {
 
 }
 
-void TableMakerHTML::setData(QVector<double> Ex, QVector<double> dE, QVector<double> d_dE, QVector<double> E, QVector<double> d_E, Particle_t what)
+void TableMakerHTML::Reset(const QStringList &contaminants)
 {
-    if (what == Proton){
-        setResult(Ex, dE, d_dE, E, d_E, protons);
-    } else if (what == Deutron){
-        setResult(Ex, dE, d_dE, E, d_E, deutrons);
-    } else if (what == Triton){
-        setResult(Ex, dE, d_dE, E, d_E, tritons);
-    } else if (what == Helium3){
-        setResult(Ex, dE, d_dE, E, d_E, He3s);
-    } else if (what == Alpha){
-        setResult(Ex, dE, d_dE, E, d_E, alphas);
-    } else if (what == Other){
-        setResult(Ex, dE, d_dE, E, d_E, others);
-    }
+    components = QVector<Component_t>(1 + contaminants.size());
+    for (int i = 0 ; i < contaminants.size() ; ++i)
+        components[i + 1].name = contaminants[i];
 }
 
-void TableMakerHTML::setCurve(QVector<double> ex, QVector<double> x, QVector<double> y, Particle_t what)
+QString TableMakerHTML::Heading(const int &particle, const Component_t &component) const
 {
-    if (what == Proton){
-        protons_res = {ex, x, y};
-    } else if (what == Deutron){
-        deutrons_res = {ex, x, y};
-    } else if (what == Triton){
-        tritons_res = {ex, x, y};
-    } else if (what == Helium3){
-        He3s_res = {ex, x, y};
-    } else if (what == Alpha){
-        alphas_res = {ex, x, y};
-    } else if (what == Other){
-        others_res = {ex, x, y};
-    }
+    if (component.name.isEmpty())
+        return QString(particleNames[particle]);
+    return QString("%1 from %2").arg(particleNames[particle]).arg(component.name);
 }
 
-void TableMakerHTML::setCoeff(QVector<double> Coeff, Particle_t what)
+const char *TableMakerHTML::Name(Particle_t what)
 {
-    if (what == Proton){
-        cProtons = Coeff;
-    } else if (what == Deutron){
-        cDeutrons = Coeff;
-    } else if (what == Triton){
-        cTritons = Coeff;
-    } else if (what == Helium3){
-        cHe3s = Coeff;
-    } else if (what == Alpha){
-        cAlphas = Coeff;
-    } else if (what == Other){
-        cOthers = Coeff;
-    }
+    return particleNames[what];
 }
 
-QString TableMakerHTML::getHTMLCode()
+void TableMakerHTML::setData(const QVector<double> &Ex, const QVector<double> &dE, const QVector<double> &d_dE,
+                             const QVector<double> &E, const QVector<double> &d_E, Particle_t what, const int &component)
 {
-    QString value;
-    value = QString("<html>\n<body>\n") + QString("<h1>Results:</h1>\n");
-    if (protons.is_set){
-        value += QString("<h2>Protons:</h2>\n");
-        value += makeTable(protons);
-        value += makeCurve(protons_res);
-        if (!cProtons.empty())
-            value += makeCoeff(cProtons);
-    }
-    if (deutrons.is_set){
-        value += QString("<h2>Deutrons:</h2>\n");
-        value += makeTable(deutrons);
-        value += makeCurve(deutrons_res);
-        if (!cDeutrons.empty())
-            value += makeCoeff(cDeutrons);
-    }
-    if (tritons.is_set){
-        value += QString("<h2>Tritons:</h2>\n");
-        value += makeTable(tritons);
-        value += makeCurve(tritons_res);
-        if (!cTritons.empty())
-            value += makeCoeff(cTritons);
-    }
-    if (He3s.is_set){
-        value += QString("<h2>Helium-3:</h2>\n");
-        value += makeTable(He3s);
-        value += makeCurve(He3s_res);
-        if (!cHe3s.empty())
-            value += makeCoeff(cHe3s);
-    }
-    if (alphas.is_set){
-        value += QString("<h2>Alphas:</h2>\n");
-        value += makeTable(alphas);
-        value += makeCurve(alphas_res);
-        if (!cAlphas.empty())
-            value += makeCoeff(cAlphas);
-    }
-    if (others.is_set){
-        value += QString("<h2>Others:</h2>\n");
-        value += makeTable(others);
-        value += makeCurve(others_res);
-        if (!cOthers.empty())
-            value += makeCoeff(cOthers);
-    }
-    value += "</body>\n";
-    value += "</html>";
-    return value;
+    if (component < 0 || component >= components.size())
+        return;
+    Result_t &result = components[component].results[what];
+    result.Ex = Ex;
+    result.dE = dE;
+    result.d_dE = d_dE;
+    result.E = E;
+    result.d_E = d_E;
+    result.is_set = true;
 }
 
-QString TableMakerHTML::makeTable(Result_t data)
+void TableMakerHTML::setCurve(const QVector<double> &ex, const QVector<double> &x, const QVector<double> &y, Particle_t what, const int &component)
 {
-    QString output = "";
-    output += "<table border=\"1\" style=\"width:100%\">\n";
-    output += "<tr>\n";
-    output += "<td><b>Excitation energy (keV):</b></td>\n";
-    output += "<td>Energy dE-detector (keV):</td>\n";
-    output += "<td>Energy E-detector (keV):</td>\n";
-    output += "<td>Total particle energy (keV):</td>\n";
-    output += "</tr>\n";
-    for (int i = 0 ; i < data.Ex.size() ; ++i){
-        output += "<tr>\n";
-        output += "<td>";
-        output += std::to_string(data.Ex[i]*1000).c_str();
-        output += "</td>\n";
-        output += "<td>";
-        output += std::to_string(data.dE[i]*1000).c_str();
-        output += " ± ";
-        output += std::to_string(data.d_dE[i]*1000).c_str();
-        output += "</td>\n";
-        output += "<td>";
-        output += std::to_string(data.E[i]*1000).c_str();
-        output += " ± ";
-        output += std::to_string(data.d_E[i]*1000).c_str();
-        output += "</td>\n";
-        output += "<td>";
-        output += std::to_string((data.dE[i]+data.E[i])*1000).c_str();
-        output += " ± ";
-        output += std::to_string(sqrt(data.d_dE[i]*data.d_dE[i] + data.d_E[i]*data.d_E[i])*1000).c_str();
-        output += "</td>\n";
-        output += "</tr>\n";
-    }
-    output += "</table>\n";
-    return output;
+    if (component < 0 || component >= components.size())
+        return;
+    components[component].curves[what] = {ex, x, y};
 }
 
-QString TableMakerHTML::makeCurve(Res_t data)
+void TableMakerHTML::setCoeff(const QVector<double> &Coeff, Particle_t what, const int &component)
 {
-    QString output = "";
-    output += "<table border=\"1\" style=\"width:100%\">\n";
-    output += "<tr>\n";
-    output += "<td><b>Excitation energy (keV):</b></td>\n";
-    output += "<td>Energy dE-detector (keV):</td>\n";
-    output += "<td>Energy E-detector (keV):</td>\n";
-    output += "<td>Total particle energy (keV):</td>\n";
-    output += "</tr>\n";
-    for (int i = 0 ; i < data.ex.size() ; ++i){
-        output += "<tr>\n";
-        output += "<td>";
-        output += std::to_string(data.ex[i]*1000).c_str();
-        output += "</td>\n";
-        output += "<td>";
-        output += std::to_string(data.y[i]*1000).c_str();
-        output += "</td>\n";
-        output += "<td>";
-        output += std::to_string(data.x[i]*1000).c_str();
-        output += "</td>\n";
-        output += "<td>";
-        output += std::to_string((data.y[i]+data.x[i])*1000).c_str();
-        output += "</td>\n";
-        output += "</tr>\n";
-    }
-    output += "</table>\n";
-    return output;
+    if (component < 0 || component >= components.size())
+        return;
+    components[component].coeffs[what] = Coeff;
 }
 
-QString TableMakerHTML::makeCoeff(QVector<double> coeff)
+void TableMakerHTML::WriteHTML(QTextStream &out) const
 {
-    QString output = "";
-    output += "<b>Ex(e+de) = a0 + a1(e+de) + a2(e+de)^2</b>\n";
-    output += "<p>chi-squared: ";
-    output += std::to_string(coeff[3]).c_str();
-    output += ", a0 = ";
-    output += std::to_string(coeff[0]).c_str();
-    output += " MeV, a1 = ";
-    output += std::to_string(coeff[1]).c_str();
-    output += ", a2 = ";
-    output += std::to_string(coeff[2]).c_str();
-    output += " MeV^-1</p>\n";
-    return output;
+    out << "<html>\n<body>\n" << "<h1>Results:</h1>\n";
+    for (const Component_t &c : components){
+        for (int i = 0 ; i < NPARTICLES ; ++i){
+            if (!c.results[i].is_set)
+                continue;
+            out << "<h2>" << Heading(i, c) << ":</h2>\n";
+            WriteTable(out, c.results[i]);
+            WriteCurve(out, c.curves[i]);
+            if (!c.coeffs[i].empty())
+                WriteCoeff(out, c.coeffs[i]);
+        }
+    }
+    out << "</body>\n";
+    out << "</html>";
 }
 
-QString TableMakerHTML::getTXT()
+void TableMakerHTML::WriteTable(QTextStream &out, const Result_t &data) const
 {
-    QString value = "";
+    out << "<table border=\"1\" style=\"width:100%\">\n";
+    out << "<tr>\n";
+    out << "<td><b>Excitation energy (keV):</b></td>\n";
+    out << "<td>Energy dE-detector (keV):</td>\n";
+    out << "<td>Energy E-detector (keV):</td>\n";
+    out << "<td>Total particle energy (keV):</td>\n";
+    out << "</tr>\n";
+    for (int i = 0 ; i < data.Ex.size() ; ++i){
+        out << "<tr>\n";
+        out << "<td>" << num(data.Ex[i]*1000) << "</td>\n";
+        out << "<td>" << num(data.dE[i]*1000) << " ± " << num(data.d_dE[i]*1000) << "</td>\n";
+        out << "<td>" << num(data.E[i]*1000) << " ± " << num(data.d_E[i]*1000) << "</td>\n";
+        out << "<td>" << num((data.dE[i]+data.E[i])*1000) << " ± "
+            << num(sqrt(data.d_dE[i]*data.d_dE[i] + data.d_E[i]*data.d_E[i])*1000) << "</td>\n";
+        out << "</tr>\n";
+    }
+    out << "</table>\n";
+}
 
-    value += "This file was generated by QKinz.\n\n\n";
+void TableMakerHTML::WriteCurve(QTextStream &out, const Res_t &data) const
+{
+    out << "<table border=\"1\" style=\"width:100%\">\n";
+    out << "<tr>\n";
+    out << "<td><b>Excitation energy (keV):</b></td>\n";
+    out << "<td>Energy dE-detector (keV):</td>\n";
+    out << "<td>Energy E-detector (keV):</td>\n";
+    out << "<td>Total particle energy (keV):</td>\n";
+    out << "</tr>\n";
+    for (int i = 0 ; i < data.ex.size() ; ++i){
+        out << "<tr>\n";
+        out << "<td>" << num(data.ex[i]*1000) << "</td>\n";
+        out << "<td>" << num(data.y[i]*1000) << "</td>\n";
+        out << "<td>" << num(data.x[i]*1000) << "</td>\n";
+        out << "<td>" << num((data.y[i]+data.x[i])*1000) << "</td>\n";
+        out << "</tr>\n";
+    }
+    out << "</table>\n";
+}
 
-    if (protons.is_set){
-        value += "Protons:\n";
-        value += makeTableTXT(protons);
-        if (!cProtons.empty())
-            value += makeCoeffTXT(cProtons);
-        value += "\n\n\n";
-    }
-    if (deutrons.is_set){
-        value += QString("Deutrons:\n");
-        value += makeTableTXT(deutrons);
-        if (!cDeutrons.empty())
-            value += makeCoeffTXT(cDeutrons);
-        value += "\n\n\n";
-    }
-    if (tritons.is_set){
-        value += QString("Tritons:\n");
-        value += makeTableTXT(tritons);
-        if (!cTritons.empty())
-            value += makeCoeffTXT(cTritons);
-        value += "\n\n\n";
-    }
-    if (He3s.is_set){
-        value += QString("Helium-3:\n");
-        value += makeTableTXT(He3s);
-        if (!cHe3s.empty())
-            value += makeCoeffTXT(cHe3s);
-        value += "\n\n\n";
-    }
-    if (alphas.is_set){
-        value += QString("Alphas:\n");
-        value += makeTableTXT(alphas);
-        if (!cAlphas.empty())
-            value += makeCoeffTXT(cAlphas);
-        value += "\n\n\n";
-    }
-    if (others.is_set){
-        value += QString("Others:\n");
-        value += makeTableTXT(others);
-        if (!cOthers.empty())
-            value += makeCoeffTXT(cOthers);
-        value += "\n\n\n";
-    }
+void TableMakerHTML::WriteCoeff(QTextStream &out, const QVector<double> &coeff) const
+{
+    out << "<b>Ex(e+de) = a0 + a1(e+de) + a2(e+de)^2</b>\n";
+    out << "<p>chi-squared: " << num(coeff[3]);
+    out << ", a0 = " << num(coeff[0]);
+    out << " MeV, a1 = " << num(coeff[1]);
+    out << ", a2 = " << num(coeff[2]);
+    out << " MeV^-1</p>\n";
+}
 
-    return value;
+void TableMakerHTML::WriteTXT(QTextStream &out) const
+{
+    out << "This file was generated by QKinz.\n\n\n";
+    for (const Component_t &c : components){
+        for (int i = 0 ; i < NPARTICLES ; ++i){
+            if (!c.results[i].is_set)
+                continue;
+            out << Heading(i, c) << ":\n";
+            WriteTableTXT(out, c.results[i]);
+            if (!c.coeffs[i].empty())
+                WriteCoeffTXT(out, c.coeffs[i]);
+            out << "\n\n\n";
+        }
+    }
 }
 
-QString TableMakerHTML::makeTableTXT(Result_t data)
+void TableMakerHTML::WriteTableTXT(QTextStream &out, const Result_t &data) const
 {
-    QString output = "";
-    output += "Excitation energy (keV):     ";
-    output += "Energy dE-detector (keV):     ";
-    output += "dEnergy dE-detector (keV):     ";
-    output += "Energy E-detector (keV):    ";
-    output += "dEnergy dE-detector (keV):     ";
-    output += "Total particle energy (keV):     \n";
+    out << "Excitation energy (keV):     ";
+    out << "Energy dE-detector (keV):     ";
+    out << "dEnergy dE-detector (keV):     ";
+    out << "Energy E-detector (keV):    ";
+    out << "dEnergy dE-detector (keV):     ";
+    out << "Total particle energy (keV):     \n";
     for (int i = 0 ; i < data.Ex.size() ; ++i){
-        output += std::to_string(data.Ex[i]*1000).c_str();
-        output += "     ";
-        output += std::to_string(data.dE[i]*1000).c_str();
-        output += "     ";
-        output += std::to_string(data.d_dE[i]*1000).c_str();
-        output += "     ";
-        output += std::to_string(data.E[i]*1000).c_str();
-        output += "     ";
-        output += std::to_string(data.d_E[i]*1000).c_str();
-        output += "     ";
-        output += std::to_string(data.E[i]*1000 + data.dE[i]*1000).c_str();
-        output += "\n";
+        out << num(data.Ex[i]*1000) << "     ";
+        out << num(data.dE[i]*1000) << "     ";
+        out << num(data.d_dE[i]*1000) << "     ";
+        out << num(data.E[i]*1000) << "     ";
+        out << num(data.d_E[i]*1000) << "     ";
+        out << num(data.E[i]*1000 + data.dE[i]*1000) << "\n";
     }
-    return output;
 }
 
-QString TableMakerHTML::makeCoeffTXT(QVector<double> coeff)
+void TableMakerHTML::WriteCoeffTXT(QTextStream &out, const QVector<double> &coeff) const
 {
-    QString output = "";
-    output += "Ex(e+de) = a0 + a1(e+de) + a2(e+de)^2\n";
-    output += "chi-squared: ";
-    output += std::to_string(coeff[3]).c_str();
-    output += ", a0 = ";
-    output += std::to_string(coeff[0]).c_str();
-    output += "MeV, a1 = ";
-    output += std::to_string(coeff[1]).c_str();
-    output += ", a2 = ";
-    output += std::to_string(coeff[2]).c_str();
-    output += "(MeV)^-1\n";
-    return output;
+    out << "Ex(e+de) = a0 + a1(e+de) + a2(e+de)^2\n";
+    out << "chi-squared: " << num(coeff[3]);
+    out << ", a0 = " << num(coeff[0]);
+    out << "MeV, a1 = " << num(coeff[1]);
+    out << ", a2 = " << num(coeff[2]);
+    out << "(MeV)^-1\n";
 }
@@ -5,24 +5,34 @@
 #include "global.h"
 
 #include "RelScatter.h"
+#include "PunchThrough.h"
 
+#include "Geometry.h"
 #include "StoppingPower.h"
-#include "Ziegler1985.h"
-#include "BetheBlock.h"
+#include "StoppingModel.h"
 
 #include "ziegler1985_table.h"
 #include "ame2012_masses.h"
 #include "excitation.h"
 #include "CustomPower.h"
+#include "ExitChannels.h"
 
 #include <QVector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
 
 #include "Vector.h"
 #include "Polyfit.h"
+#include "Profiler.h"
 
 const double PI = acos(-1);
-const double ANG_FWD = 47*PI/180.;
+const double E_MIN = 0.35; // Lowest energy seen in the thick detector [MeV].
 
 #if __linux
 static adouble operator*(const int &numb, const adouble &val)
@@ -47,16 +57,31 @@ static adouble operator*(const double &numb, const adouble &val)
 
 #endif // __linux
 
-static Material::Unit Unit2MatUnit(const Unit_t &unit)
+//! Mass and element number of the isotope reacting with the beam: the
+//! target isotope for component 0, else contaminant component - 1.
+static std::pair<int, int> Isotope(const Setup_t &setup, const int &component)
 {
-    if (unit == mgcm2)
-        return Material::mgcm2;
-    else if (unit == gcm2)
-        return Material::gcm2;
-    else if (unit == um)
-        return Material::um;
-    else
-        return Material::um;
+    if (component > 0)
+        return std::make_pair(setup.contaminants[component - 1].A, setup.contaminants[component - 1].Z);
+    return std::make_pair(setup.target.A, setup.target.Z);
+}
+
+//! Highest energy of a fragment, the beam energy plus the Q-value if positive [MeV].
+static double FragmentEmax(const Setup_t &setup, const int &fA, const int &fZ, const int &component=0)
+{
+    const auto [tA, tZ] = Isotope(setup, component);
+    double Q = get_Q_keV(setup.beam.A, setup.beam.Z, tA, tZ, fA, fZ)/1000.;
+    return setup.beam.E + std::max(Q, 0.);
+}
+
+//! Width of a layer in the units of its stopping power, as a function of
+//! the width given by the user. If param is negative the width is a constant.
+static Dual LayerWidth(const int &Z, const int &A, const double &width, const Unit_t &unit,
+                       const Material::Unit &spUnit, const int &param)
+{
+    Material one(Z, A, 1.0, Geometry::MatUnit(unit));
+    Dual w = (param < 0) ? Dual(width) : Dual::Variable(width, param);
+    return w*one.GetWidth(spUnit);
 }
 
 Worker::Worker(Beam_t *beam, Target_t *target, Extra_t *front, Extra_t *back, Telescope_t *telescope)
@@ -67,7 +92,38 @@ Worker::Worker(Beam_t *beam, Target_t *target, Extra_t *front, Extra_t *back, Te
     , theTelescope( telescope )
     , haveCpro( false )
     , haveCfrag( false )
+    , useLayerTables( false )
+    , curvePoints( 0 )
+    , curveTolerance( 1e-4 )
+    , precision( StoppingModel::Exact )
+{
+}
+
+Worker::Worker()
+    : theBeam( &ownSetup.beam )
+    , theTarget( &ownSetup.target )
+    , theFront( &ownSetup.front )
+    , theBack( &ownSetup.back )
+    , theTelescope( &ownSetup.telescope )
+    , ownSetup( )
+    , haveCpro( false )
+    , haveCfrag( false )
+    , useLayerTables( false )
+    , curvePoints( 0 )
+    , curveTolerance( 1e-4 )
+    , precision( StoppingModel::Exact )
+{
+}
+
+void Worker::setSetup(const Setup_t &setup)
 {
+    ownSetup = setup;
+    theBeam = &ownSetup.beam;
+    theTarget = &ownSetup.target;
+    theFront = &ownSetup.front;
+    theBack = &ownSetup.back;
+    theTelescope = &ownSetup.telescope;
+    theContaminants = QVector<Contaminant_t>(setup.contaminants.begin(), setup.contaminants.end());
 }
 
 void Worker::setCustomTarget(CustomPower *projectile, CustomPower *fragment)
@@ -76,12 +132,385 @@ void Worker::setCustomTarget(CustomPower *projectile, CustomPower *fragment)
     fragCustom.reset(fragment); haveCfrag=true;
 }
 
+void Worker::setContaminants(const QVector<Contaminant_t> &contaminants)
+{
+    theContaminants = contaminants;
+}
+
+void Worker::setLayerTables(const bool &use)
+{
+    useLayerTables = use;
+    if (!use){
+        std::lock_guard<std::mutex> lock(tableMutex);
+        layerTables.clear();
+    }
+}
+
+void Worker::setCurvePoints(const int &n, const double &tolerance)
+{
+    curvePoints = std::max(n, 0);
+    curveTolerance = tolerance;
+}
+
+void Worker::setPrecision(const StoppingModel::Precision_t &prec)
+{
+    precision = prec;
+}
+
+std::shared_ptr<RangeTable> Worker::LayerTable(Particle *fragment, Material *layer, const double &Emax, double &width)
+{
+    Material::Unit unit = StoppingModel::Unit(StoppingModel::Choose(fragment, layer, 2*Emax));
+    auto key = std::make_tuple(fragment->GetA(), fragment->GetZ(), layer->GetZ(), layer->GetA(),
+                               int(unit), int(precision));
+    {
+        std::lock_guard<std::mutex> lock(tableMutex);
+        std::shared_ptr<RangeTable> table = layerTables[key];
+        if (table && table->GetEmax() >= Emax){
+            Profiler::Count(Profiler::CacheHits);
+            width = layer->GetWidth(unit);
+            return table;
+        }
+    }
+    Profiler::Count(Profiler::CacheMisses);
+    std::shared_ptr<RangeTable> table = StoppingModel::MakeTable(fragment, layer, Emax, width, precision);
+    std::lock_guard<std::mutex> lock(tableMutex);
+    layerTables[key] = table;
+    return table;
+}
+
+Setup_t Worker::Snapshot() const
+{
+    Setup_t setup;
+    setup.beam = *theBeam;
+    setup.target = *theTarget;
+    setup.front = *theFront;
+    setup.back = *theBack;
+    setup.telescope = *theTelescope;
+    setup.contaminants.assign(theContaminants.begin(), theContaminants.end());
+    return setup;
+}
+
 bool Worker::getCoeff(const double &angle, const int &fragA, const int &fragZ, QVector<double> &coeff)
 {
     QVector<double> ex, de, e;
     return Curve(ex, de, e, coeff, angle, fragA, fragZ);
 }
 
+bool Worker::Response(const double &Angle, const int &fA, const int &fZ, const double &Ex, Dual &dE, Dual &E) const
+{
+    const Setup_t setup = Snapshot();
+    if (haveCpro || haveCfrag){
+        std::cerr << "Derivatives are not available with tabulated stopping powers." << std::endl;
+        return false;
+    }
+
+    Dual angle = Dual::Variable(Angle, ScatAngle);
+    Dual incAngle = Geometry::IncAngle(angle);
+
+    Particle beam(setup.beam.Z, setup.beam.A);
+    Particle scatIso(setup.target.Z, setup.target.A);
+    Particle fragment(fZ, fA);
+    Particle residual(setup.beam.Z+setup.target.Z-fZ, setup.beam.A+setup.target.A-fA);
+    Material front(setup.front.Z, setup.front.A, setup.front.width, Geometry::MatUnit(setup.front.unit));
+    Material target(setup.target.Z, setup.target.A, setup.target.width, Geometry::MatUnit(setup.target.unit));
+    Material back(setup.back.Z, setup.back.A, setup.back.width, Geometry::MatUnit(setup.back.unit));
+    Material abs(setup.telescope.Absorber.Z, Get_mm2(setup.telescope.Absorber.Z), setup.telescope.Absorber.width, Geometry::MatUnit(setup.telescope.Absorber.unit));
+    Material dEdet(setup.telescope.dEdetector.Z, Get_mm2(setup.telescope.dEdetector.Z), setup.telescope.dEdetector.width, Geometry::MatUnit(setup.telescope.dEdetector.unit));
+    Material Edet(setup.telescope.Edetector.Z, Get_mm2(setup.telescope.Edetector.Z), setup.telescope.Edetector.width, Geometry::MatUnit(setup.telescope.Edetector.unit));
+
+    double EmaxF = FragmentEmax(setup, fA, fZ);
+    Material::Unit tUnitB, fUnitB, tUnit, fUnit, bUnit, aUnit, dUnit, eUnit;
+    std::unique_ptr<StoppingPower> stopTargetB(StoppingModel::Make(&target, &beam, setup.beam.E, tUnitB, precision));
+    std::unique_ptr<StoppingPower> stopTargetF(StoppingModel::Make(&target, &fragment, EmaxF, tUnit, precision));
+    std::unique_ptr<StoppingPower> stopFrontB(StoppingModel::Make(&front, &beam, setup.beam.E, fUnitB, precision));
+    std::unique_ptr<StoppingPower> stopFrontF(StoppingModel::Make(&front, &fragment, EmaxF, fUnit, precision));
+    std::unique_ptr<StoppingPower> stopBack(StoppingModel::Make(&back, &fragment, EmaxF, bUnit, precision));
+    std::unique_ptr<StoppingPower> stopAbsor(StoppingModel::Make(&abs, &fragment, EmaxF, aUnit, precision));
+    std::unique_ptr<StoppingPower> stopDE(StoppingModel::Make(&dEdet, &fragment, EmaxF, dUnit, precision));
+    std::unique_ptr<StoppingPower> stopE(StoppingModel::Make(&Edet, &fragment, EmaxF, eUnit, precision));
+
+    Dual wTargetB = LayerWidth(setup.target.Z, setup.target.A, setup.target.width, setup.target.unit, tUnitB, TargetWidth);
+    Dual wFrontB = LayerWidth(setup.front.Z, setup.front.A, setup.front.width, setup.front.unit, fUnitB, -1);
+    Dual wTarget = LayerWidth(setup.target.Z, setup.target.A, setup.target.width, setup.target.unit, tUnit, TargetWidth);
+    Dual wFront = LayerWidth(setup.front.Z, setup.front.A, setup.front.width, setup.front.unit, fUnit, -1);
+    Dual wBack = LayerWidth(setup.back.Z, setup.back.A, setup.back.width, setup.back.unit, bUnit, -1);
+    Dual wAbs = LayerWidth(abs.GetZ(), abs.GetA(), setup.telescope.Absorber.width, setup.telescope.Absorber.unit, aUnit, AbsorberWidth);
+    Dual wDE = LayerWidth(dEdet.GetZ(), dEdet.GetA(), setup.telescope.dEdetector.width, setup.telescope.dEdetector.unit, dUnit, dEWidth);
+    Dual wE = LayerWidth(Edet.GetZ(), Edet.GetA(), setup.telescope.Edetector.width, setup.telescope.Edetector.unit, eUnit, EWidth);
+
+    Dual E_beam = Dual::Variable(setup.beam.E, BeamEnergy);
+    if (setup.front.is_present)
+        E_beam = stopFrontB->Loss(E_beam, wFrontB, INTPOINTS);
+
+    Dual Ehalf = stopTargetB->Loss(E_beam, wTargetB/2., INTPOINTS);
+    Dual Ewhole = stopTargetB->Loss(E_beam, wTargetB, INTPOINTS);
+
+    RelScatter scat(&beam, &scatIso, &fragment, &residual);
+    if ((Ehalf.value() + get_Q_keV(setup.beam.A, setup.beam.Z, setup.target.A, setup.target.Z, fA, fZ)/1000.)<0)
+        return false; // Reaction not possible.
+    if (Ex > scat.FindMaxEx(Ewhole.value(), Angle))
+        return false; // State not reached at this angle.
+
+    Dual l = scat.EvaluateY(E_beam, angle, Dual(Ex));
+    Dual m = scat.EvaluateY(Ehalf, angle, Dual(Ex));
+    Dual n = scat.EvaluateY(Ewhole, angle, Dual(Ex));
+
+    if (Angle > PI/2.)
+        n = stopTargetF->Loss(n, Geometry::Path(wTarget, angle), INTPOINTS);
+    else
+        l = stopTargetF->Loss(l, Geometry::Path(wTarget, angle), INTPOINTS);
+    m = stopTargetF->Loss(m, Geometry::HalfPath(wTarget, angle), INTPOINTS);
+
+    if (Geometry::ThroughFront(Angle, setup.front.is_present)){
+        Dual path = Geometry::Path(wFront, angle);
+        l = stopFrontF->Loss(l, path, INTPOINTS);
+        m = stopFrontF->Loss(m, path, INTPOINTS);
+        n = stopFrontF->Loss(n, path, INTPOINTS);
+    } else if (setup.back.is_present){
+        Dual path = Geometry::Path(wBack, angle);
+        l = stopBack->Loss(l, path, INTPOINTS);
+        m = stopBack->Loss(m, path, INTPOINTS);
+        n = stopBack->Loss(n, path, INTPOINTS);
+    }
+
+    if (setup.telescope.has_absorber){
+        Dual path = Geometry::TelescopePath(wAbs, incAngle);
+        l = stopAbsor->Loss(l, path, INTPOINTS);
+        m = stopAbsor->Loss(m, path, INTPOINTS);
+        n = stopAbsor->Loss(n, path, INTPOINTS);
+    }
+
+    m = (l + 2*m + n)/4.;
+    Dual dm = stopDE->Loss(m, Geometry::TelescopePath(wDE, incAngle), INTPOINTS);
+    Dual em = stopE->Loss(dm, Geometry::TelescopePath(wE, incAngle), INTPOINTS);
+    dE = m - dm;
+    E = dm - em;
+    return true;
+}
+
+bool Worker::Band(const QVector<double> &Ex, QVector<double> &dE, QVector<double> &E, QVector<double> &sigma_dE, QVector<double> &sigma_E,
+                  QVector<double> &sigma_Ex, const double &Angle, const double &incAngle, const int &fA, const int &fZ, const Acceptance_t &acceptance)
+{
+    const Setup_t setup = Snapshot();
+    Particle beam(setup.beam.Z, setup.beam.A);
+    Particle scatIso(setup.target.Z, setup.target.A);
+    Particle fragment(fZ, fA);
+    Particle residual(setup.beam.Z+setup.target.Z-fZ, setup.beam.A+setup.target.A-fA);
+    Material front(setup.front.Z, setup.front.A, setup.front.width, Geometry::MatUnit(setup.front.unit));
+    Material target(setup.target.Z, setup.target.A, setup.target.width, Geometry::MatUnit(setup.target.unit));
+    Material back(setup.back.Z, setup.back.A, setup.back.width, Geometry::MatUnit(setup.back.unit));
+    Material abs(setup.telescope.Absorber.Z, Get_mm2(setup.telescope.Absorber.Z), setup.telescope.Absorber.width, Geometry::MatUnit(setup.telescope.Absorber.unit));
+    Material dEdet(setup.telescope.dEdetector.Z, Get_mm2(setup.telescope.dEdetector.Z), setup.telescope.dEdetector.width, Geometry::MatUnit(setup.telescope.dEdetector.unit));
+    Material Edet(setup.telescope.Edetector.Z, Get_mm2(setup.telescope.Edetector.Z), setup.telescope.Edetector.width, Geometry::MatUnit(setup.telescope.Edetector.unit));
+
+    // The beam does not depend on the angle.
+    Material::Unit tUnit, fUnit;
+    std::unique_ptr<StoppingPower> stopTargetB(StoppingModel::Make(&target, &beam, setup.beam.E, tUnit, precision));
+    std::unique_ptr<StoppingPower> stopFrontB(StoppingModel::Make(&front, &beam, setup.beam.E, fUnit, precision));
+    double E_beam = setup.beam.E;
+    if (setup.front.is_present)
+        E_beam = stopFrontB->Loss(E_beam, INTPOINTS);
+    double Ehalf, Ewhole;
+    if (haveCpro){
+        Ehalf = proCustom->Loss(E_beam, target.GetWidth(Material::Unit::mgcm2)/2., INTPOINTS);
+        Ewhole = proCustom->Loss(E_beam, target.GetWidth(Material::Unit::mgcm2), INTPOINTS);
+    } else {
+        Ehalf = stopTargetB->Loss(E_beam, target.GetWidth(tUnit)/2., INTPOINTS);
+        Ewhole = stopTargetB->Loss(E_beam, INTPOINTS);
+    }
+    if ((Ehalf + get_Q_keV(setup.beam.A, setup.beam.Z, setup.target.A, setup.target.Z, fA, fZ)/1000.)<0)
+        return false; // Reaction not possible.
+
+    // Samples of the angle. The strip is split in nAngle equal parts, and
+    // the offset of the beam spot in the scattering plane is sampled at the
+    // Gauss-Chebyshev points of the second kind, weighted by the chord
+    // length of the disc.
+    std::vector<double> theta, weight;
+    int nSpot = (acceptance.spotRadius > 0) ? acceptance.nSpot : 1;
+    for (int i = 0 ; i < acceptance.nAngle ; ++i){
+        double th = Angle + acceptance.stripWidth*((i + 0.5)/double(acceptance.nAngle) - 0.5);
+        for (int j = 1 ; j <= nSpot ; ++j){
+            double x = (nSpot > 1) ? cos(j*PI/double(nSpot + 1)) : 0;
+            double s = acceptance.spotRadius*x;
+            theta.push_back(atan2(acceptance.distance*sin(th) - s, acceptance.distance*cos(th)));
+            weight.push_back((nSpot > 1) ? pow(sin(j*PI/double(nSpot + 1)), 2) : 1);
+        }
+    }
+
+    // The range tables, shared by all samples. Widths are along the normal.
+    RelScatter scat(&beam, &scatIso, &fragment, &residual);
+    double Emax = 0;
+    for (double th : theta)
+        Emax = std::max(Emax, scat.Prepare(E_beam, th)(0));
+    double wTarget, wFront = 0, wBack = 0, wAbs = 0, wDE, wE;
+    std::shared_ptr<RangeTable> tTarget, tFront, tBack, tAbs, tDE, tE;
+    if (!haveCfrag)
+        tTarget = LayerTable(&fragment, &target, Emax, wTarget);
+    else
+        wTarget = target.GetWidth(Material::Unit::mgcm2);
+    if (setup.front.is_present)
+        tFront = LayerTable(&fragment, &front, Emax, wFront);
+    if (setup.back.is_present)
+        tBack = LayerTable(&fragment, &back, Emax, wBack);
+    if (setup.telescope.has_absorber)
+        tAbs = LayerTable(&fragment, &abs, Emax, wAbs);
+    tDE = LayerTable(&fragment, &dEdet, Emax, wDE);
+    tE = LayerTable(&fragment, &Edet, Emax, wE);
+
+    auto TargetLoss = [&](const double &e, const double &width){
+        if (haveCfrag)
+            return fragCustom->Loss(e, width, INTPOINTS);
+        return tTarget->Loss(e, width);
+    };
+
+    // Energy deposited for all excitation energies at one angle.
+    int npoints = Ex.size();
+    std::vector<double> l(npoints), m(npoints), n(npoints);
+    auto Deposit = [&](const double &th, const double *ex, std::vector<double> &de, std::vector<double> &e){
+        double inc = incAngle + ((Angle > PI/2.) ? Angle - th : th - Angle);
+        double pTarget = Geometry::Path(wTarget, th), pHalf = Geometry::HalfPath(wTarget, th);
+        double pFront = Geometry::Path(wFront, th), pBack = Geometry::Path(wBack, th);
+        double pAbs = Geometry::TelescopePath(wAbs, inc), pDE = Geometry::TelescopePath(wDE, inc), pE = Geometry::TelescopePath(wE, inc);
+        scat.Prepare(E_beam, th)(ex, l.data(), npoints);
+        scat.Prepare(Ehalf, th)(ex, m.data(), npoints);
+        scat.Prepare(Ewhole, th)(ex, n.data(), npoints);
+        for (int i = 0 ; i < npoints ; ++i){
+            if (th > PI/2.)
+                n[i] = TargetLoss(n[i], pTarget);
+            else
+                l[i] = TargetLoss(l[i], pTarget);
+            m[i] = TargetLoss(m[i], pHalf);
+
+            if (Geometry::ThroughFront(th, bool(tFront))){
+                l[i] = tFront->Loss(l[i], pFront);
+                m[i] = tFront->Loss(m[i], pFront);
+                n[i] = tFront->Loss(n[i], pFront);
+            } else if (tBack){
+                l[i] = tBack->Loss(l[i], pBack);
+                m[i] = tBack->Loss(m[i], pBack);
+                n[i] = tBack->Loss(n[i], pBack);
+            }
+            if (tAbs){
+                l[i] = tAbs->Loss(l[i], pAbs);
+                m[i] = tAbs->Loss(m[i], pAbs);
+                n[i] = tAbs->Loss(n[i], pAbs);
+            }
+
+            double mean = (l[i] + 2*m[i] + n[i])/4.;
+            double dm = tDE->Loss(mean, pDE);
+            de[i] = mean - dm;
+            e[i] = dm - tE->Loss(dm, pE);
+        }
+    };
+
+    // Weighted moments over the samples.
+    std::vector<double> de(npoints), e(npoints);
+    std::vector<double> sw(npoints, 0), s1(npoints, 0), s2(npoints, 0), t1(npoints, 0), t2(npoints, 0), u2(npoints, 0);
+    std::vector<char> ok(npoints, 1);
+    for (size_t k = 0 ; k < theta.size() ; ++k){
+        Deposit(theta[k], Ex.data(), de, e);
+        for (int i = 0 ; i < npoints ; ++i){
+            if (!(e[i] >= E_MIN))
+                ok[i] = 0;
+            double w = weight[k];
+            sw[i] += w;
+            s1[i] += w*de[i];
+            s2[i] += w*de[i]*de[i];
+            t1[i] += w*e[i];
+            t2[i] += w*e[i]*e[i];
+            u2[i] += w*(de[i] + e[i])*(de[i] + e[i]);
+        }
+    }
+
+    // Slope of dE + E with excitation energy at the centre of the strip.
+    const double h = 1e-3;
+    std::vector<double> de0(npoints), e0(npoints), de1(npoints), e1(npoints);
+    std::vector<double> Exh(Ex.begin(), Ex.end());
+    for (double &x : Exh)
+        x += h;
+    Deposit(Angle, Ex.data(), de0, e0);
+    Deposit(Angle, Exh.data(), de1, e1);
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    dE.resize(npoints);
+    E.resize(npoints);
+    sigma_dE.resize(npoints);
+    sigma_E.resize(npoints);
+    sigma_Ex.resize(npoints);
+    for (int i = 0 ; i < npoints ; ++i){
+        if (!ok[i]){
+            dE[i] = E[i] = sigma_dE[i] = sigma_E[i] = sigma_Ex[i] = nan;
+            continue;
+        }
+        dE[i] = s1[i]/sw[i];
+        E[i] = t1[i]/sw[i];
+        sigma_dE[i] = sqrt(std::max(s2[i]/sw[i] - dE[i]*dE[i], 0.));
+        sigma_E[i] = sqrt(std::max(t2[i]/sw[i] - E[i]*E[i], 0.));
+        double tot = dE[i] + E[i];
+        // Where dE + E does not change with the excitation energy, e.g. at
+        // punch-through, the spread can not be converted.
+        double slope = ((de1[i] + e1[i]) - (de0[i] + e0[i]))/h;
+        if (fabs(slope) > 1e-6)
+            sigma_Ex[i] = sqrt(std::max(u2[i]/sw[i] - tot*tot, 0.))/fabs(slope);
+        else
+            sigma_Ex[i] = nan;
+    }
+    return true;
+}
+
+bool Worker::Band(const QVector<double> &Ex, QVector<double> &dE, QVector<double> &E, QVector<double> &sigma_dE, QVector<double> &sigma_E,
+                  QVector<double> &sigma_Ex, const double &Angle, const int &fA, const int &fZ, const Acceptance_t &acceptance)
+{
+    double incAngle = Geometry::IncAngle(Angle);
+    return Band(Ex, dE, E, sigma_dE, sigma_E, sigma_Ex, Angle, incAngle, fA, fZ, acceptance);
+}
+
+bool Worker::Channels(const QVector<double> &angles, std::vector<ChannelBand_t> &bands)
+{
+    const Setup_t setup = Snapshot();
+    if (find_entry(setup.beam.A, setup.beam.Z).A == 0 || find_entry(setup.target.A, setup.target.Z).A == 0)
+        return false;
+    std::vector<Channel_t> channels = ExitChannels(setup.beam.A, setup.beam.Z, setup.target.A, setup.target.Z, setup.beam.E);
+
+    const double inf = std::numeric_limits<double>::infinity();
+    bands.resize(channels.size());
+    for (size_t i = 0 ; i < channels.size() ; ++i)
+        bands[i] = {channels[i].A, channels[i].Z, channels[i].resA, channels[i].resZ, channels[i].Q, 0, inf, -inf, inf, -inf, inf, -inf};
+
+    // Each thread takes the next channel not yet done.
+    unsigned nthreads = std::thread::hardware_concurrency();
+    if (nthreads == 0)
+        nthreads = 1;
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0 ; t < nthreads && t < channels.size() ; ++t){
+        threads.push_back(std::thread([this, &angles, &bands, &next](){
+            QVector<double> ex, de, e, coeff;
+            for (size_t i = next++ ; i < bands.size() ; i = next++){
+                ChannelBand_t &band = bands[i];
+                for (const double &angle : angles){
+                    if (!Curve(ex, de, e, coeff, angle, band.A, band.Z) || ex.isEmpty())
+                        continue;
+                    ++band.angles;
+                    band.ExMin = std::min(band.ExMin, *std::min_element(ex.begin(), ex.end()));
+                    band.ExMax = std::max(band.ExMax, *std::max_element(ex.begin(), ex.end()));
+                    band.dEMin = std::min(band.dEMin, *std::min_element(de.begin(), de.end()));
+                    band.dEMax = std::max(band.dEMax, *std::max_element(de.begin(), de.end()));
+                    band.EMin = std::min(band.EMin, *std::min_element(e.begin(), e.end()));
+                    band.EMax = std::max(band.EMax, *std::max_element(e.begin(), e.end()));
+                }
+            }
+        }));
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    std::stable_sort(bands.begin(), bands.end(), [](const ChannelBand_t &a, const ChannelBand_t &b){
+        return (a.angles != b.angles) ? a.angles > b.angles : a.Q > b.Q;
+    });
+    return true;
+}
+
 /*void Worker::Run(const double &Angle, const double &incAngle, const bool &p, const bool &d, const bool &t, const bool &h3, const bool &a)
 {
     QVector<double> ex, de, d_de, e, d_e, coeff;
@@ -157,86 +586,55 @@ bool Worker::getCoeff(const double &angle, const int &fragA, const int &fragZ, Q
 
 void Worker::Run(const double &Angle, const double &incAngle, const bool &p, const bool &d, const bool &t, const bool &h3, const bool &a, const int &A, const int &Z)
 {
+    struct {
+        bool want;
+        int A, Z;
+        Fragment_t what;
+        const char *name;
+    } fragments[] = {
+        {p, 1, 1, Proton, "p"},
+        {d, 2, 1, Deutron, "d"},
+        {t, 3, 1, Triton, "t"},
+        {h3, 3, 2, Helium3, "3He"},
+        {a, 4, 2, Alpha, "alpha"},
+        {A > 0 && Z > 0, A, Z, Other, "other"}
+    };
+
+    // The contaminants are done right after the target for each fragment,
+    // sharing the range tables of the telescope.
+    const int ncomponents = 1 + int(Snapshot().contaminants.size());
+
     QVector<double> ex, de, d_de, e, d_e, coeff;
     int ntot = 0, nres=0;
-    if (p) ntot += 2;
-    if (d) ntot += 2;
-    if (t) ntot += 2;
-    if (h3) ntot += 2;
-    if (a) ntot += 2;
-    if ( A>0&&Z>0 ) ntot += 2;
-
-    if (p){
-        if (Curve(ex, de, e, coeff, Angle, incAngle, 1, 1)){
-            emit ResultCurve(ex, e, de, coeff, Proton);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-        if (Known(ex, de, e, d_de, d_e, Angle, incAngle, 1, 1)){
-            emit ResultScatter(e, d_e, de, d_de, ex, Proton);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
+    for (const auto &frag : fragments){
+        if (frag.want)
+            ntot += 2*ncomponents;
     }
-    if (d){
-        if (Curve(ex, de, e, coeff, Angle, incAngle, 2, 1)){
-            emit ResultCurve(ex, e, de, coeff, Deutron);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-        if (Known(ex, de, e, d_de, d_e, Angle, incAngle, 2, 1)){
-            emit ResultScatter(e, d_e, de, d_de, ex, Deutron);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-    }
-    if (t){
-        if (Curve(ex, de, e, coeff, Angle, incAngle, 3, 1)){
-            emit ResultCurve(ex, e, de, coeff, Triton);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-        if (Known(ex, de, e, d_de, d_e, Angle, incAngle, 3, 1)){
-            emit ResultScatter(e, d_e, de, d_de, ex, Triton);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-    }
-    if (h3){
-        if (Curve(ex, de, e, coeff, Angle, incAngle, 3, 2)){
-            emit ResultCurve(ex, e, de, coeff, Helium3);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-        if (Known(ex, de, e, d_de, d_e, Angle, incAngle, 3, 2)){
-            emit ResultScatter(e, d_e, de, d_de, ex, Helium3);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-    }
-    if (a){
-        if (Curve(ex, de, e, coeff, Angle, incAngle, 4, 2)){
-            emit ResultCurve(ex, e, de, coeff, Alpha);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-        if (Known(ex, de, e, d_de, d_e, Angle, incAngle, 4, 2)){
-            emit ResultScatter(e, d_e, de, d_de, ex, Alpha);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-    }
-    if ( A > 0 && Z > 0 ){
-        if (Curve(ex, de, e, coeff, Angle, incAngle, A, Z)){
-            emit ResultCurve(ex, e, de, coeff, Other);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
-        }
-        if (Known(ex, de, e, d_de, d_e, Angle, incAngle, A, Z)){
-            emit ResultScatter(e, d_e, de, d_de, ex, Other);
-            ++nres;
-            emit curr_prog(100*double(nres)/double(ntot));
+
+    // The profile of the run so far is sent after each fragment,
+    // followed by the time of each fragment.
+    Profiler::Report_t start = Profiler::Get();
+    std::string perFragment;
+    for (const auto &frag : fragments){
+        if (!frag.want)
+            continue;
+        Profiler::Report_t before = Profiler::Get();
+        for (int c = 0 ; c < ncomponents ; ++c){
+            if (Curve(ex, de, e, coeff, Angle, incAngle, frag.A, frag.Z, c)){
+                emit ResultCurve(ex, e, de, coeff, frag.what, c);
+                ++nres;
+                emit curr_prog(100*double(nres)/double(ntot));
+            }
+            if (Known(ex, de, e, d_de, d_e, Angle, incAngle, frag.A, frag.Z, c)){
+                emit ResultScatter(e, d_e, de, d_de, ex, frag.what, c);
+                ++nres;
+                emit curr_prog(100*double(nres)/double(ntot));
+            }
         }
+        char line[64];
+        snprintf(line, sizeof(line), "%-12s %23.1f\n", frag.name, 1e3*(Profiler::Get() - before).Total());
+        perFragment += line;
+        emit Profiled(QString::fromStdString(Profiler::Summary(Profiler::Get() - start) + perFragment));
     }
 
     emit FinishedAll();
@@ -245,1060 +643,461 @@ void Worker::Run(const double &Angle, const double &incAngle, const bool &p, con
 
 bool Worker::Curve(QVector<double> &Ex, QVector<double> &dE, QVector<double> &E, QVector<double> &coeff, const double &Angle, const int &fA, const int &fZ)
 {
-        double incAngle;
-        if (Angle > PI/2.)
-            incAngle = PI - ANG_FWD - Angle;
-        else
-            incAngle = Angle - ANG_FWD;
-
-        Particle *beam = new Particle(theBeam->Z, theBeam->A);
-        Particle *scatIso = new Particle(theTarget->Z, theTarget->A);
-        Particle *fragment = new Particle(fZ, fA);
-        Particle *residual = new Particle(theBeam->Z+theTarget->Z-fZ, theBeam->A+theTarget->A-fA);
-        Material *front = new Material(theFront->Z, theFront->A, theFront->width, Unit2MatUnit(theFront->unit));
-        Material *target = new Material(theTarget->Z, theTarget->A, theTarget->width, Unit2MatUnit(theTarget->unit));
-        Material *back = new Material(theBack->Z, theBack->A, theBack->width/fabs(cos(Angle)), Unit2MatUnit(theBack->unit));
-        Material *abs = new Material(theTelescope->Absorber.Z, Get_mm2(theTelescope->Absorber.Z), theTelescope->Absorber.width/cos(incAngle), Unit2MatUnit(theTelescope->Absorber.unit));
-        Material *dEdet = new Material(theTelescope->dEdetector.Z, Get_mm2(theTelescope->dEdetector.Z), theTelescope->dEdetector.width/cos(incAngle), Unit2MatUnit(theTelescope->dEdetector.unit));
-        Material *Edet = new Material(theTelescope->Edetector.Z, Get_mm2(theTelescope->Edetector.Z), theTelescope->Edetector.width/cos(incAngle), Unit2MatUnit(theTelescope->Edetector.unit));
-
-        RelScatter *scat = new RelScatter(beam, scatIso, fragment, residual);//new Iterative(beam, scatIso, fragment, residual);
-
-        // Setting up stopping power for the target.
-        StoppingPower *stopTargetB;
-        StoppingPower *stopTargetF;
-        Material::Unit tUnit;
-        if (theTarget->Z > 92){
-            stopTargetB = new BetheBlock(target, beam);
-            stopTargetF = new BetheBlock(target, fragment);
-            tUnit = Material::gcm2;
-            std::cout << "Warning: Target Z= " << theTarget->Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopTargetB = new Ziegler1985(target, beam);
-            stopTargetF = new Ziegler1985(target, fragment);
-            tUnit = Material::um;
-        }
-
-        // Setting up stopping power for the fronting and backing.
-        StoppingPower *stopFrontB;
-        StoppingPower *stopFrontF;
-        Material::Unit fUnit;
-        if (theFront->Z > 92){
-            stopFrontB = new BetheBlock(front, beam);
-            stopFrontF = new BetheBlock(front, fragment);
-            fUnit = Material::gcm2;
-            std::cout << "Warning: Front coating Z= " << theFront->Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopFrontB = new Ziegler1985(front, beam);
-            stopFrontF = new Ziegler1985(front, fragment);
-            fUnit = Material::um;
-        }
-        StoppingPower *stopBack;
-        Material::Unit bUnit = Material::Unit::gcm2;
-        if (theBack->Z > 92){
-            stopBack = new BetheBlock(back, fragment);
-            bUnit = Material::gcm2;
-            std::cout << "Warning: Back coating Z= " << theBack->Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopBack = new Ziegler1985(back, fragment);
-            bUnit = Material::um;
-        }
-
-        // Setting up stopping power for the absorber.
-        StoppingPower *stopAbsor;
-        if (theTelescope->Absorber.Z > 92){
-            stopAbsor = new BetheBlock(abs, fragment);
-            std::cout << "Warning: Absorber Z= " << theTelescope->Absorber.Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopAbsor = new Ziegler1985(abs, fragment);
-        }
-
-        // Setting up stopping power for thin detector.
-        StoppingPower *stopDE;
-        if (theTelescope->dEdetector.Z > 92){
-            stopDE = new BetheBlock(dEdet, fragment);
-            std::cout << "Warning: dE detector Z= " << theTelescope->dEdetector.Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopDE = new Ziegler1985(dEdet, fragment);
-        }
+    double incAngle = Geometry::IncAngle(Angle);
+    return Curve(Ex, dE, E, coeff, Angle, incAngle, fA, fZ);
+}
 
-        // Setting up stopping power for thick detector.
-        StoppingPower *stopE;
-        if (theTelescope->Edetector.Z > 92){
-            stopE = new BetheBlock(Edet, fragment);
-            std::cout << "Warning: E detector Z= " << theTelescope->Edetector.Z;
+bool Worker::Curve(QVector<double> &Ex, QVector<double> &dE, QVector<double> &E, QVector<double> &coeff, const double &Angle, const double &incAngle, const int &fA, const int &fZ, const int &component)
+{
+    const Setup_t setup = Snapshot();
+    if (component < 0 || component > int(setup.contaminants.size()))
+        return false;
+    const auto [tA, tZ] = Isotope(setup, component);
+    Profiler::Timer setupTimer(Profiler::Setup);
+
+    Particle beam(setup.beam.Z, setup.beam.A);
+    Particle scatIso(tZ, tA);
+    Particle fragment(fZ, fA);
+    Particle residual(setup.beam.Z+tZ-fZ, setup.beam.A+tA-fA);
+    Material front(setup.front.Z, setup.front.A, setup.front.width, Geometry::MatUnit(setup.front.unit));
+    Material target(setup.target.Z, setup.target.A, setup.target.width, Geometry::MatUnit(setup.target.unit));
+    Material back(setup.back.Z, setup.back.A, Geometry::Path(setup.back.width, Angle), Geometry::MatUnit(setup.back.unit));
+    Material abs(setup.telescope.Absorber.Z, Get_mm2(setup.telescope.Absorber.Z), Geometry::TelescopePath(setup.telescope.Absorber.width, incAngle), Geometry::MatUnit(setup.telescope.Absorber.unit));
+    Material dEdet(setup.telescope.dEdetector.Z, Get_mm2(setup.telescope.dEdetector.Z), Geometry::TelescopePath(setup.telescope.dEdetector.width, incAngle), Geometry::MatUnit(setup.telescope.dEdetector.unit));
+    Material Edet(setup.telescope.Edetector.Z, Get_mm2(setup.telescope.Edetector.Z), Geometry::TelescopePath(setup.telescope.Edetector.width, incAngle), Geometry::MatUnit(setup.telescope.Edetector.unit));
+
+    RelScatter scat(&beam, &scatIso, &fragment, &residual);
+
+    // Stopping powers of the layers.
+    double EmaxF = FragmentEmax(setup, fA, fZ, component);
+    Material::Unit tUnitB, fUnitB, tUnit, fUnit, bUnit, aUnit, dUnit, eUnit;
+    std::unique_ptr<StoppingPower> stopTargetB(StoppingModel::Make(&target, &beam, setup.beam.E, tUnitB, precision));
+    std::unique_ptr<StoppingPower> stopTargetF(StoppingModel::Make(&target, &fragment, EmaxF, tUnit, precision));
+    std::unique_ptr<StoppingPower> stopFrontB(StoppingModel::Make(&front, &beam, setup.beam.E, fUnitB, precision));
+    std::unique_ptr<StoppingPower> stopFrontF(StoppingModel::Make(&front, &fragment, EmaxF, fUnit, precision));
+    std::unique_ptr<StoppingPower> stopBack(StoppingModel::Make(&back, &fragment, EmaxF, bUnit, precision));
+    std::unique_ptr<StoppingPower> stopAbsor(StoppingModel::Make(&abs, &fragment, EmaxF, aUnit, precision));
+    std::unique_ptr<StoppingPower> stopDE(StoppingModel::Make(&dEdet, &fragment, EmaxF, dUnit, precision));
+    std::unique_ptr<StoppingPower> stopE(StoppingModel::Make(&Edet, &fragment, EmaxF, eUnit, precision));
+
+    const std::pair<const char *, const Material *> layers[] = {
+        {"Target", &target}, {"Front coating", &front}, {"Back coating", &back},
+        {"Absorber", &abs}, {"dE detector", &dEdet}, {"E detector", &Edet}
+    };
+    for (const auto &layer : layers){
+        if (StoppingModel::Choose(&fragment, layer.second, EmaxF) == StoppingModel::Bethe){
+            std::cout << "Warning: " << layer.first << " Z= " << layer.second->GetZ();
             std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
             std::cout << std::endl;
-        } else {
-            stopE = new Ziegler1985(Edet, fragment);
-        }
-        double E_beam = theBeam->E;
-        if (theFront->is_present)
-            E_beam = stopFrontB->Loss(E_beam, INTPOINTS);
-
-        double Ehalf, Ewhole;
-        if (haveCpro){
-            Ehalf = proCustom->Loss(E_beam, target->GetWidth(Material::Unit::mgcm2)/2., INTPOINTS); // The stopping power are in ug/cm^2
-            Ewhole = proCustom->Loss(E_beam, target->GetWidth(Material::Unit::mgcm2), INTPOINTS);
-        } else {
-            Ehalf = stopTargetB->Loss(E_beam, target->GetWidth(tUnit)/2., INTPOINTS);
-            Ewhole = stopTargetB->Loss(E_beam, INTPOINTS);
         }
-        double dEx = scat->FindMaxEx(Ewhole, Angle)/double(POINTS - 1);
-
-        if ((Ehalf + get_Q_keV(theBeam->A, theBeam->Z, theTarget->A, theTarget->Z, fA, fZ)/1000.)<0){
-            // Particles.
-            delete beam;
-            delete scatIso;
-            delete fragment;
-            delete residual;
-            
-            // Materials.
-            delete target;
-            delete front;
-            delete back;
-            delete abs;
-            delete dEdet;
-            delete Edet;
-            
-            // Scattering calculator.
-            delete scat;
-            
-            // Stopping power calculators.
-            delete stopTargetB;
-            delete stopTargetF;
-            delete stopFrontB;
-            delete stopFrontF;
-            delete stopBack;
-            delete stopAbsor;
-            delete stopDE;
-            delete stopE;
-            return false; // Reaction not possible. Not enough energy :(
-        }
-
-        QVector<double> Ex_tmp(POINTS), dE_tmp(POINTS), E_tmp(POINTS), E_err_tmp(POINTS), is_punch(POINTS);
-
-        Ex.clear();
-        dE.clear();
-        E.clear();
-
-        adouble l(POINTS);
-        adouble m(POINTS), dm(POINTS), em(POINTS);
-        adouble n(POINTS);
+    }
 
-        for (int i = 0 ; i < POINTS ; ++i){
-            Ex_tmp[i] = i*dEx;
-        }
+    setupTimer.Stop();
 
-        for (int i = 0 ; i < POINTS ; ++i){
-            l[i] = scat->EvaluateY(E_beam, Angle, Ex_tmp[i]);
-            m[i] = scat->EvaluateY(Ehalf, Angle, Ex_tmp[i]);
-            n[i] = scat->EvaluateY(Ewhole, Angle, Ex_tmp[i]);
-        }
+    Profiler::Timer beamTimer(Profiler::BeamLoss);
+    double E_beam = setup.beam.E;
+    if (setup.front.is_present)
+        E_beam = stopFrontB->Loss(E_beam, INTPOINTS);
 
-        if (Angle > PI/2.){
-            if (haveCfrag){
-                for (int i = 0 ; i < POINTS ; ++i){
-                    n[i] = fragCustom->Loss(n[i], target->GetWidth(Material::Unit::mgcm2)/fabs(cos(Angle)), INTPOINTS);
-                }
-            } else {
-                for (int i = 0 ; i < POINTS ; ++i){
-                    n[i] = stopTargetF->Loss(n[i], target->GetWidth(tUnit)/fabs(cos(Angle)), INTPOINTS);
-                }
-            }
-        } else {
-            if (haveCfrag){
-                for (int i = 0 ; i < POINTS ; ++i)
-                    l[i] = fragCustom->Loss(l[i], target->GetWidth(Material::Unit::mgcm2)/fabs(cos(Angle)), INTPOINTS);
-            } else {
-                for (int i = 0 ; i < POINTS ; ++i)
-                    l[i] = stopTargetF->Loss(l[i], target->GetWidth(tUnit)/fabs(cos(Angle)), INTPOINTS);
-            }
-        }
-        if (haveCfrag){
-            for (int i = 0 ; i < POINTS ; ++i)
-                m[i] = fragCustom->Loss(m[i], target->GetWidth(Material::Unit::mgcm2)/fabs(2*cos(Angle)), INTPOINTS);
-        } else {
-            for (int i = 0 ; i < POINTS ; ++i)
-                m[i] = stopTargetF->Loss(m[i], target->GetWidth(tUnit)/fabs(2*cos(Angle)), INTPOINTS);
-        }
+    double Ehalf, Ewhole;
+    if (haveCpro){
+        Ehalf = proCustom->Loss(E_beam, target.GetWidth(Material::Unit::mgcm2)/2., INTPOINTS); // The stopping power are in ug/cm^2
+        Ewhole = proCustom->Loss(E_beam, target.GetWidth(Material::Unit::mgcm2), INTPOINTS);
+    } else {
+        Ehalf = stopTargetB->Loss(E_beam, target.GetWidth(tUnitB)/2., INTPOINTS);
+        Ewhole = stopTargetB->Loss(E_beam, INTPOINTS);
+    }
+    beamTimer.Stop();
+    // Heavy fragments may also be unable to reach the angle at all.
+    if ((Ehalf + get_Q_keV(setup.beam.A, setup.beam.Z, tA, tZ, fA, fZ)/1000.)<0
+            || !(scat.FindMaxEx(Ewhole, Angle) >= 0) || !(scat.Prepare(E_beam, Angle)(0) > 0))
+        return false; // Reaction not possible. Not enough energy :(
 
-        if (Angle > PI/2. && theFront->is_present){
-            for (int i = 0 ; i < POINTS ; ++i){
-                l[i] = stopFrontF->Loss(l[i], front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-                m[i] = stopFrontF->Loss(m[i], front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-                n[i] = stopFrontF->Loss(n[i], front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
+    // Tables of the telescope layers. The thin and thick detector
+    // tables are always needed to find the window in excitation energy.
+    Profiler::Timer kinTimer(Profiler::Kinematics);
+    RelScatter::Prepared kinL = scat.Prepare(E_beam, Angle);
+    RelScatter::Prepared kinM = scat.Prepare(Ehalf, Angle);
+    RelScatter::Prepared kinN = scat.Prepare(Ewhole, Angle);
+    double Emax = kinL(0);
+    kinTimer.Stop();
+
+    Profiler::Timer tableTimer(Profiler::Setup);
+    double wAbs = 0, wDE, wE;
+    std::shared_ptr<RangeTable> tAbs, tDE, tE;
+    if (useLayerTables && setup.telescope.has_absorber)
+        tAbs = LayerTable(&fragment, &abs, Emax, wAbs);
+    tDE = LayerTable(&fragment, &dEdet, Emax, wDE);
+    tE = LayerTable(&fragment, &Edet, Emax, wE);
+    tableTimer.Stop();
+
+    // Energy of the fragment in front of the telescope, when made
+    // in the front (l), the middle (m) and the back (n) of the target,
+    // for count excitation energies. Each layer is timed once for all
+    // the points by Sample.
+    auto TargetLoss = [&](const double &e, const double &width){
+        if (haveCfrag)
+            return fragCustom->Loss(e, width*target.GetWidth(Material::Unit::mgcm2), INTPOINTS);
+        return stopTargetF->Loss(e, width*target.GetWidth(tUnit), INTPOINTS);
+    };
+    auto Target = [&](const int &count, double *l, double *m, double *n){
+        for (int i = 0 ; i < count ; ++i){
+            if (Angle > PI/2.)
+                n[i] = TargetLoss(n[i], Geometry::Path(1., Angle));
+            else
+                l[i] = TargetLoss(l[i], Geometry::Path(1., Angle));
+            m[i] = TargetLoss(m[i], Geometry::HalfPath(1., Angle));
+        }
+    };
+    auto FrontBack = [&](const int &count, double *l, double *m, double *n){
+        if (Geometry::ThroughFront(Angle, setup.front.is_present)){
+            double path = Geometry::Path(front.GetWidth(fUnit), Angle);
+            for (int i = 0 ; i < count ; ++i){
+                l[i] = stopFrontF->Loss(l[i], path, INTPOINTS);
+                m[i] = stopFrontF->Loss(m[i], path, INTPOINTS);
+                n[i] = stopFrontF->Loss(n[i], path, INTPOINTS);
             }
-        } else if (theBack->is_present){
-            for (int i = 0 ; i < POINTS ; ++i){
+        } else if (setup.back.is_present){
+            for (int i = 0 ; i < count ; ++i){
                 l[i] = stopBack->Loss(l[i], INTPOINTS);
                 m[i] = stopBack->Loss(m[i], INTPOINTS);
                 n[i] = stopBack->Loss(n[i], INTPOINTS);
             }
         }
-
-        if (theTelescope->has_absorber){
-            for (int i = 0 ; i < POINTS ; ++i){
+    };
+    auto Absorber = [&](const int &count, double *l, double *m, double *n){
+        if (!setup.telescope.has_absorber)
+            return;
+        for (int i = 0 ; i < count ; ++i){
+            if (tAbs){
+                l[i] = tAbs->Loss(l[i], wAbs);
+                m[i] = tAbs->Loss(m[i], wAbs);
+                n[i] = tAbs->Loss(n[i], wAbs);
+            } else {
                 l[i] = stopAbsor->Loss(l[i], INTPOINTS);
                 m[i] = stopAbsor->Loss(m[i], INTPOINTS);
                 n[i] = stopAbsor->Loss(n[i], INTPOINTS);
             }
         }
-
-        for (int i = 0 ; i < POINTS ; ++i)
-            E_err_tmp[i] = sqrt(3*l[i]*l[i] + 3*n[i]*n[i] + 4*m[i]*m[i] - 2*n[i]*l[i] -4*m[i]*(l[i] + n[i]))/4.;
-
-        m = (l + 2*m + n)/4.;
-        for (int i = 0 ; i < POINTS ; ++i){
-            dm[i] = stopDE->Loss(m[i], INTPOINTS);
-            em[i] = stopE->Loss(dm[i], INTPOINTS);
-
-            dE_tmp[i] = m[i] - dm[i];
-            E_tmp[i] = dm[i] - em[i];
-            is_punch[i] = em[i];
-            if (em[i] != em[i])
-                is_punch[i] = 1000;
-        }
-
-        QVector<double> is_punch2, E_err;
-        int not_punch = 0;
-        for (int i = 0 ; i < Ex_tmp.size() ; ++i){
-            if (E_tmp[i] >= 0.35){
-                Ex.push_back(Ex_tmp[i]);
-                dE.push_back(dE_tmp[i]);
-                E.push_back(E_tmp[i]);
-                is_punch2.push_back(is_punch[i]);
-                E_err.push_back(E_err_tmp[i]);
-                if (is_punch[i] <= 0.05)
-                    not_punch += 1;
-            }
-        }
-
-        if (not_punch >= 3){
-            double *x = new double[not_punch];
-            double *y = new double[not_punch];
-            double *dx = new double[not_punch];
-            int j = 0;
-            for (int i = 0 ; i < is_punch2.size() ; ++i){
-                if (is_punch2[i] <= 0.05 && j < not_punch){
-                    x[j] = dE[i] + E[i];
-                    y[j] = Ex[i];
-                    dx[j] = E_err[i];
-                    ++j;
-                }
-            }
-            Polyfit fitting(x, y, not_punch);
-            Vector fit = fitting(3);
-            coeff = QVector<double>(4);
-            coeff[0] = fit[0]; coeff[1] = fit[1]; coeff[2] = fit[2], coeff[3] = 0;
-
-            for (int i = 0 ; i < not_punch ; ++i){
-                coeff[3] += (y[i] - coeff[0] - coeff[1]*x[i] - coeff[2]*x[i]*x[i])*(y[i] - coeff[0] - coeff[1]*x[i] - coeff[2]*x[i]*x[i])/(dx[i]*dx[i]);
+    };
+    auto Mean = [&](const double &ex){
+        double l = kinL(ex), m = kinM(ex), n = kinN(ex);
+        Target(1, &l, &m, &n);
+        FrontBack(1, &l, &m, &n);
+        Absorber(1, &l, &m, &n);
+        return (l + 2*m + n)/4.;
+    };
+
+    Profiler::Timer maxTimer(Profiler::Kinematics);
+    double ExLo = 0, ExHi = scat.FindMaxEx(Ewhole, Angle);
+    maxTimer.Stop();
+
+    // Only excitation energies leaving at least E_MIN in the thick
+    // detector are of interest. The fragment energy falls with the
+    // excitation energy, so the window is found by bisection between
+    // the energy thresholds of the telescope. The search is timed as a
+    // whole, with the detectors.
+    Profiler::Timer windowTimer(Profiler::Detectors);
+    PunchThrough punch(tDE.get(), wDE, tE.get(), wE);
+    double Elow = punch.Lower(E_MIN);
+    double Ehigh = punch.Upper(E_MIN);
+    auto Solve = [](const auto &inWindow, double inside, double outside){
+        for (int i = 0 ; i < 100 && fabs(outside - inside) > 1e-9*(1 + fabs(inside)) ; ++i){
+            double ex = 0.5*(inside + outside);
+            if (inWindow(ex))
+                inside = ex;
+            else
+                outside = ex;
+        }
+        return inside;
+    };
+
+    int points = POINTS;
+    if (!(Ehigh > Elow) || !(Mean(ExLo) >= Elow)){
+        points = 0; // Never seen in the thick detector.
+    } else {
+        if (!(Mean(ExHi) >= Elow))
+            ExHi = Solve([&Mean, &Elow](const double &ex){ return Mean(ex) >= Elow; }, ExLo, ExHi);
+        if (Mean(ExHi) > Ehigh)
+            points = 0; // Always punching through.
+        else if (Mean(ExLo) > Ehigh)
+            ExLo = Solve([&Mean, &Ehigh](const double &ex){ return Mean(ex) <= Ehigh; }, ExHi, ExLo);
+    }
+    windowTimer.Stop();
+
+    // Energies in the telescope for count excitation energies.
+    auto Sample = [&](const int &count, const double *ex, double *de, double *e, double *e_err, double *punch){
+        adouble l(count);
+        adouble m(count), dm(count), em(count);
+        adouble n(count);
+
+        if (count > 0){
+            Profiler::Timer kinTimer(Profiler::Kinematics);
+            kinL(ex, &l[0], count);
+            kinM(ex, &m[0], count);
+            kinN(ex, &n[0], count);
+            kinTimer.Stop();
+
+            Profiler::Timer targetTimer(Profiler::TargetLayer);
+            Target(count, &l[0], &m[0], &n[0]);
+            targetTimer.Stop();
+
+            Profiler::Timer layerTimer(Profiler::FrontBackLayer);
+            FrontBack(count, &l[0], &m[0], &n[0]);
+            layerTimer.Stop();
+
+            if (setup.telescope.has_absorber){
+                Profiler::Timer absTimer(Profiler::AbsorberLayer);
+                Absorber(count, &l[0], &m[0], &n[0]);
             }
-            coeff[3] /= double(not_punch - 3);
-
-            delete[] x;
-            delete[] y;
-            delete[] dx;
-        }
-
-
-        // Clearing up memory.
-
-        // Particles.
-        delete beam;
-        delete scatIso;
-        delete fragment;
-        delete residual;
-
-        // Materials.
-        delete target;
-        delete front;
-        delete back;
-        delete abs;
-        delete dEdet;
-        delete Edet;
-
-        // Scattering calculator.
-        delete scat;
-
-        // Stopping power calculators.
-        delete stopTargetB;
-        delete stopTargetF;
-        delete stopFrontB;
-        delete stopFrontF;
-        delete stopBack;
-        delete stopAbsor;
-        delete stopDE;
-        delete stopE;
-
-        // Done with the work :)
-        return true;
-}
-
-bool Worker::Curve(QVector<double> &Ex, QVector<double> &dE, QVector<double> &E, QVector<double> &coeff, const double &Angle, const double &incAngle, const int &fA, const int &fZ)
-{
-
-        Particle *beam = new Particle(theBeam->Z, theBeam->A);
-        Particle *scatIso = new Particle(theTarget->Z, theTarget->A);
-        Particle *fragment = new Particle(fZ, fA);
-        Particle *residual = new Particle(theBeam->Z+theTarget->Z-fZ, theBeam->A+theTarget->A-fA);
-        Material *front = new Material(theFront->Z, theFront->A, theFront->width, Unit2MatUnit(theFront->unit));
-        Material *target = new Material(theTarget->Z, theTarget->A, theTarget->width, Unit2MatUnit(theTarget->unit));
-        Material *back = new Material(theBack->Z, theBack->A, theBack->width/fabs(cos(Angle)), Unit2MatUnit(theBack->unit));
-        Material *abs = new Material(theTelescope->Absorber.Z, Get_mm2(theTelescope->Absorber.Z), theTelescope->Absorber.width/cos(incAngle), Unit2MatUnit(theTelescope->Absorber.unit));
-        Material *dEdet = new Material(theTelescope->dEdetector.Z, Get_mm2(theTelescope->dEdetector.Z), theTelescope->dEdetector.width/cos(incAngle), Unit2MatUnit(theTelescope->dEdetector.unit));
-        Material *Edet = new Material(theTelescope->Edetector.Z, Get_mm2(theTelescope->Edetector.Z), theTelescope->Edetector.width/cos(incAngle), Unit2MatUnit(theTelescope->Edetector.unit));
-
-        RelScatter *scat = new RelScatter(beam, scatIso, fragment, residual);//new Iterative(beam, scatIso, fragment, residual);
-
-        // Setting up stopping power for the target.
-        StoppingPower *stopTargetB;
-        StoppingPower *stopTargetF;
-        Material::Unit tUnit;
-        if (theTarget->Z > 92){
-            stopTargetB = new BetheBlock(target, beam);
-            stopTargetF = new BetheBlock(target, fragment);
-            tUnit = Material::gcm2;
-            std::cout << "Warning: Target Z= " << theTarget->Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopTargetB = new Ziegler1985(target, beam);
-            stopTargetF = new Ziegler1985(target, fragment);
-            tUnit = Material::um;
-        }
-
-        // Setting up stopping power for the fronting and backing.
-        StoppingPower *stopFrontB;
-        StoppingPower *stopFrontF;
-        Material::Unit fUnit;
-        if (theFront->Z > 92){
-            stopFrontB = new BetheBlock(front, beam);
-            stopFrontF = new BetheBlock(front, fragment);
-            fUnit = Material::gcm2;
-            std::cout << "Warning: Front coating Z= " << theFront->Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopFrontB = new Ziegler1985(front, beam);
-            stopFrontF = new Ziegler1985(front, fragment);
-            fUnit = Material::um;
-        }
-        StoppingPower *stopBack;
-        Material::Unit bUnit = Material::Unit::gcm2;
-        if (theBack->Z > 92){
-            stopBack = new BetheBlock(back, fragment);
-            bUnit = Material::gcm2;
-            std::cout << "Warning: Back coating Z= " << theBack->Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopBack = new Ziegler1985(back, fragment);
-            bUnit = Material::um;
-        }
-
-        // Setting up stopping power for the absorber.
-        StoppingPower *stopAbsor;
-        if (theTelescope->Absorber.Z > 92){
-            stopAbsor = new BetheBlock(abs, fragment);
-            std::cout << "Warning: Absorber Z= " << theTelescope->Absorber.Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopAbsor = new Ziegler1985(abs, fragment);
-        }
-
-        // Setting up stopping power for thin detector.
-        StoppingPower *stopDE;
-        if (theTelescope->dEdetector.Z > 92){
-            stopDE = new BetheBlock(dEdet, fragment);
-            std::cout << "Warning: dE detector Z= " << theTelescope->dEdetector.Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopDE = new Ziegler1985(dEdet, fragment);
-        }
-
-        // Setting up stopping power for thick detector.
-        StoppingPower *stopE;
-        if (theTelescope->Edetector.Z > 92){
-            stopE = new BetheBlock(Edet, fragment);
-            std::cout << "Warning: E detector Z= " << theTelescope->Edetector.Z;
-            std::cout << ", Ziegler stopping-power only supports elements up to Z=92. Using Bethe-Block formula for the stopping power.";
-            std::cout << std::endl;
-        } else {
-            stopE = new Ziegler1985(Edet, fragment);
-        }
-        double E_beam = theBeam->E;
-        if (theFront->is_present)
-            E_beam = stopFrontB->Loss(E_beam, INTPOINTS);
-
-        double Ehalf, Ewhole;
-        if (haveCpro){
-            Ehalf = proCustom->Loss(E_beam, target->GetWidth(Material::Unit::mgcm2)/2., INTPOINTS); // The stopping power are in ug/cm^2
-            Ewhole = proCustom->Loss(E_beam, target->GetWidth(Material::Unit::mgcm2), INTPOINTS);
-        } else {
-            Ehalf = stopTargetB->Loss(E_beam, target->GetWidth(tUnit)/2., INTPOINTS);
-            Ewhole = stopTargetB->Loss(E_beam, INTPOINTS);
-        }
-        double dEx = scat->FindMaxEx(Ewhole, Angle)/double(POINTS - 1);
-
-        if ((Ehalf + get_Q_keV(theBeam->A, theBeam->Z, theTarget->A, theTarget->Z, fA, fZ)/1000.)<0){
-            // Particles.
-            delete beam;
-            delete scatIso;
-            delete fragment;
-            delete residual;
-
-            // Materials.
-            delete target;
-            delete front;
-            delete back;
-            delete abs;
-            delete dEdet;
-            delete Edet;
-
-            // Scattering calculator.
-            delete scat;
-
-            // Stopping power calculators.
-            delete stopTargetB;
-            delete stopTargetF;
-            delete stopFrontB;
-            delete stopFrontF;
-            delete stopBack;
-            delete stopAbsor;
-            delete stopDE;
-            delete stopE;
-            return false; // Reaction not possible. Not enough energy :(
-        }
-
-        QVector<double> Ex_tmp(POINTS), dE_tmp(POINTS), E_tmp(POINTS), E_err_tmp(POINTS), is_punch(POINTS);
-
-        Ex.clear();
-        dE.clear();
-        E.clear();
-
-        adouble l(POINTS);
-        adouble m(POINTS), dm(POINTS), em(POINTS);
-        adouble n(POINTS);
-
-        for (int i = 0 ; i < POINTS ; ++i){
-            Ex_tmp[i] = i*dEx;
         }
 
-        for (int i = 0 ; i < POINTS ; ++i){
-            l[i] = scat->EvaluateY(E_beam, Angle, Ex_tmp[i]);
-            m[i] = scat->EvaluateY(Ehalf, Angle, Ex_tmp[i]);
-            n[i] = scat->EvaluateY(Ewhole, Angle, Ex_tmp[i]);
-        }
+        for (int i = 0 ; i < count ; ++i)
+            e_err[i] = sqrt(3*l[i]*l[i] + 3*n[i]*n[i] + 4*m[i]*m[i] - 2*n[i]*l[i] -4*m[i]*(l[i] + n[i]))/4.;
 
-        if (Angle > PI/2.){
-            if (haveCfrag){
-                for (int i = 0 ; i < POINTS ; ++i){
-                    n[i] = fragCustom->Loss(n[i], target->GetWidth(Material::Unit::mgcm2)/fabs(cos(Angle)), INTPOINTS);
-                }
-            } else {
-                for (int i = 0 ; i < POINTS ; ++i){
-                    n[i] = stopTargetF->Loss(n[i], target->GetWidth(tUnit)/fabs(cos(Angle)), INTPOINTS);
-                }
-            }
-        } else {
-            if (haveCfrag){
-                for (int i = 0 ; i < POINTS ; ++i)
-                    l[i] = fragCustom->Loss(l[i], target->GetWidth(Material::Unit::mgcm2)/fabs(cos(Angle)), INTPOINTS);
+        m = (l + 2*m + n)/4.;
+        Profiler::Timer detectorTimer(Profiler::Detectors);
+        for (int i = 0 ; i < count ; ++i){
+            if (useLayerTables){
+                dm[i] = tDE->Loss(m[i], wDE);
+                em[i] = tE->Loss(dm[i], wE);
             } else {
-                for (int i = 0 ; i < POINTS ; ++i)
-                    l[i] = stopTargetF->Loss(l[i], target->GetWidth(tUnit)/fabs(cos(Angle)), INTPOINTS);
+                dm[i] = stopDE->Loss(m[i], INTPOINTS);
+                em[i] = stopE->Loss(dm[i], INTPOINTS);
             }
-        }
-        if (haveCfrag){
-            for (int i = 0 ; i < POINTS ; ++i)
-                m[i] = fragCustom->Loss(m[i], target->GetWidth(Material::Unit::mgcm2)/fabs(2*cos(Angle)), INTPOINTS);
-        } else {
-            for (int i = 0 ; i < POINTS ; ++i)
-                m[i] = stopTargetF->Loss(m[i], target->GetWidth(tUnit)/fabs(2*cos(Angle)), INTPOINTS);
-        }
 
-        if (Angle > PI/2. && theFront->is_present){
-            for (int i = 0 ; i < POINTS ; ++i){
-                l[i] = stopFrontF->Loss(l[i], front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-                m[i] = stopFrontF->Loss(m[i], front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-                n[i] = stopFrontF->Loss(n[i], front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
+            de[i] = m[i] - dm[i];
+            e[i] = dm[i] - em[i];
+            punch[i] = em[i];
+            if (em[i] != em[i])
+                punch[i] = 1000;
+        }
+        detectorTimer.Stop();
+    };
+
+    QVector<double> Ex_tmp, dE_tmp, E_tmp, E_err_tmp, is_punch;
+    if (points > 0 && curvePoints > 0){
+        // Start from a coarse grid and split the intervals where the
+        // band is least straight in the dE-E plane, or where a point
+        // starts punching through or falls below E_MIN, until the
+        // budget is used.
+        const int budget = std::max(curvePoints, 3);
+        int count = std::min(std::max(budget/8, 9), budget);
+        double dEx = (ExHi - ExLo)/double(count - 1);
+        Ex_tmp.resize(count);
+        dE_tmp.resize(count);
+        E_tmp.resize(count);
+        E_err_tmp.resize(count);
+        is_punch.resize(count);
+        for (int i = 0 ; i < count ; ++i)
+            Ex_tmp[i] = ExLo + i*dEx;
+        Sample(count, Ex_tmp.data(), dE_tmp.data(), E_tmp.data(), E_err_tmp.data(), is_punch.data());
+
+        const double tolerance = curveTolerance, minWidth = 1e-9*(ExHi - ExLo);
+        auto Kind = [&](const int &i){
+            if (!std::isfinite(dE_tmp[i] + E_tmp[i]))
+                return 0;
+            return 1 + (is_punch[i] <= 0.05) + 2*(E_tmp[i] >= E_MIN);
+        };
+        while (count < budget){
+            double scaleE = 0, scaledE = 0;
+            for (int i = 0 ; i < count ; ++i){
+                if (Kind(i) > 0){
+                    scaleE = std::max(scaleE, fabs(E_tmp[i]));
+                    scaledE = std::max(scaledE, fabs(dE_tmp[i]));
+                }
             }
-        } else if (theBack->is_present){
-            for (int i = 0 ; i < POINTS ; ++i){
-                l[i] = stopBack->Loss(l[i], INTPOINTS);
-                m[i] = stopBack->Loss(m[i], INTPOINTS);
-                n[i] = stopBack->Loss(n[i], INTPOINTS);
+            scaleE = (scaleE > 0) ? 1/scaleE : 1;
+            scaledE = (scaledE > 0) ? 1/scaledE : 1;
+
+            // Distance of each point from the chord of its neighbours.
+            std::vector<double> bend(count, 0);
+            for (int i = 1 ; i + 1 < count ; ++i){
+                if (Kind(i - 1) != Kind(i) || Kind(i + 1) != Kind(i) || Kind(i) == 0)
+                    continue;
+                double x0 = E_tmp[i - 1]*scaleE, y0 = dE_tmp[i - 1]*scaledE;
+                double dx = E_tmp[i + 1]*scaleE - x0, dy = dE_tmp[i + 1]*scaledE - y0;
+                double px = E_tmp[i]*scaleE - x0, py = dE_tmp[i]*scaledE - y0;
+                double len = hypot(dx, dy);
+                bend[i] = (len > 0) ? fabs(px*dy - py*dx)/len : hypot(px, py);
             }
-        }
-
-        if (theTelescope->has_absorber){
-            for (int i = 0 ; i < POINTS ; ++i){
-                l[i] = stopAbsor->Loss(l[i], INTPOINTS);
-                m[i] = stopAbsor->Loss(m[i], INTPOINTS);
-                n[i] = stopAbsor->Loss(n[i], INTPOINTS);
+            std::vector<std::pair<double, int> > split;
+            for (int i = 0 ; i + 1 < count ; ++i){
+                if (Ex_tmp[i + 1] - Ex_tmp[i] <= minWidth)
+                    continue;
+                double error = (Kind(i) != Kind(i + 1)) ? HUGE_VAL : std::max(bend[i], bend[i + 1]);
+                if (error > tolerance)
+                    split.push_back(std::make_pair(error, i));
             }
-        }
-
-        for (int i = 0 ; i < POINTS ; ++i)
-            E_err_tmp[i] = sqrt(3*l[i]*l[i] + 3*n[i]*n[i] + 4*m[i]*m[i] - 2*n[i]*l[i] -4*m[i]*(l[i] + n[i]))/4.;
-
-        m = (l + 2*m + n)/4.;
-        for (int i = 0 ; i < POINTS ; ++i){
-            dm[i] = stopDE->Loss(m[i], INTPOINTS);
-            em[i] = stopE->Loss(dm[i], INTPOINTS);
-
-            dE_tmp[i] = m[i] - dm[i];
-            E_tmp[i] = dm[i] - em[i];
-            is_punch[i] = em[i];
-            if (em[i] != em[i])
-                is_punch[i] = 1000;
-        }
-
-        QVector<double> is_punch2, E_err;
-        int not_punch = 0;
-        for (int i = 0 ; i < Ex_tmp.size() ; ++i){
-            if (E_tmp[i] >= 0.35){
-                Ex.push_back(Ex_tmp[i]);
-                dE.push_back(dE_tmp[i]);
-                E.push_back(E_tmp[i]);
-                is_punch2.push_back(is_punch[i]);
-                E_err.push_back(E_err_tmp[i]);
-                if (is_punch[i] <= 0.05)
-                    not_punch += 1;
+            if (split.empty())
+                break;
+            if (int(split.size()) > budget - count){
+                std::partial_sort(split.begin(), split.begin() + (budget - count), split.end(),
+                                  [](const auto &a, const auto &b){ return a.first > b.first; });
+                split.resize(budget - count);
             }
-        }
-
-        if (not_punch >= 3){
-            double *x = new double[not_punch];
-            double *y = new double[not_punch];
-            double *dx = new double[not_punch];
-            int j = 0;
-            for (int i = 0 ; i < is_punch2.size() ; ++i){
-                if (is_punch2[i] <= 0.05 && j < not_punch){
-                    x[j] = dE[i] + E[i];
-                    y[j] = Ex[i];
-                    dx[j] = E_err[i];
-                    ++j;
+            std::sort(split.begin(), split.end(), [](const auto &a, const auto &b){ return a.second < b.second; });
+
+            int added = int(split.size());
+            QVector<double> ex(added), de(added), e(added), e_err(added), pu(added);
+            for (int k = 0 ; k < added ; ++k)
+                ex[k] = 0.5*(Ex_tmp[split[k].second] + Ex_tmp[split[k].second + 1]);
+            Sample(added, ex.data(), de.data(), e.data(), e_err.data(), pu.data());
+
+            // Each new point goes right after the interval it splits.
+            QVector<double> Ex_new, dE_new, E_new, E_err_new, punch_new;
+            Ex_new.reserve(count + added);
+            dE_new.reserve(count + added);
+            E_new.reserve(count + added);
+            E_err_new.reserve(count + added);
+            punch_new.reserve(count + added);
+            for (int i = 0, k = 0 ; i < count ; ++i){
+                Ex_new.push_back(Ex_tmp[i]);
+                dE_new.push_back(dE_tmp[i]);
+                E_new.push_back(E_tmp[i]);
+                E_err_new.push_back(E_err_tmp[i]);
+                punch_new.push_back(is_punch[i]);
+                if (k < added && split[k].second == i){
+                    Ex_new.push_back(ex[k]);
+                    dE_new.push_back(de[k]);
+                    E_new.push_back(e[k]);
+                    E_err_new.push_back(e_err[k]);
+                    punch_new.push_back(pu[k]);
+                    ++k;
                 }
             }
-            Polyfit fitting(x, y, not_punch);
-            Vector fit = fitting(3);
-            coeff = QVector<double>(4);
-            coeff[0] = fit[0]; coeff[1] = fit[1]; coeff[2] = fit[2], coeff[3] = 0;
-
-            for (int i = 0 ; i < not_punch ; ++i){
-                coeff[3] += (y[i] - coeff[0] - coeff[1]*x[i] - coeff[2]*x[i]*x[i])*(y[i] - coeff[0] - coeff[1]*x[i] - coeff[2]*x[i]*x[i])/(dx[i]*dx[i]);
-            }
-            coeff[3] /= double(not_punch - 3);
-
-            delete[] x;
-            delete[] y;
-            delete[] dx;
+            Ex_tmp.swap(Ex_new);
+            dE_tmp.swap(dE_new);
+            E_tmp.swap(E_new);
+            E_err_tmp.swap(E_err_new);
+            is_punch.swap(punch_new);
+            count += added;
         }
-
-
-        // Clearing up memory.
-
-        // Particles.
-        delete beam;
-        delete scatIso;
-        delete fragment;
-        delete residual;
-
-        // Materials.
-        delete target;
-        delete front;
-        delete back;
-        delete abs;
-        delete dEdet;
-        delete Edet;
-
-        // Scattering calculator.
-        delete scat;
-
-        // Stopping power calculators.
-        delete stopTargetB;
-        delete stopTargetF;
-        delete stopFrontB;
-        delete stopFrontF;
-        delete stopBack;
-        delete stopAbsor;
-        delete stopDE;
-        delete stopE;
-
-        // Done with the work :)
-        return true;
-}
-
-bool Worker::Known(QVector<double> &Ex, QVector<double> &dE, QVector<double> &E, QVector<double> &delta_dE, QVector<double> &delta_E,
-                   const double &Angle, const int &fA, const int &fZ)
-{
-    double incAngle;
-    if (Angle > PI/2.)
-        incAngle = PI - ANG_FWD - Angle;
-    else
-        incAngle = Angle - ANG_FWD;
-
-    Particle *beam = new Particle(theBeam->Z, theBeam->A);
-    Particle *scatIso = new Particle(theTarget->Z, theTarget->A);
-    Particle *fragment = new Particle(fZ, fA);
-    Particle *residual = new Particle(theBeam->Z+theTarget->Z-fZ, theBeam->A+theTarget->A-fA);
-
-    Material *front = new Material(theFront->Z, theFront->A, theFront->width, Unit2MatUnit(theFront->unit));
-    Material *target = new Material(theTarget->Z, theTarget->A, theTarget->width, Unit2MatUnit(theTarget->unit));
-    Material *back = new Material(theBack->Z, theBack->A, theBack->width/fabs(cos(Angle)), Unit2MatUnit(theBack->unit));
-    Material *abs = new Material(theTelescope->Absorber.Z, Get_mm2(theTelescope->Absorber.Z), theTelescope->Absorber.width/cos(incAngle), Unit2MatUnit(theTelescope->Absorber.unit));
-    Material *dEdet = new Material(theTelescope->dEdetector.Z, Get_mm2(theTelescope->dEdetector.Z), theTelescope->dEdetector.width/cos(incAngle), Unit2MatUnit(theTelescope->dEdetector.unit));
-    Material *Edet = new Material(theTelescope->Edetector.Z, Get_mm2(theTelescope->Edetector.Z), theTelescope->Edetector.width/cos(incAngle), Unit2MatUnit(theTelescope->Edetector.unit));
-
-    RelScatter *scat = new RelScatter(beam, scatIso, fragment, residual);//new Iterative(beam, scatIso, fragment, residual);
-
-    // Setting up stopping power for the target.
-    StoppingPower *stopTargetB;
-    StoppingPower *stopTargetF;
-    Material::Unit tUnit;
-    if (theTarget->Z > 92){
-        stopTargetB = new BetheBlock(target, beam);
-        stopTargetF = new BetheBlock(target, fragment);
-        tUnit = Material::gcm2;
-    } else {
-        stopTargetB = new Ziegler1985(target, beam);
-        stopTargetF = new Ziegler1985(target, fragment);
-        tUnit = Material::um;
-    }
-
-    // Setting up stopping power for the fronting and backing.
-    StoppingPower *stopFrontB;
-    StoppingPower *stopFrontF;
-    Material::Unit fUnit;
-    if (theFront->Z > 92){
-        stopFrontB = new BetheBlock(front, beam);
-        stopFrontF = new BetheBlock(front, fragment);
-        fUnit = Material::gcm2;
-    } else {
-        stopFrontB = new Ziegler1985(front, beam);
-        stopFrontF = new Ziegler1985(front, fragment);
-        fUnit = Material::um;
-    }
-    StoppingPower *stopBack;
-    Material::Unit bUnit  = Material::Unit::gcm2;
-    if (theBack->Z > 92){
-        stopBack = new BetheBlock(back, fragment);
-        bUnit = Material::gcm2;
-    } else {
-        stopBack = new Ziegler1985(back, fragment);
-        bUnit = Material::um;
-    }
-
-    // Setting up stopping power for the absorber.
-    StoppingPower *stopAbsor;
-    if (theTelescope->Absorber.Z > 92){
-        stopAbsor = new BetheBlock(abs, fragment);
     } else {
-        stopAbsor = new Ziegler1985(abs, fragment);
+        double dEx = (points > 1) ? (ExHi - ExLo)/double(points - 1) : 0;
+        Ex_tmp.resize(points);
+        dE_tmp.resize(points);
+        E_tmp.resize(points);
+        E_err_tmp.resize(points);
+        is_punch.resize(points);
+        for (int i = 0 ; i < points ; ++i)
+            Ex_tmp[i] = ExLo + i*dEx;
+        Sample(points, Ex_tmp.data(), dE_tmp.data(), E_tmp.data(), E_err_tmp.data(), is_punch.data());
     }
 
-    // Setting up stopping power for thin detector.
-    StoppingPower *stopDE;
-    if (theTelescope->dEdetector.Z > 92){
-        stopDE = new BetheBlock(dEdet, fragment);
-    } else {
-        stopDE = new Ziegler1985(dEdet, fragment);
-    }
-
-    // Setting up stopping power for thick detector.
-    StoppingPower *stopE;
-    if (theTelescope->Edetector.Z > 92){
-        stopE = new BetheBlock(Edet, fragment);
-    } else {
-        stopE = new Ziegler1985(Edet, fragment);
-    }
-
-    double E_beam = theBeam->E;
-    if (theFront->is_present)
-        E_beam = stopFrontB->Loss(E_beam, INTPOINTS);
-
-    double Ehalf = stopTargetB->Loss(E_beam, target->GetWidth(tUnit)/2., INTPOINTS);
-    double Ewhole = stopTargetB->Loss(E_beam, INTPOINTS);
-
-    double Exmax = scat->FindMaxEx(Ewhole, Angle);
-
-    if ((Ehalf + get_Q_keV(theBeam->A, theBeam->Z, theTarget->A, theTarget->Z, fA, fZ)/1000.)<0){
-        // Particles.
-        delete beam;
-        delete scatIso;
-        delete fragment;
-        delete residual;
-        
-        // Materials.
-        delete target;
-        delete front;
-        delete back;
-        delete abs;
-        delete dEdet;
-        delete Edet;
-        
-        // Scattering calculator.
-        delete scat;
-        
-        // Stopping power calculators.
-        delete stopTargetB;
-        delete stopTargetF;
-        delete stopFrontB;
-        delete stopFrontF;
-        delete stopBack;
-        delete stopAbsor;
-        delete stopDE;
-        delete stopE;
-        return false; // Reaction not possible. Not enough energy :(
-    }
-
-    Excitation ex_data(residual->GetA(), residual->GetZ()); // Class to fetch known energy levels from file.
-
-    QVector<double> tmp = ex_data.asVector();
-
-    if (tmp.empty()){ // If empty, no data excists :(
-        // Particles.
-        delete beam;
-        delete scatIso;
-        delete fragment;
-        delete residual;
-        
-        // Materials.
-        delete target;
-        delete front;
-        delete back;
-        delete abs;
-        delete dEdet;
-        delete Edet;
-        
-        // Scattering calculator.
-        delete scat;
-        
-        // Stopping power calculators.
-        delete stopTargetB;
-        delete stopTargetF;
-        delete stopFrontB;
-        delete stopFrontF;
-        delete stopBack;
-        delete stopAbsor;
-        delete stopDE;
-        delete stopE;
-        return false; // No known energy levels in the residual nucleus :(
-    }
-    QVector<double> Ex_tmp;
-
-    // Only calculate points that are below the maximum possible excitation energy.
-    for (int i = 0 ; i < tmp.size() ; ++i){
-        if (tmp[i] <= Exmax){
-            Ex_tmp.push_back(tmp[i]);
-        }
-    }
-    if (Ex_tmp.empty()){
-        // Particles.
-        delete beam;
-        delete scatIso;
-        delete fragment;
-        delete residual;
-        
-        // Materials.
-        delete target;
-        delete front;
-        delete back;
-        delete abs;
-        delete dEdet;
-        delete Edet;
-
-        // Scattering calculator.
-        delete scat;
-
-        // Stopping power calculators.
-        delete stopTargetB;
-        delete stopTargetF;
-        delete stopFrontB;
-        delete stopFrontF;
-        delete stopBack;
-        delete stopAbsor;
-        delete stopDE;
-        delete stopE;
-        return false; // No energy levels that can be used. :(
-    }
-
-    tmp.clear(); // We dont need this data anymore. Clearing up memory.
-
-    QVector<double> dE_tmp(Ex_tmp.size());
-    QVector<double> E_tmp(Ex_tmp.size());
-    QVector<double> delta_dE_tmp(Ex_tmp.size());
-    QVector<double> delta_E_tmp(Ex_tmp.size());
-
-    double f, m, b;
-    double df, dm, db;
-    double ef, em, eb;
-
-    for (int i = 0 ; i < Ex_tmp.size() ; ++i){
-
-        f = scat->EvaluateY(E_beam, Angle, Ex_tmp[i]);
-        m = scat->EvaluateY(Ehalf, Angle, Ex_tmp[i]);
-        b = scat->EvaluateY(Ewhole, Angle, Ex_tmp[i]);
-
-        if (Angle > PI/2.){
-            b = stopTargetF->Loss(b, target->GetWidth(tUnit)/fabs(cos(Angle)), INTPOINTS);
-        } else {
-            f = stopTargetF->Loss(f, target->GetWidth(tUnit)/fabs(cos(Angle)), INTPOINTS);
-        }
-
-        m = stopTargetF->Loss(m, target->GetWidth(tUnit)/fabs(2*cos(Angle)), INTPOINTS);
-
-        if (Angle > PI/2. && theFront->is_present){
-            f = stopFrontF->Loss(f, front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-            m = stopFrontF->Loss(m, front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-            b = stopFrontF->Loss(b, front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-        } else if (theBack->is_present){
-            f = stopBack->Loss(f, INTPOINTS);
-            m = stopBack->Loss(m, INTPOINTS);
-            b = stopBack->Loss(b, INTPOINTS);
-        }
-
-        if (theTelescope->has_absorber){
-            f = stopAbsor->Loss(f, INTPOINTS);
-            m = stopAbsor->Loss(m, INTPOINTS);
-            b = stopAbsor->Loss(b, INTPOINTS);
-        }
-
-        df = stopDE->Loss(f, INTPOINTS);
-        dm = stopDE->Loss(m, INTPOINTS);
-        db = stopDE->Loss(b, INTPOINTS);
-
-        ef = stopE->Loss(df, INTPOINTS);
-        em = stopE->Loss(dm, INTPOINTS);
-        eb = stopE->Loss(db, INTPOINTS);
-
-        dE_tmp[i] = m - dm;
-        delta_dE_tmp[i] = sqrt(0.5*((f-df - dE_tmp[i])*(f-df - dE_tmp[i]) + (b - db - dE_tmp[i])*(b - db - dE_tmp[i])));
-
-        E_tmp[i] = dm - em;
-        delta_E_tmp[i] = sqrt(0.5*((df - ef - E_tmp[i])*(df - ef - E_tmp[i]) + (db - eb - E_tmp[i])*(db - eb - E_tmp[i])));
-    }
-
-    // Making sure that there are no data left in the arrays.
     Ex.clear();
     dE.clear();
     E.clear();
-    delta_dE.clear();
-    delta_E.clear();
 
-    // Keeping only the points that are useless to uncertain due to limitations in the way we calculate stopping power.
+    QVector<double> is_punch2, E_err;
+    int not_punch = 0;
     for (int i = 0 ; i < Ex_tmp.size() ; ++i){
-        if (E_tmp[i] > 0.35){
+        if (E_tmp[i] >= E_MIN){
             Ex.push_back(Ex_tmp[i]);
             dE.push_back(dE_tmp[i]);
             E.push_back(E_tmp[i]);
-            delta_dE.push_back(delta_dE_tmp[i]);
-            delta_E.push_back(delta_E_tmp[i]);
+            is_punch2.push_back(is_punch[i]);
+            E_err.push_back(E_err_tmp[i]);
+            if (is_punch[i] <= 0.05)
+                not_punch += 1;
         }
     }
 
-    // Clearing up memory.
-    Ex_tmp.clear(); dE_tmp.clear(); E_tmp.clear(); delta_dE_tmp.clear(); delta_E_tmp.clear();
-
-    // Deleting stuff we dont need.
-
-    // Particles.
-    delete beam;
-    delete scatIso;
-    delete fragment;
-    delete residual;
-
-    // Materials.
-    delete target;
-    delete front;
-    delete back;
-    delete abs;
-    delete dEdet;
-    delete Edet;
-
-    // Scattering calculator.
-    delete scat;
-
-    // Stopping power calculators.
-    delete stopTargetB;
-    delete stopTargetF;
-    delete stopFrontB;
-    delete stopFrontF;
-    delete stopBack;
-    delete stopAbsor;
-    delete stopDE;
-    delete stopE;
+    if (not_punch >= 3){
+        Profiler::Timer timer(Profiler::Fitting);
+        std::vector<double> x(not_punch), y(not_punch), dx(not_punch);
+        int j = 0;
+        for (int i = 0 ; i < is_punch2.size() ; ++i){
+            if (is_punch2[i] <= 0.05 && j < not_punch){
+                x[j] = dE[i] + E[i];
+                y[j] = Ex[i];
+                dx[j] = E_err[i];
+                ++j;
+            }
+        }
+        Polyfit fitting(x.data(), y.data(), not_punch);
+        Vector fit = fitting(3);
+        coeff = QVector<double>(4);
+        coeff[0] = fit[0]; coeff[1] = fit[1]; coeff[2] = fit[2], coeff[3] = 0;
 
-    return true; // Calculations successful :D
+        for (int i = 0 ; i < not_punch ; ++i){
+            coeff[3] += (y[i] - coeff[0] - coeff[1]*x[i] - coeff[2]*x[i]*x[i])*(y[i] - coeff[0] - coeff[1]*x[i] - coeff[2]*x[i]*x[i])/(dx[i]*dx[i]);
+        }
+        coeff[3] /= double(not_punch - 3);
+    }
 
+    // Done with the work :)
+    return true;
 }
 
 bool Worker::Known(QVector<double> &Ex, QVector<double> &dE, QVector<double> &E, QVector<double> &delta_dE, QVector<double> &delta_E,
-                   const double &Angle, const double &incAngle, const int &fA, const int &fZ)
+                   const double &Angle, const int &fA, const int &fZ)
 {
+    double incAngle = Geometry::IncAngle(Angle);
+    return Known(Ex, dE, E, delta_dE, delta_E, Angle, incAngle, fA, fZ);
+}
 
-    Particle *beam = new Particle(theBeam->Z, theBeam->A);
-    Particle *scatIso = new Particle(theTarget->Z, theTarget->A);
-    Particle *fragment = new Particle(fZ, fA);
-    Particle *residual = new Particle(theBeam->Z+theTarget->Z-fZ, theBeam->A+theTarget->A-fA);
-
-    Material *front = new Material(theFront->Z, theFront->A, theFront->width, Unit2MatUnit(theFront->unit));
-    Material *target = new Material(theTarget->Z, theTarget->A, theTarget->width, Unit2MatUnit(theTarget->unit));
-    Material *back = new Material(theBack->Z, theBack->A, theBack->width/fabs(cos(Angle)), Unit2MatUnit(theBack->unit));
-    Material *abs = new Material(theTelescope->Absorber.Z, Get_mm2(theTelescope->Absorber.Z), theTelescope->Absorber.width/cos(incAngle), Unit2MatUnit(theTelescope->Absorber.unit));
-    Material *dEdet = new Material(theTelescope->dEdetector.Z, Get_mm2(theTelescope->dEdetector.Z), theTelescope->dEdetector.width/cos(incAngle), Unit2MatUnit(theTelescope->dEdetector.unit));
-    Material *Edet = new Material(theTelescope->Edetector.Z, Get_mm2(theTelescope->Edetector.Z), theTelescope->Edetector.width/cos(incAngle), Unit2MatUnit(theTelescope->Edetector.unit));
-
-    RelScatter *scat = new RelScatter(beam, scatIso, fragment, residual);//new Iterative(beam, scatIso, fragment, residual);
-
-    // Setting up stopping power for the target.
-    StoppingPower *stopTargetB;
-    StoppingPower *stopTargetF;
-    Material::Unit tUnit;
-    if (theTarget->Z > 92){
-        stopTargetB = new BetheBlock(target, beam);
-        stopTargetF = new BetheBlock(target, fragment);
-        tUnit = Material::gcm2;
-    } else {
-        stopTargetB = new Ziegler1985(target, beam);
-        stopTargetF = new Ziegler1985(target, fragment);
-        tUnit = Material::um;
-    }
-
-    // Setting up stopping power for the fronting and backing.
-    StoppingPower *stopFrontB;
-    StoppingPower *stopFrontF;
-    Material::Unit fUnit;
-    if (theFront->Z > 92){
-        stopFrontB = new BetheBlock(front, beam);
-        stopFrontF = new BetheBlock(front, fragment);
-        fUnit = Material::gcm2;
-    } else {
-        stopFrontB = new Ziegler1985(front, beam);
-        stopFrontF = new Ziegler1985(front, fragment);
-        fUnit = Material::um;
-    }
-    StoppingPower *stopBack;
-    Material::Unit bUnit  = Material::Unit::gcm2;
-    if (theBack->Z > 92){
-        stopBack = new BetheBlock(back, fragment);
-        bUnit = Material::gcm2;
-    } else {
-        stopBack = new Ziegler1985(back, fragment);
-        bUnit = Material::um;
-    }
-
-    // Setting up stopping power for the absorber.
-    StoppingPower *stopAbsor;
-    if (theTelescope->Absorber.Z > 92){
-        stopAbsor = new BetheBlock(abs, fragment);
-    } else {
-        stopAbsor = new Ziegler1985(abs, fragment);
-    }
-
-    // Setting up stopping power for thin detector.
-    StoppingPower *stopDE;
-    if (theTelescope->dEdetector.Z > 92){
-        stopDE = new BetheBlock(dEdet, fragment);
-    } else {
-        stopDE = new Ziegler1985(dEdet, fragment);
-    }
-
-    // Setting up stopping power for thick detector.
-    StoppingPower *stopE;
-    if (theTelescope->Edetector.Z > 92){
-        stopE = new BetheBlock(Edet, fragment);
-    } else {
-        stopE = new Ziegler1985(Edet, fragment);
-    }
-
-    double E_beam = theBeam->E;
-    if (theFront->is_present)
+bool Worker::Known(QVector<double> &Ex, QVector<double> &dE, QVector<double> &E, QVector<double> &delta_dE, QVector<double> &delta_E,
+                   const double &Angle, const double &incAngle, const int &fA, const int &fZ, const int &component)
+{
+    const Setup_t setup = Snapshot();
+    if (component < 0 || component > int(setup.contaminants.size()))
+        return false;
+    const auto [tA, tZ] = Isotope(setup, component);
+    Profiler::Timer setupTimer(Profiler::Setup);
+
+    Particle beam(setup.beam.Z, setup.beam.A);
+    Particle scatIso(tZ, tA);
+    Particle fragment(fZ, fA);
+    Particle residual(setup.beam.Z+tZ-fZ, setup.beam.A+tA-fA);
+
+    Material front(setup.front.Z, setup.front.A, setup.front.width, Geometry::MatUnit(setup.front.unit));
+    Material target(setup.target.Z, setup.target.A, setup.target.width, Geometry::MatUnit(setup.target.unit));
+    Material back(setup.back.Z, setup.back.A, Geometry::Path(setup.back.width, Angle), Geometry::MatUnit(setup.back.unit));
+    Material abs(setup.telescope.Absorber.Z, Get_mm2(setup.telescope.Absorber.Z), Geometry::TelescopePath(setup.telescope.Absorber.width, incAngle), Geometry::MatUnit(setup.telescope.Absorber.unit));
+    Material dEdet(setup.telescope.dEdetector.Z, Get_mm2(setup.telescope.dEdetector.Z), Geometry::TelescopePath(setup.telescope.dEdetector.width, incAngle), Geometry::MatUnit(setup.telescope.dEdetector.unit));
+    Material Edet(setup.telescope.Edetector.Z, Get_mm2(setup.telescope.Edetector.Z), Geometry::TelescopePath(setup.telescope.Edetector.width, incAngle), Geometry::MatUnit(setup.telescope.Edetector.unit));
+
+    RelScatter scat(&beam, &scatIso, &fragment, &residual);
+
+    // Stopping powers of the layers.
+    double EmaxF = FragmentEmax(setup, fA, fZ, component);
+    Material::Unit tUnitB, fUnitB, tUnit, fUnit, bUnit, aUnit, dUnit, eUnit;
+    std::unique_ptr<StoppingPower> stopTargetB(StoppingModel::Make(&target, &beam, setup.beam.E, tUnitB, precision));
+    std::unique_ptr<StoppingPower> stopTargetF(StoppingModel::Make(&target, &fragment, EmaxF, tUnit, precision));
+    std::unique_ptr<StoppingPower> stopFrontB(StoppingModel::Make(&front, &beam, setup.beam.E, fUnitB, precision));
+    std::unique_ptr<StoppingPower> stopFrontF(StoppingModel::Make(&front, &fragment, EmaxF, fUnit, precision));
+    std::unique_ptr<StoppingPower> stopBack(StoppingModel::Make(&back, &fragment, EmaxF, bUnit, precision));
+    std::unique_ptr<StoppingPower> stopAbsor(StoppingModel::Make(&abs, &fragment, EmaxF, aUnit, precision));
+    std::unique_ptr<StoppingPower> stopDE(StoppingModel::Make(&dEdet, &fragment, EmaxF, dUnit, precision));
+    std::unique_ptr<StoppingPower> stopE(StoppingModel::Make(&Edet, &fragment, EmaxF, eUnit, precision));
+
+    setupTimer.Stop();
+
+    Profiler::Timer beamTimer(Profiler::BeamLoss);
+    double E_beam = setup.beam.E;
+    if (setup.front.is_present)
         E_beam = stopFrontB->Loss(E_beam, INTPOINTS);
 
-    double Ehalf = stopTargetB->Loss(E_beam, target->GetWidth(tUnit)/2., INTPOINTS);
+    double Ehalf = stopTargetB->Loss(E_beam, target.GetWidth(tUnitB)/2., INTPOINTS);
     double Ewhole = stopTargetB->Loss(E_beam, INTPOINTS);
+    beamTimer.Stop();
+
+    Profiler::Timer maxTimer(Profiler::Kinematics);
+    double Exmax = scat.FindMaxEx(Ewhole, Angle);
+    maxTimer.Stop();
 
-    double Exmax = scat->FindMaxEx(Ewhole, Angle);
-
-    if ((Ehalf + get_Q_keV(theBeam->A, theBeam->Z, theTarget->A, theTarget->Z, fA, fZ)/1000.)<0){
-        // Particles.
-        delete beam;
-        delete scatIso;
-        delete fragment;
-        delete residual;
-
-        // Materials.
-        delete target;
-        delete front;
-        delete back;
-        delete abs;
-        delete dEdet;
-        delete Edet;
-
-        // Scattering calculator.
-        delete scat;
-
-        // Stopping power calculators.
-        delete stopTargetB;
-        delete stopTargetF;
-        delete stopFrontB;
-        delete stopFrontF;
-        delete stopBack;
-        delete stopAbsor;
-        delete stopDE;
-        delete stopE;
+    if ((Ehalf + get_Q_keV(setup.beam.A, setup.beam.Z, tA, tZ, fA, fZ)/1000.)<0)
         return false; // Reaction not possible. Not enough energy :(
-    }
 
-    Excitation ex_data(residual->GetA(), residual->GetZ()); // Class to fetch known energy levels from file.
+    Profiler::Timer levelTimer(Profiler::Levels);
+    Excitation ex_data(residual.GetA(), residual.GetZ()); // Class to fetch known energy levels from file.
 
     QVector<double> tmp = ex_data.asVector();
+    levelTimer.Stop();
 
-    if (tmp.empty()){ // If empty, no data excists :(
-        // Particles.
-        delete beam;
-        delete scatIso;
-        delete fragment;
-        delete residual;
-
-        // Materials.
-        delete target;
-        delete front;
-        delete back;
-        delete abs;
-        delete dEdet;
-        delete Edet;
-
-        // Scattering calculator.
-        delete scat;
-
-        // Stopping power calculators.
-        delete stopTargetB;
-        delete stopTargetF;
-        delete stopFrontB;
-        delete stopFrontF;
-        delete stopBack;
-        delete stopAbsor;
-        delete stopDE;
-        delete stopE;
+    if (tmp.empty()) // If empty, no data excists :(
         return false; // No known energy levels in the residual nucleus :(
-    }
     QVector<double> Ex_tmp;
 
     // Only calculate points that are below the maximum possible excitation energy.
@@ -1307,91 +1106,83 @@ bool Worker::Known(QVector<double> &Ex, QVector<double> &dE, QVector<double> &E,
             Ex_tmp.push_back(tmp[i]);
         }
     }
-    if (Ex_tmp.empty()){
-        // Particles.
-        delete beam;
-        delete scatIso;
-        delete fragment;
-        delete residual;
-
-        // Materials.
-        delete target;
-        delete front;
-        delete back;
-        delete abs;
-        delete dEdet;
-        delete Edet;
-
-        // Scattering calculator.
-        delete scat;
-
-        // Stopping power calculators.
-        delete stopTargetB;
-        delete stopTargetF;
-        delete stopFrontB;
-        delete stopFrontF;
-        delete stopBack;
-        delete stopAbsor;
-        delete stopDE;
-        delete stopE;
+    if (Ex_tmp.empty())
         return false; // No energy levels that can be used. :(
-    }
 
     tmp.clear(); // We dont need this data anymore. Clearing up memory.
 
-    QVector<double> dE_tmp(Ex_tmp.size());
-    QVector<double> E_tmp(Ex_tmp.size());
-    QVector<double> delta_dE_tmp(Ex_tmp.size());
-    QVector<double> delta_E_tmp(Ex_tmp.size());
-
-    double f, m, b;
-    double df, dm, db;
-    double ef, em, eb;
+    // Energy of the fragment made in the front (f), the middle (m) and
+    // the back (b) of the target, taken through one layer at a time so
+    // each stage is timed once for all the levels.
+    const int count = Ex_tmp.size();
+    std::vector<double> f(count), m(count), b(count);
 
-    for (int i = 0 ; i < Ex_tmp.size() ; ++i){
-
-        f = scat->EvaluateY(E_beam, Angle, Ex_tmp[i]);
-        m = scat->EvaluateY(Ehalf, Angle, Ex_tmp[i]);
-        b = scat->EvaluateY(Ewhole, Angle, Ex_tmp[i]);
+    Profiler::Timer kinTimer(Profiler::Kinematics);
+    scat.Prepare(E_beam, Angle)(Ex_tmp.data(), f.data(), count);
+    scat.Prepare(Ehalf, Angle)(Ex_tmp.data(), m.data(), count);
+    scat.Prepare(Ewhole, Angle)(Ex_tmp.data(), b.data(), count);
+    kinTimer.Stop();
 
+    Profiler::Timer targetTimer(Profiler::TargetLayer);
+    for (int i = 0 ; i < count ; ++i){
         if (Angle > PI/2.){
-            b = stopTargetF->Loss(b, target->GetWidth(tUnit)/fabs(cos(Angle)), INTPOINTS);
+            b[i] = stopTargetF->Loss(b[i], Geometry::Path(target.GetWidth(tUnit), Angle), INTPOINTS);
         } else {
-            f = stopTargetF->Loss(f, target->GetWidth(tUnit)/fabs(cos(Angle)), INTPOINTS);
+            f[i] = stopTargetF->Loss(f[i], Geometry::Path(target.GetWidth(tUnit), Angle), INTPOINTS);
         }
 
-        m = stopTargetF->Loss(m, target->GetWidth(tUnit)/fabs(2*cos(Angle)), INTPOINTS);
-
-        if (Angle > PI/2. && theFront->is_present){
-            f = stopFrontF->Loss(f, front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-            m = stopFrontF->Loss(m, front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-            b = stopFrontF->Loss(b, front->GetWidth(fUnit)/fabs(cos(Angle)), INTPOINTS);
-        } else if (theBack->is_present){
-            f = stopBack->Loss(f, INTPOINTS);
-            m = stopBack->Loss(m, INTPOINTS);
-            b = stopBack->Loss(b, INTPOINTS);
+        m[i] = stopTargetF->Loss(m[i], Geometry::HalfPath(target.GetWidth(tUnit), Angle), INTPOINTS);
+    }
+    targetTimer.Stop();
+
+    Profiler::Timer layerTimer(Profiler::FrontBackLayer);
+    if (Geometry::ThroughFront(Angle, setup.front.is_present)){
+        double path = Geometry::Path(front.GetWidth(fUnit), Angle);
+        for (int i = 0 ; i < count ; ++i){
+            f[i] = stopFrontF->Loss(f[i], path, INTPOINTS);
+            m[i] = stopFrontF->Loss(m[i], path, INTPOINTS);
+            b[i] = stopFrontF->Loss(b[i], path, INTPOINTS);
+        }
+    } else if (setup.back.is_present){
+        for (int i = 0 ; i < count ; ++i){
+            f[i] = stopBack->Loss(f[i], INTPOINTS);
+            m[i] = stopBack->Loss(m[i], INTPOINTS);
+            b[i] = stopBack->Loss(b[i], INTPOINTS);
         }
+    }
+    layerTimer.Stop();
 
-        if (theTelescope->has_absorber){
-            f = stopAbsor->Loss(f, INTPOINTS);
-            m = stopAbsor->Loss(m, INTPOINTS);
-            b = stopAbsor->Loss(b, INTPOINTS);
+    if (setup.telescope.has_absorber){
+        Profiler::Timer absTimer(Profiler::AbsorberLayer);
+        for (int i = 0 ; i < count ; ++i){
+            f[i] = stopAbsor->Loss(f[i], INTPOINTS);
+            m[i] = stopAbsor->Loss(m[i], INTPOINTS);
+            b[i] = stopAbsor->Loss(b[i], INTPOINTS);
         }
+    }
 
-        df = stopDE->Loss(f, INTPOINTS);
-        dm = stopDE->Loss(m, INTPOINTS);
-        db = stopDE->Loss(b, INTPOINTS);
+    QVector<double> dE_tmp(count);
+    QVector<double> E_tmp(count);
+    QVector<double> delta_dE_tmp(count);
+    QVector<double> delta_E_tmp(count);
 
-        ef = stopE->Loss(df, INTPOINTS);
-        em = stopE->Loss(dm, INTPOINTS);
-        eb = stopE->Loss(db, INTPOINTS);
+    Profiler::Timer detectorTimer(Profiler::Detectors);
+    for (int i = 0 ; i < count ; ++i){
+        double df = stopDE->Loss(f[i], INTPOINTS);
+        double dm = stopDE->Loss(m[i], INTPOINTS);
+        double db = stopDE->Loss(b[i], INTPOINTS);
 
-        dE_tmp[i] = m - dm;
-        delta_dE_tmp[i] = sqrt(0.5*((f-df - dE_tmp[i])*(f-df - dE_tmp[i]) + (b - db - dE_tmp[i])*(b - db - dE_tmp[i])));
+        double ef = stopE->Loss(df, INTPOINTS);
+        double em = stopE->Loss(dm, INTPOINTS);
+        double eb = stopE->Loss(db, INTPOINTS);
+
+        dE_tmp[i] = m[i] - dm;
+        delta_dE_tmp[i] = sqrt(0.5*((f[i]-df - dE_tmp[i])*(f[i]-df - dE_tmp[i]) + (b[i] - db - dE_tmp[i])*(b[i] - db - dE_tmp[i])));
 
         E_tmp[i] = dm - em;
         delta_E_tmp[i] = sqrt(0.5*((df - ef - E_tmp[i])*(df - ef - E_tmp[i]) + (db - eb - E_tmp[i])*(db - eb - E_tmp[i])));
     }
+    detectorTimer.Stop();
 
     // Making sure that there are no data left in the arrays.
     Ex.clear();
@@ -1414,35 +1205,5 @@ bool Worker::Known(QVector<double> &Ex, QVector<double> &dE, QVector<double> &E,
     // Clearing up memory.
     Ex_tmp.clear(); dE_tmp.clear(); E_tmp.clear(); delta_dE_tmp.clear(); delta_E_tmp.clear();
 
-    // Deleting stuff we dont need.
-
-    // Particles.
-    delete beam;
-    delete scatIso;
-    delete fragment;
-    delete residual;
-
-    // Materials.
-    delete target;
-    delete front;
-    delete back;
-    delete abs;
-    delete dEdet;
-    delete Edet;
-
-    // Scattering calculator.
-    delete scat;
-
-    // Stopping power calculators.
-    delete stopTargetB;
-    delete stopTargetF;
-    delete stopFrontB;
-    delete stopFrontF;
-    delete stopBack;
-    delete stopAbsor;
-    delete stopDE;
-    delete stopE;
-
     return true; // Calculations successful :D
-
 }
@@ -25,6 +25,16 @@
 extern const double p1[][8];
 extern const double p2[][9];
 
+//! Ziegler 1985 data of an element, one cache aligned record each.
+struct alignas(64) ZieglerElement_t {
+    double pcoef[9];    //! Proton stopping cross section coefficients (Z first).
+    double rho;         //! Density [g/cm³].
+    double atrho;       //! Density [1/cm³].
+    double vfermi;      //! Fermi velocity [Bohr v].
+    double lfctr;       //! Ion screening length factor.
+    double mm2;         //! Mass number of the most abundant isotope.
+};
+
 int Get_minZ();
 int Get_maxZ();
 
@@ -36,4 +46,7 @@ double Get_mm2(int z);
 
 bool Get_pcoef(int z, double *data);
 
+//! \return the record of element z, nullptr if not in the table.
+const ZieglerElement_t *Get_element(int z);
+
 #endif // ZIEGLER1985_TABLE_H
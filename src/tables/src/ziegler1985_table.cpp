@@ -21,7 +21,9 @@
 
 #include "ziegler1985_table.h"
 
+#include <array>
 #include <iostream>
+#include <utility>
 
 int Get_minZ(){
 	return 1;
@@ -85,7 +87,7 @@ bool Get_pcoef(int z, double *data){
     return true;
 }
 
-const double p1[][8] = {
+constexpr double p1[][8] = {
         // mai: most abundant isotope
         // Z    Amai Mmai      Mnorm     dens     dens      vfermi    ion_screening_length
         //           amu       amu       g/cm3    1e22/cm3  Bohr v
@@ -183,7 +185,7 @@ const double p1[][8] = {
         {92, 238, 238.04,   238.04,   19.043,      4.818,  1.0257,    1.16}
     };
 
-const double p2[][9] = {
+constexpr double p2[][9] = {
        // Z ................proton stopping cross section coefficients................
         { 1, 0.0091827, 0.0053496, 0.69741, 0.48493, 316.07,  1.0143, 9329.3, 0.053989},
         { 2, 0.11393,   0.0051984, 1.0822,  0.39252, 1081,    1.0645, 4068.5, 0.017699},
@@ -287,3 +289,36 @@ const double p2[][9] = {
         {91, 33.702,    0.0036901, 0.47257, 0.89235, 5295.7,  0.8893,  2053.3, 0.0091908},
         {92, 2.7589,    0.0039806, 3.2092,  0.66122, 2505.4,  0.82863, 2065.1, 0.022816}
     };
+
+namespace {
+
+constexpr ZieglerElement_t MakeElement(const int &z)
+{
+    ZieglerElement_t element{};
+    for (int i = 0 ; i < 9 ; ++i)
+        element.pcoef[i] = p2[z - 1][i];
+    element.rho = p1[z - 1][4];
+    element.atrho = p1[z - 1][5]*1e22;
+    element.vfermi = p1[z - 1][6];
+    element.lfctr = p1[z - 1][7];
+    element.mm2 = p1[z - 1][1];
+    return element;
+}
+
+template<size_t... z>
+constexpr std::array<ZieglerElement_t, sizeof...(z)> MakeElements(std::index_sequence<z...>)
+{
+    return {{ MakeElement(int(z) + 1)... }};
+}
+
+// All elements of the table, made when compiling.
+constexpr std::array<ZieglerElement_t, 92> elements = MakeElements(std::make_index_sequence<92>());
+
+} // namespace
+
+const ZieglerElement_t *Get_element(int z){
+    if ( !in_table(z) ){
+        return nullptr;
+    }
+    return &elements[z - 1];
+}
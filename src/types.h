@@ -1,8 +1,8 @@
 #ifndef TYPES
 #define TYPES
 
-#include <QVector>
 #include <valarray>
+#include <vector>
 
 typedef std::valarray<double> adouble;
 
@@ -28,6 +28,13 @@ typedef struct {
     Unit_t unit;    //! Unit of the width parameter.
 } Target_t;
 
+//! An isotope contaminating the target, \see Worker::setContaminants.
+typedef struct {
+    int A;          //! Mass number of the contaminant.
+    int Z;          //! Element number of the contaminant.
+    double weight;  //! Number of atoms per atom of the target isotope.
+} Contaminant_t;
+
 //! Structure to contain parameters needed for the telescope.
 typedef struct {
     struct Element_str {
@@ -55,6 +62,50 @@ typedef struct {
     bool is_present;    //! If present or not.
 } Extra_t;
 
+//! Copy of all settings of a calculation, \see Worker.
+typedef struct {
+    Beam_t beam;            //! Beam settings.
+    Target_t target;        //! Target settings.
+    Extra_t front;          //! Target fronting settings.
+    Extra_t back;           //! Target backing settings.
+    Telescope_t telescope;  //! Telescope settings.
+    std::vector<Contaminant_t> contaminants;    //! Contaminants of the target.
+} Setup_t;
+
+//! Angular acceptance of a strip, \see Worker::Band.
+typedef struct {
+    double stripWidth;  //! Angle covered by the strip [rad].
+    double spotRadius;  //! Radius of the beam spot on the target [mm].
+    double distance;    //! Distance from the target to the strip [mm].
+    int nAngle;         //! Number of samples across the strip.
+    int nSpot;          //! Number of samples across the beam spot.
+} Acceptance_t;
+
+//! An exit channel and where its band is seen by the telescope, \see Worker::Channels.
+typedef struct {
+    int A, Z;           //! Fragment.
+    int resA, resZ;     //! Residual.
+    double Q;           //! Q-value [MeV].
+    int angles;         //! Number of angles where the fragment reaches the thick detector.
+    double ExMin;       //! Lowest excitation energy reaching the thick detector [MeV].
+    double ExMax;       //! Highest excitation energy reaching the thick detector [MeV].
+    double dEMin;       //! Lowest energy in the thin detector [MeV].
+    double dEMax;       //! Highest energy in the thin detector [MeV].
+    double EMin;        //! Lowest energy in the thick detector [MeV].
+    double EMax;        //! Highest energy in the thick detector [MeV].
+} ChannelBand_t;
+
+//! Setup parameters that derivatives are calculated for, \see Worker::Response.
+enum Param_t {
+    BeamEnergy,     //! Beam energy.
+    TargetWidth,    //! Width of the target.
+    AbsorberWidth,  //! Width of the absorber.
+    dEWidth,        //! Width of the dE detector.
+    EWidth,         //! Width of the E detector.
+    ScatAngle,      //! Scattering angle.
+    NumParams       //! Number of parameters.
+};
+
 //! Used to indicate data from what fragment.
 enum Fragment_t {
     Proton,     //! Protons.
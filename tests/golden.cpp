@@ -0,0 +1,441 @@
+// Golden-reference regression test of the calculations.
+//
+// Runs a matrix of beams, targets and telescopes through the stopping
+// powers, the kinematics and the Worker (dE-E curves, known states and
+// fit coefficients, as shown by the GUI and written by the batch mode),
+// and compares every value with a reference file made by an earlier build:
+//
+//   qkinz_golden --record reference.txt     Make the reference.
+//   qkinz_golden reference.txt              Compare with the reference.
+//
+// Each quantity has its own tolerance, |now - ref| <= rel*|ref| + abs,
+// which can be changed with --tolerance quantity=rel[,abs]. NaN only
+// matches NaN. The time of each section is compared with the reference
+// and printed; with --max-slowdown f the test also fails if a section
+// takes more than f times as long as when the reference was made.
+
+#include "worker.h"
+#include "types.h"
+
+#include "Material.h"
+#include "Particle.h"
+#include "RelScatter.h"
+#include "StoppingModel.h"
+#include "StoppingPower.h"
+
+#include <QObject>
+#include <QVector>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const double PI = acos(-1);
+
+//! Curves are recorded at every STRIDE'th point, known states up to LEVELS.
+const int STRIDE = 25;
+const int LEVELS = 20;
+
+//! Allowed deviation of a quantity, |now - ref| <= rel*|ref| + abs.
+struct Tolerance_t {
+    double rel;
+    double abs;
+};
+
+//! The quantities and their default tolerances.
+std::map<std::string, Tolerance_t> tolerances = {
+    {"stop",    {1e-9, 1e-12}},     // Stopping powers [MeV/unit], unit in the key.
+    {"loss",    {1e-9, 1e-12}},     // Energies after a layer [MeV].
+    {"kin",     {1e-12, 1e-12}},    // Energies of the fragment [MeV].
+    {"curve",   {1e-7, 1e-9}},      // Points of the dE-E curves [MeV].
+    {"known",   {1e-7, 1e-9}},      // dE-E of known states and their uncertainties [MeV].
+    {"coeff",   {1e-6, 1e-12}},     // Coefficients of the fits of excitation energy.
+};
+
+//! Values of a run, in the order they were made, and the time of each section.
+struct Results_t {
+    std::vector<std::pair<std::string, double> > values;    // "<quantity> <key>" and the value.
+    std::vector<std::pair<std::string, double> > times;     // Section and seconds.
+
+    void Add(const std::string &quantity, const std::string &key, const double &value)
+    {
+        values.push_back(std::make_pair(quantity + " " + key, value));
+    }
+};
+
+//! Times a section of the run.
+class Section
+{
+public:
+    Section(Results_t &results, const std::string &name)
+        : results( results ), name( name ), start( std::chrono::steady_clock::now() ){ }
+
+    ~Section()
+    {
+        std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+        results.times.push_back(std::make_pair(name, t.count()));
+    }
+
+private:
+    Results_t &results;
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+};
+
+//! A setup of the matrix.
+struct Setup {
+    const char *name;
+    Beam_t beam;
+    Target_t target;
+    Extra_t front;
+    Extra_t back;
+    Telescope_t telescope;
+    std::vector<Contaminant_t> contaminants;
+    bool batch;     // Range tables for the telescope and fast precision, as 'tables on' and 'precision fast'.
+};
+
+//! SiRi, with and without the absorber foil, and the setups run through the Worker.
+const Telescope_t SIRI = {{14, 130., um}, {14, 1550., um}, {13, 10.5, um}, true};
+const Telescope_t THIN = {{14, 65., um}, {14, 1000., um}, {13, 0., um}, false};
+const Extra_t NONE = {27, 13, 0., mgcm2, false};
+
+const std::vector<Setup> SETUPS = {
+    {"p16_Si28", {1, 1, 16.}, {28, 14, 4., mgcm2}, NONE, NONE, SIRI, {{16, 8, 0.05}}, false},
+    {"d13_Dy164", {2, 1, 13.}, {164, 66, 2., mgcm2}, {27, 13, 0.2, mgcm2, true}, {12, 6, 0.5, mgcm2, true}, SIRI, {}, false},
+    {"a30_Pb208", {4, 2, 30.}, {208, 82, 1., mgcm2}, NONE, NONE, THIN, {}, false},
+    {"d13_Dy164_batch", {2, 1, 13.}, {164, 66, 2., mgcm2}, {27, 13, 0.2, mgcm2, true}, {12, 6, 0.5, mgcm2, true}, SIRI, {}, true},
+};
+
+//! SiRi strips of the matrix, and if backward.
+const std::pair<int, bool> STRIPS[] = {{0, false}, {7, true}};
+
+const char *FragmentName(const Fragment_t &what)
+{
+    switch (what){
+    case Proton : return "p";
+    case Deutron : return "d";
+    case Triton : return "t";
+    case Helium3 : return "h3";
+    case Alpha : return "a";
+    default : return "other";
+    }
+}
+
+const char *UnitName(const Material::Unit &unit)
+{
+    return (unit == Material::gcm2) ? "gcm2" : (unit == Material::mgcm2) ? "mgcm2" : "um";
+}
+
+std::string Index(const std::string &name, const int &i)
+{
+    return name + "[" + std::to_string(i) + "]";
+}
+
+//! Stopping powers and energy losses of the models chosen by \ref StoppingModel.
+/*! The keys give the energy in [MeV] and the unit of the widths of the
+ *  model, the stopping powers are in [MeV] per that unit.
+ */
+void Stopping(Results_t &results)
+{
+    Section section(results, "stopping");
+    const int particles[][2] = {{1, 1}, {1, 2}, {2, 3}, {2, 4}, {6, 12}};
+    const int materials[][2] = {{6, 12}, {13, 27}, {14, 28}, {66, 164}, {79, 197}, {92, 238}};
+    const double energies[] = {0.3, 1., 3., 10., 30., 100., 300.};
+    for (auto &p : particles){
+        Particle particle(p[0], p[1]);
+        for (auto &m : materials){
+            Material material(m[0], m[1], 10., Material::um);
+            for (const double &E : energies){
+                Material::Unit unit;
+                std::unique_ptr<StoppingPower> sp(StoppingModel::Make(&material, &particle, E, unit));
+                char energy[32];
+                snprintf(energy, sizeof(energy), "E%gMeV", E);
+                std::string key = "Z" + std::to_string(p[0]) + "A" + std::to_string(p[1]) + "/Z" + std::to_string(m[0])
+                        + "/" + energy + "/" + UnitName(unit);
+                results.Add("stop", key, sp->Stopping(E));
+                results.Add("loss", key, sp->Loss(E, material.GetWidth(unit), 1001));
+            }
+        }
+    }
+}
+
+//! Energies of fragments of two-body reactions.
+void Kinematics(Results_t &results)
+{
+    Section section(results, "kinematics");
+    // Beam, target, fragment and residual, and the beam energy.
+    const int reactions[][8] = {{1, 1, 28, 14, 1, 1, 28, 14}, {1, 1, 28, 14, 2, 1, 27, 14}, {2, 1, 164, 66, 1, 1, 165, 66},
+                                {4, 2, 238, 92, 4, 2, 238, 92}, {3, 2, 90, 40, 4, 2, 89, 40}};
+    const double energies[] = {16., 16., 13., 30., 38.};
+    const double excitations[] = {0., 2., 5.};
+    for (int r = 0 ; r < 5 ; ++r){
+        const int *n = reactions[r];
+        Particle pA(n[1], n[0]), pX(n[3], n[2]), pY(n[5], n[4]), pB(n[7], n[6]);
+        RelScatter scat(&pA, &pX, &pY, &pB);
+        for (int deg = 0 ; deg <= 180 ; deg += 15){
+            for (const double &Ex : excitations){
+                std::string key = "r" + std::to_string(r) + "/t" + std::to_string(deg) + "/x" + std::to_string(int(Ex));
+                results.Add("kin", key, scat.EvaluateY(energies[r], deg*PI/180., Ex));
+            }
+        }
+    }
+}
+
+//! Curves, known states and fits of the Worker for a setup, as run from
+//! the GUI for all SiRi strips given, and the fits of the batch mode.
+void Pipeline(Results_t &results, Setup setup)
+{
+    Section section(results, std::string("worker/") + setup.name);
+    QVector<Contaminant_t> contaminants(setup.contaminants.begin(), setup.contaminants.end());
+    Worker worker(&setup.beam, &setup.target, &setup.front, &setup.back, &setup.telescope);
+    worker.setContaminants(contaminants);
+    worker.setPrecision((setup.batch) ? StoppingModel::Fast : StoppingModel::Exact);
+    worker.setLayerTables(setup.batch);
+
+    std::string prefix;
+    QObject::connect(&worker, &Worker::ResultCurve, [&](const QVector<double> &ex, const QVector<double> &e, const QVector<double> &de,
+                                                         const QVector<double> &coeff, const Fragment_t &what, const int &component){
+        std::string key = prefix + "/" + FragmentName(what) + "/c" + std::to_string(component);
+        results.Add("curve", key + "/n", ex.size());
+        for (int i = 0 ; i < ex.size() ; i += STRIDE){
+            results.Add("curve", Index(key + "/Ex", i), ex[i]);
+            results.Add("curve", Index(key + "/dE", i), de[i]);
+            results.Add("curve", Index(key + "/E", i), e[i]);
+        }
+        for (int i = 0 ; i < coeff.size() ; ++i)
+            results.Add("coeff", Index(key + "/fit", i), coeff[i]);
+    });
+    QObject::connect(&worker, &Worker::ResultScatter, [&](const QVector<double> &e, const QVector<double> &d_e, const QVector<double> &de,
+                                                           const QVector<double> &d_de, const QVector<double> &ex, const Fragment_t &what,
+                                                           const int &component){
+        std::string key = prefix + "/" + FragmentName(what) + "/c" + std::to_string(component);
+        results.Add("known", key + "/n", ex.size());
+        for (int i = 0 ; i < ex.size() && i < LEVELS ; ++i){
+            results.Add("known", Index(key + "/Ex", i), ex[i]);
+            results.Add("known", Index(key + "/dE", i), de[i]);
+            results.Add("known", Index(key + "/E", i), e[i]);
+            results.Add("known", Index(key + "/sigma_dE", i), d_de[i]);
+            results.Add("known", Index(key + "/sigma_E", i), d_e[i]);
+        }
+    });
+
+    for (auto &strip : STRIPS){
+        double incAngle = (2*strip.first - 7)*PI/180.;
+        double angle = 47*PI/180. + incAngle;
+        prefix = std::string(setup.name) + "/s" + std::to_string(strip.first) + ((strip.second) ? "b" : "f");
+        worker.Run((strip.second) ? PI - angle : angle, incAngle, true, true, true, true, true, -1, -1);
+    }
+
+    // The batch mode, with the incident angle of the telescope found from the angle.
+    const int fragments[][2] = {{1, 1}, {4, 2}};
+    double angle = 46*PI/180.;
+    for (auto &f : fragments){
+        for (int dir = 0 ; dir < 2 ; ++dir){
+            QVector<double> coeff;
+            std::string key = std::string(setup.name) + "/batch/s3" + ((dir) ? "b" : "f")
+                    + "/A" + std::to_string(f[0]) + "Z" + std::to_string(f[1]);
+            if (!worker.getCoeff((dir) ? PI - angle : angle, f[0], f[1], coeff))
+                continue;
+            for (int i = 0 ; i < coeff.size() ; ++i)
+                results.Add("coeff", Index(key, i), coeff[i]);
+        }
+    }
+}
+
+bool Record(const Results_t &results, const std::string &path)
+{
+    std::ofstream out(path);
+    if (!out.is_open()){
+        std::cerr << "Could not write '" << path << "'" << std::endl;
+        return false;
+    }
+    out << "# Qkinz golden reference, made by qkinz_golden --record\n";
+    char line[256];
+    for (auto &t : results.times){
+        snprintf(line, sizeof(line), "time %s %.3f\n", t.first.c_str(), t.second);
+        out << line;
+    }
+    for (auto &v : results.values){
+        snprintf(line, sizeof(line), "%s %.17g\n", v.first.c_str(), v.second);
+        out << line;
+    }
+    return bool(out);
+}
+
+bool Read(Results_t &results, const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in.is_open()){
+        std::cerr << "Could not read '" << path << "'" << std::endl;
+        return false;
+    }
+    std::string line;
+    int number = 0;
+    while (std::getline(in, line)){
+        ++number;
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream words(line);
+        std::string quantity, key, value;
+        if (!(words >> quantity >> key >> value)){
+            std::cerr << path << ":" << number << ": expected '<quantity> <key> <value>'" << std::endl;
+            return false;
+        }
+        char *end;
+        double v = strtod(value.c_str(), &end);
+        if (*end != '\0'){
+            std::cerr << path << ":" << number << ": '" << value << "' is not a number" << std::endl;
+            return false;
+        }
+        if (quantity == "time")
+            results.times.push_back(std::make_pair(key, v));
+        else
+            results.values.push_back(std::make_pair(quantity + " " + key, v));
+    }
+    return true;
+}
+
+//! \return true if all values are within the tolerances of the reference.
+bool Compare(const Results_t &ref, const Results_t &now)
+{
+    std::map<std::string, double> current(now.values.begin(), now.values.end());
+    std::map<std::string, int> checked, failed;
+    std::map<std::string, double> worst;
+    bool ok = true;
+    for (auto &v : ref.values){
+        std::string quantity = v.first.substr(0, v.first.find(' '));
+        auto tol = tolerances.find(quantity);
+        auto it = current.find(v.first);
+        ++checked[quantity];
+        if (tol == tolerances.end() || it == current.end()){
+            if (failed[quantity]++ < 10)
+                std::cout << v.first << ": " << ((tol == tolerances.end()) ? "unknown quantity" : "not calculated") << std::endl;
+            ok = false;
+            continue;
+        }
+        double r = v.second, x = it->second;
+        current.erase(it);
+        bool same = (std::isnan(r) || std::isnan(x)) ? (std::isnan(r) && std::isnan(x)) : fabs(x - r) <= tol->second.rel*fabs(r) + tol->second.abs;
+        if (!std::isnan(r) && !std::isnan(x) && r != 0)
+            worst[quantity] = std::max(worst[quantity], fabs(x - r)/fabs(r));
+        if (!same){
+            if (failed[quantity]++ < 10)
+                printf("%s: reference %.17g, now %.17g\n", v.first.c_str(), r, x);
+            ok = false;
+        }
+    }
+    for (auto &v : current){
+        std::string quantity = v.first.substr(0, v.first.find(' '));
+        if (failed[quantity]++ < 10)
+            std::cout << v.first << ": not in the reference" << std::endl;
+        ok = false;
+    }
+
+    printf("\n%-10s %8s %8s %12s %10s\n", "quantity", "values", "failed", "worst rel", "tolerance");
+    for (auto &c : checked){
+        auto tol = tolerances.find(c.first);
+        printf("%-10s %8d %8d %12.3g %10.3g\n", c.first.c_str(), c.second, failed[c.first], worst[c.first],
+               (tol == tolerances.end()) ? NAN : tol->second.rel);
+    }
+    return ok;
+}
+
+//! Prints the times of the sections against the reference.
+/*! \return false if a section is more than maxSlowdown times slower, not
+ *  counting sections shorter than 50 ms.
+ */
+bool Timing(const Results_t &ref, const Results_t &now, const double &maxSlowdown)
+{
+    std::map<std::string, double> before(ref.times.begin(), ref.times.end());
+    bool ok = true;
+    printf("\n%-24s %10s %10s %8s\n", "section", "ref [s]", "now [s]", "ratio");
+    for (auto &t : now.times){
+        auto it = before.find(t.first);
+        double r = (it == before.end()) ? NAN : it->second;
+        double ratio = (r > 0) ? t.second/r : NAN;
+        printf("%-24s %10.3f %10.3f %8.2f\n", t.first.c_str(), r, t.second, ratio);
+        if (maxSlowdown > 0 && r >= 0.05 && ratio > maxSlowdown)
+            ok = false;
+    }
+    if (!ok)
+        printf("Slower than %g times the reference.\n", maxSlowdown);
+    return ok;
+}
+
+void Usage(const char *name)
+{
+    std::cerr << "Usage: " << name << " [--record] [--tolerance quantity=rel[,abs]]... [--max-slowdown f] reference.txt" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    bool record = false;
+    double maxSlowdown = 0;
+    std::string path;
+    for (int i = 1 ; i < argc ; ++i){
+        std::string arg(argv[i]);
+        if (arg == "--record"){
+            record = true;
+        } else if (arg == "--tolerance" && i + 1 < argc){
+            std::string t(argv[++i]);
+            size_t eq = t.find('=');
+            auto tol = tolerances.find(t.substr(0, eq));
+            if (eq == std::string::npos || tol == tolerances.end()){
+                std::cerr << "Unknown quantity in '" << t << "'" << std::endl;
+                return 2;
+            }
+            char *end;
+            tol->second.rel = strtod(t.c_str() + eq + 1, &end);
+            if (*end == ',')
+                tol->second.abs = strtod(end + 1, &end);
+            if (*end != '\0'){
+                std::cerr << "Could not read the tolerance '" << t << "'" << std::endl;
+                return 2;
+            }
+        } else if (arg == "--max-slowdown" && i + 1 < argc){
+            maxSlowdown = atof(argv[++i]);
+        } else if (path.empty() && arg[0] != '-'){
+            path = arg;
+        } else {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path.empty()){
+        Usage(argv[0]);
+        return 2;
+    }
+
+    Results_t ref;
+    if (!record && !Read(ref, path))
+        return 2;
+
+    Results_t now;
+    Stopping(now);
+    Kinematics(now);
+    for (const Setup &setup : SETUPS)
+        Pipeline(now, setup);
+
+    if (record){
+        if (!Record(now, path))
+            return 2;
+        std::cout << "Recorded " << now.values.size() << " values in '" << path << "'" << std::endl;
+        return 0;
+    }
+    bool same = Compare(ref, now);
+    bool fast = Timing(ref, now, maxSlowdown);
+    return (same && fast) ? 0 : 1;
+}
@@ -3,6 +3,31 @@
 
 #include <Material.h>
 #include <Particle.h>
+#include <spline.h>
+#include <Dual.h>
+#include <StoppingTable.h>
+#include <RangeTable.h>
+#include <PunchThrough.h>
+#include <RelScatter.h>
+#include <DickNorbury.h>
+#include <Ziegler1985.h>
+#include <Decimate.h>
+#include <FastMath.h>
+#include <StoppingModel.h>
+#include <ZieglerBethe.h>
+#include <BetheBlock.h>
+#include <RangeCache.h>
+#include <ExitChannels.h>
+#include <KinematicsMap.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
 
 TEST_CASE( "Particle", "[Particle]" ) {
     SECTION("Look-up") {
@@ -16,4 +41,482 @@ TEST_CASE( "Material", "[Material]" ) {
         Material material(14, 28, 200, Material::um);
         REQUIRE(material.Getvfermi() == Approx(0.97411));
     }
+    SECTION("Table records") {
+        Material material(14, 28, 200, Material::um);
+        Material copy = material;
+        double pcoef[9];
+        REQUIRE(Get_pcoef(14, pcoef));
+        REQUIRE(copy.Getpcoef_ptr() == material.Getpcoef_ptr());
+        for (int i = 0 ; i < 9 ; ++i)
+            REQUIRE(material.Getpcoef(i) == pcoef[i]);
+        REQUIRE(material.Getrho() == Get_rho(14));
+        REQUIRE(material.Getatrho() == Get_atrho(14));
+        REQUIRE(Get_element(93) == nullptr);
+    }
+}
+
+TEST_CASE( "spline", "[spline]" ) {
+    std::vector<double> x = {0.1, 0.5, 1.0, 2.0, 3.5, 5.0};
+    std::vector<double> y = {1.0, 3.0, 2.5, 2.0, 1.2, 1.0};
+    spline s, u;
+    s.set_points(x, y);
+    u.set_points_resampled(x, y, 16.0);
+    REQUIRE(u.is_uniform());
+    SECTION("Cursor") {
+        size_t cursor = 0;
+        for (double e = 5.5 ; e > 0 ; e -= 0.05)
+            REQUIRE(s(e, cursor) == Approx(s(e)));
+    }
+    SECTION("Resampled") {
+        // A smooth stopping-power like curve on a geometric grid.
+        std::vector<double> xs, ys;
+        for (int i = 0 ; i < 12 ; ++i){
+            xs.push_back(0.5*pow(1.3, i));
+            ys.push_back(log(1 + 4*xs.back())/xs.back());
+        }
+        spline sg, ug;
+        sg.set_points(xs, ys);
+        ug.set_points_resampled(xs, ys, 16.0);
+        REQUIRE(ug.is_uniform());
+        for (size_t i = 0 ; i < xs.size() ; ++i)
+            REQUIRE(ug(xs[i]) == Approx(ys[i]).epsilon(5e-4));
+        for (double e = xs.front() ; e < xs.back() ; e += 0.01)
+            REQUIRE(ug(e) == Approx(sg(e)).epsilon(5e-4));
+    }
+}
+
+TEST_CASE( "StoppingTable", "[StoppingTable]" ) {
+    const char *file = "stoppingtable_test.txt";
+    {
+        std::ofstream out(file);
+        out << "Ion = Proton\n";
+        out << "500.0 keV 5.0 0.1\n";
+        out << "1.0 MeV 4.0 0.05\n";
+        out << "2.00 MeV 3.0 0.02\n";
+    }
+    auto table = StoppingTable::Load(file, 2);
+    REQUIRE(table != nullptr);
+    REQUIRE(table->GetEmin() == Approx(0.5));
+    REQUIRE(table->Evaluate(1.0) == Approx(4.05));
+    REQUIRE(StoppingTable::Load(file, 2) == table);
+    {
+        std::ofstream out(file);
+        out << "1.0 4.0\n";
+        out << "0.5 5.0\n";
+    }
+    StoppingTable::ClearCache();
+    REQUIRE(StoppingTable::Load(file, 1) == nullptr);
+
+    // SRIM output, with the table of units at the end.
+    {
+        std::ofstream out(file);
+        out << " ==================================================================\n";
+        out << "              Calculation using SRIM-2006 \n";
+        out << "              SRIM version ---> SRIM-2013.00\n";
+        out << " ==================================================================\n";
+        out << " Ion = Hydrogen [1] , Mass = 1.008 amu\n";
+        out << " Density =  2.3212E+00 g/cm3 = 4.9766E+22 atoms/cm3\n";
+        out << " ======= Target  Composition ========\n";
+        out << "    Atom   Atom   Atomic    Mass     \n";
+        out << "    Name   Numb   Percent   Percent  \n";
+        out << "    ----   ----   -------   -------  \n";
+        out << "     Si     14    100.00    100.00   \n";
+        out << " ====================================\n";
+        out << " Bragg Correction = 0.00%\n";
+        out << " Stopping Units =  MeV / (mg/cm2) \n";
+        out << " See bottom of Table for other Stopping units \n";
+        out << "\n";
+        out << "   Ion        dE/dx      dE/dx     Projected  Longitudinal   Lateral\n";
+        out << "  Energy      Elec.      Nuclear     Range     Straggling   Straggling\n";
+        out << "-----------  ---------- ---------- ----------  ----------  ----------\n";
+        out << "500.00 keV   4.102E-01  4.067E-04    5.93 um     2.87 um     3.69 um   \n";
+        out << "  1.00 MeV   2.683E-01  2.189E-04   16.24 um     5.17 um     6.75 um   \n";
+        out << "  2.00 MeV   1.628E-01  1.174E-04   47.36 um     5.39 um     8.74 um   \n";
+        out << "  4.00 MeV   9.705E-02  6.263E-05  155.12 um    11.44 um    17.60 um   \n";
+        out << "-----------------------------------------------------------\n";
+        out << " Multiply Stopping by        for Stopping Units\n";
+        out << " -------------------        ------------------\n";
+        out << "  2.3212E+01                 eV / Angstrom \n";
+        out << "  2.3212E+02                keV / micron   \n";
+        out << "  2.3212E+02                MeV / mm       \n";
+        out << "  1.0000E+00                keV / (ug/cm2) \n";
+        out << "  1.0000E+00                MeV / (mg/cm2) \n";
+        out << "  1.0000E+03                keV / (mg/cm2) \n";
+        out << "  4.6643E+01                 eV / (1E15 atoms/cm2)\n";
+        out << "  2.1283E+00                L.S.S. reduced units\n";
+        out << " ==================================================================\n";
+        out << " (C) 1984,1989,1992,1998,2008 by J.P. Biersack and J.F. Ziegler\n";
+    }
+    StoppingTable::ClearCache();
+    auto srim = StoppingTable::Load(file, 2);
+    REQUIRE(srim != nullptr);
+    REQUIRE(srim->GetEnergy().size() == 4);
+    REQUIRE(srim->GetEmin() == Approx(0.5));
+    REQUIRE(srim->GetEmax() == Approx(4.0));
+    REQUIRE(srim->Evaluate(2.0) == Approx(1.628e-1 + 1.174e-4));
+    std::remove(file);
+}
+
+TEST_CASE( "Dual", "[Dual]" ) {
+    Dual x = Dual::Variable(2.0, 0);
+    Dual y = Dual::Variable(0.5, 1);
+    Dual f = x*sqrt(x) + log(x)*sin(y) - pow(x, 2.5)/y;
+    REQUIRE(f.value() == Approx(2*std::sqrt(2.) + std::log(2.)*std::sin(0.5) - std::pow(2., 2.5)/0.5));
+    REQUIRE(f.deriv(0) == Approx(1.5*std::sqrt(2.) + std::sin(0.5)/2. - 2.5*std::pow(2., 1.5)/0.5));
+    REQUIRE(f.deriv(1) == Approx(std::log(2.)*std::cos(0.5) + std::pow(2., 2.5)/0.25));
+    REQUIRE(f.deriv(2) == 0);
+}
+
+TEST_CASE( "Loss derivatives", "[Dual]" ) {
+    // d(Loss)/dE and d(Loss)/dwidth against central differences.
+    Material si(14, 28, 300., Material::um);
+    Material u(92, 238, 0.05, Material::gcm2);
+    Particle p(1, 1), a(2, 4);
+    Ziegler1985 zp(&si, &p);
+    ZieglerBethe za(&si, &a);
+    BetheBlock bb(&u, &p);
+    struct { const StoppingPower *stop; double E, w; } cases[] = {
+        {&zp, 8., 300.}, {&za, 450., 300.}, {&bb, 20., 0.05}
+    };
+    for (const auto &c : cases){
+        Dual L = c.stop->Loss(Dual::Variable(c.E, 0), Dual::Variable(c.w, 1), 1001);
+        double hE = 1e-4*c.E, hw = 1e-4*c.w;
+        double dLdE = (c.stop->Loss(c.E + hE, c.w, 1001) - c.stop->Loss(c.E - hE, c.w, 1001))/(2*hE);
+        double dLdw = (c.stop->Loss(c.E, c.w + hw, 1001) - c.stop->Loss(c.E, c.w - hw, 1001))/(2*hw);
+        REQUIRE(L.value() == Approx(c.stop->Loss(c.E, c.w, 1001)));
+        REQUIRE(L.deriv(0) == Approx(dLdE).epsilon(1e-5));
+        REQUIRE(L.deriv(1) == Approx(dLdw).epsilon(1e-5));
+    }
+}
+
+TEST_CASE( "PunchThrough", "[PunchThrough]" ) {
+    // S(E) = 1/E gives the range R(E) = E^2/2.
+    RangeTable table([](const double &E){ return 1/E; }, 1e-4, 100);
+    REQUIRE(table.Range(4.0) == Approx(8.0).epsilon(1e-6));
+    REQUIRE(table.Gain(table.Loss(10.0, 3.0), 3.0) == Approx(10.0).epsilon(1e-6));
+
+    PunchThrough punch(&table, 1.0, &table, 8.0);
+    REQUIRE(punch.StopDE() == Approx(std::sqrt(2.)).epsilon(1e-6));
+    REQUIRE(punch.Punch() == Approx(std::sqrt(18.)).epsilon(1e-6));
+    REQUIRE(punch.Lower(0.5) == Approx(std::sqrt(2.25)).epsilon(1e-6));
+    REQUIRE(punch.Upper(0.5) == Approx(std::sqrt(16.25*16.25 + 2)).epsilon(1e-6));
+}
+
+TEST_CASE( "Prepared kinematics", "[Scattering]" ) {
+    // 28Si(p,d)27Si
+    Particle p(1, 1), si28(14, 28), d(1, 2), si27(14, 27);
+    RelScatter rel(&p, &si28, &d, &si27);
+    DickNorbury dn(&p, &si28, &d, &si27);
+    const double theta = 0.9;
+    double Exmax = rel.FindMaxEx(16.0, theta);
+    std::vector<double> Ex = {0.0, 0.3*Exmax, 0.6*Exmax, 0.9*Exmax};
+    std::vector<double> EY(Ex.size());
+
+    RelScatter::Prepared kin = rel.Prepare(16.0, theta);
+    rel.EvaluateY(16.0, theta, Ex.data(), EY.data(), int(Ex.size()));
+    for (size_t i = 0 ; i < Ex.size() ; ++i){
+        REQUIRE(kin(Ex[i]) == Approx(rel.EvaluateY(16.0, theta, Ex[i])).epsilon(1e-12));
+        REQUIRE(EY[i] == kin(Ex[i]));
+    }
+
+    DickNorbury::Prepared kin2 = dn.Prepare(16.0, theta);
+    for (size_t i = 0 ; i < Ex.size() ; ++i)
+        REQUIRE(kin2(Ex[i]) == Approx(dn.EvaluateY(16.0, theta, Ex[i])).epsilon(1e-12));
+    REQUIRE(kin2(100.0) == 0);
+}
+
+TEST_CASE( "Stopping power copies", "[StoppingPower]" ) {
+    // The stopping power keeps its own copy of the material and particle.
+    Ziegler1985 *si;
+    {
+        Material layer(14, 28, 130., Material::um);
+        Particle d(1, 2);
+        si = new Ziegler1985(&layer, &d);
+    }
+    Ziegler1985 copy;
+    copy = *si;
+    double E = si->Loss(10.0);
+    delete si;
+    REQUIRE(copy.GetMaterial().GetWidth(Material::um) == Approx(130.));
+    REQUIRE(copy.Loss(10.0) == E);
+
+    // Const use from several threads at once.
+    std::vector<double> res(4, 0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0 ; i < res.size() ; ++i)
+        threads.push_back(std::thread([&copy, &res, i](){ res[i] = copy.Loss(10.0); }));
+    for (auto &thread : threads)
+        thread.join();
+    for (double r : res)
+        REQUIRE(r == E);
+}
+
+TEST_CASE( "Stopping power gain", "[StoppingPower]" ) {
+    Material si(14, 28, 130., Material::um);
+    Material u(92, 238, 0.05, Material::gcm2);
+    Particle p(1, 1), a(2, 4);
+    Ziegler1985 zp(&si, &p);
+    ZieglerBethe za(&si, &a);
+    BetheBlock bb(&u, &p);
+
+    // The batched loss is the exact inverse of the gain, and close to the integrated loss.
+    std::vector<double> E = {1.5, 3., 8., 20., 45., std::nan("")};
+    std::vector<double> G(E.size()), L(E.size());
+    for (const StoppingPower *stop : {(const StoppingPower *)&zp, (const StoppingPower *)&za, (const StoppingPower *)&bb}){
+        double w = stop->GetMaterial().GetWidth(stop->GetUnit());
+        stop->Gain(E.data(), w, G.data(), E.size());
+        stop->Loss(G.data(), w, L.data(), E.size());
+        for (size_t i = 0 ; i < E.size() - 1 ; ++i){
+            REQUIRE(stop->Gain(E[i]) == G[i]);
+            REQUIRE(std::abs(L[i] - E[i]) < 1e-12*E[i]);
+            REQUIRE(std::abs(stop->Loss(G[i], w, 10001) - E[i]) < 1e-3*E[i]);
+        }
+        REQUIRE(std::isnan(G.back()));
+        REQUIRE(std::isnan(L.back()));
+    }
+
+    // Copies share the table.
+    Ziegler1985 copy = zp;
+    REQUIRE(copy.GetTable() == zp.GetTable());
+
+    // The tables cover the range of each model, so the gain of a fast
+    // alpha is not extrapolated from the end of the Ziegler fits.
+    REQUIRE(zp.GetTable()->GetEmax() == Approx(ZieglerBethe::STITCH*p.GetM_AMU()));
+    REQUIRE(za.GetTable()->GetEmax() == Approx(StoppingModel::BETHE_EMAX*a.GetA()));
+    REQUIRE(bb.GetTable()->GetEmax() == Approx(StoppingModel::BETHE_EMAX*p.GetA()));
+    double w = za.GetMaterial().GetWidth(za.GetUnit());
+    for (double e : {500., 1000., 3000.}){
+        INFO("E " << e);
+        double g = za.Gain(e);
+        REQUIRE(g > e);
+        REQUIRE(std::abs(za.Loss(g, w, 10001) - e) < 1e-6*e);
+    }
+}
+
+TEST_CASE( "Decimate", "[Decimate]" ) {
+    // A noisy curve with a single spike, much denser than the columns.
+    const size_t n = 100000;
+    std::vector<double> x(n), y(n);
+    for (size_t i = 0 ; i < n ; ++i){
+        x[i] = 10.*i/(n - 1);
+        y[i] = sin(x[i]) + 0.01*((i*7919) % 13);
+    }
+    y[n/3] = 5;
+
+    std::vector<size_t> keep;
+    size_t m = Decimate(x.data(), y.data(), n, 2., 8., 500, keep);
+    REQUIRE(m == keep.size());
+    REQUIRE(m <= 4*500 + 2);
+    for (size_t i = 1 ; i < m ; ++i)
+        REQUIRE(keep[i] > keep[i-1]);
+    REQUIRE(std::find(keep.begin(), keep.end(), n/3) != keep.end());
+
+    // The extremes of each column are kept.
+    for (int c = 0 ; c < 500 ; ++c){
+        double lo = 1e9, hi = -1e9, klo = 1e9, khi = -1e9;
+        for (size_t i = 0 ; i < n ; ++i){
+            if (x[i] < 2. || x[i] > 8. || std::min(int((x[i] - 2.)*500/6.), 499) != c)
+                continue;
+            lo = std::min(lo, y[i]);
+            hi = std::max(hi, y[i]);
+        }
+        for (size_t k : keep){
+            if (x[k] < 2. || x[k] > 8. || std::min(int((x[k] - 2.)*500/6.), 499) != c)
+                continue;
+            klo = std::min(klo, y[k]);
+            khi = std::max(khi, y[k]);
+        }
+        REQUIRE(klo == lo);
+        REQUIRE(khi == hi);
+    }
+
+    // The points just outside the window are kept for the lines leaving it.
+    REQUIRE(x[keep.front()] < 2.);
+    REQUIRE(x[keep.back()] > 8.);
+}
+
+TEST_CASE( "Stopping model", "[StoppingModel]" ) {
+    Material si(14, 28, 1000., Material::um);
+    Material bk(97, 247, 1., Material::um);
+    Particle p(1, 1);
+    REQUIRE(StoppingModel::Choose(&p, &si, 50.) == StoppingModel::Ziegler);
+    REQUIRE(StoppingModel::Choose(&p, &si, 250.) == StoppingModel::Stitched);
+    REQUIRE(StoppingModel::Choose(&p, &bk, 50.) == StoppingModel::Bethe);
+
+    // Ziegler below the stitch, continuous at it, and still stopping above
+    // where the Ziegler fits give nothing.
+    Ziegler1985 ziegler(&si, &p);
+    ZieglerBethe stitched(&si, &p);
+    double Es = 1e3*stitched.GetEstitch();
+    REQUIRE(stitched.Evaluate(0.5*Es) == ziegler.Evaluate(0.5*Es));
+    REQUIRE(stitched.Evaluate(Es*(1 + 1e-9)) == Approx(ziegler.Evaluate(Es*(1 - 1e-9))).epsilon(1e-6));
+    REQUIRE(ziegler.Evaluate(2*Es) == 0);
+    REQUIRE(stitched.Evaluate(2*Es) < 0);
+    REQUIRE(stitched.Evaluate(2*Es) > stitched.Evaluate(Es));
+    REQUIRE(stitched.Loss(250., 1000.) < 250.);
+    REQUIRE(stitched.Loss(50., 1000.) == ziegler.Loss(50., 1000., 1001));
+}
+
+TEST_CASE( "Fast stopping powers", "[FastMath]" ) {
+    for (double x = 1e-300 ; x < 1e300 ; x *= 1.37){
+        REQUIRE(fabs(FastMath::Log(x) - log(x)) < 5e-8);
+        REQUIRE(FastMath::Pow(x, 0.3) == Approx(pow(x, 0.3)).epsilon(1e-6));
+    }
+    for (double x = -700 ; x < 700 ; x += 0.37)
+        REQUIRE(FastMath::Exp(x) == Approx(exp(x)).epsilon(2e-7));
+    REQUIRE(FastMath::Exp(-1000) == 0);
+    REQUIRE(std::isnan(FastMath::Log(-1)));
+
+    // The curves of protons, alphas and silicon ions in silicon and gold
+    // agree with the exact ones, as do the energies after a layer.
+    Material si(14, 28, 300., Material::um), au(79, 197, 20., Material::um);
+    Particle p(1, 1), a(2, 4), ion(14, 28);
+    for (const Material *m : {&si, &au}){
+        for (const Particle *part : {&p, &a, &ion}){
+            Ziegler1985 exact(m, part), fast(m, part, true);
+            REQUIRE(fast.IsFast());
+            for (double E = 1e-2 ; E < 100 ; E *= 1.1){
+                double e = 1e3*E*part->GetA();
+                REQUIRE(fast.Evaluate(e) == Approx(exact.Evaluate(e)).epsilon(1e-5));
+            }
+            double E = 20.*part->GetA();
+            REQUIRE(fast.Loss(E, 1000) == Approx(exact.Loss(E, 1000)).epsilon(1e-5));
+        }
+    }
+
+    StoppingModel::SetPrecision(StoppingModel::Fast);
+    Material::Unit unit;
+    std::unique_ptr<StoppingPower> made(StoppingModel::Make(&si, &p, 20., unit));
+    StoppingModel::SetPrecision(StoppingModel::Exact);
+    REQUIRE(dynamic_cast<Ziegler1985 *>(made.get())->IsFast());
+    REQUIRE(made->Loss(15.) == Approx(Ziegler1985(&si, &p).Loss(15.)).epsilon(1e-5));
+}
+
+TEST_CASE( "Range cache", "[RangeCache]" ) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "qkinz_range_cache_test";
+    std::filesystem::remove_all(dir);
+    RangeCache::SetDirectory(dir.string());
+
+    Material si(14, 28, 1000., Material::um);
+    Particle p(1, 1);
+    double w;
+    auto made = StoppingModel::MakeTable(&p, &si, 20., w);
+    REQUIRE(StoppingModel::MakeTable(&p, &si, 20., w) == made);
+    REQUIRE(std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()) == 1);
+
+    // Read back from disk, the same table.
+    RangeCache::ClearCache();
+    auto read = StoppingModel::MakeTable(&p, &si, 20., w);
+    REQUIRE(read != made);
+    REQUIRE(read->GetEmax() == made->GetEmax());
+    REQUIRE(read->Loss(15., w) == made->Loss(15., w));
+    REQUIRE(read->Gain(3., w) == made->Gain(3., w));
+
+    // Another energy in the same model is the same table, another particle
+    // or model is another table.
+    REQUIRE(StoppingModel::MakeTable(&p, &si, 30., w) == read);
+    REQUIRE(read->GetEmax() == Approx(ZieglerBethe::STITCH*p.GetM_AMU()));
+    Particle d(1, 2);
+    StoppingModel::MakeTable(&d, &si, 20., w);
+    auto stitched = StoppingModel::MakeTable(&p, &si, 80., w);
+    REQUIRE(stitched->GetEmax() == Approx(StoppingModel::BETHE_EMAX));
+    REQUIRE(StoppingModel::MakeTable(&p, &si, 300., w) == stitched);
+    REQUIRE(StoppingModel::MakeTable(&p, &si, 600., w)->GetEmax() == Approx(2*StoppingModel::BETHE_EMAX));
+
+    // The range tables of the stopping powers are the same tables.
+    REQUIRE(Ziegler1985(&si, &p).GetTable() == read);
+    REQUIRE(ZieglerBethe(&si, &p).GetTable() == stitched);
+    REQUIRE(std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()) == 4);
+
+    // Broken files are made again.
+    for (auto &entry : std::filesystem::directory_iterator(dir))
+        std::filesystem::resize_file(entry.path(), 100);
+    RangeCache::ClearCache();
+    REQUIRE(StoppingModel::MakeTable(&p, &si, 20., w)->Loss(15., w) == made->Loss(15., w));
+
+    // Pruning removes the tables used longest ago, and reading a table is a use.
+    uintmax_t size = 0;
+    for (auto &entry : std::filesystem::directory_iterator(dir)){
+        size = std::max(size, entry.file_size());
+        std::filesystem::last_write_time(entry.path(), std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+    }
+    RangeCache::ClearCache();
+    StoppingModel::MakeTable(&p, &si, 20., w);
+    RangeCache::Prune(size);
+    REQUIRE(std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()) == 1);
+    RangeCache::ClearCache();
+    REQUIRE(StoppingModel::MakeTable(&p, &si, 20., w)->Loss(15., w) == made->Loss(15., w));
+    REQUIRE(std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()) == 1);
+
+    RangeCache::SetDirectory("");
+    RangeCache::ClearCache();
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE( "Exit channels", "[ExitChannels]" ) {
+    auto find = [](const std::vector<Channel_t> &channels, const int &A, const int &Z){
+        return std::find_if(channels.begin(), channels.end(), [&](const Channel_t &c){ return c.A == A && c.Z == Z; });
+    };
+    std::vector<Channel_t> channels = ExitChannels(1, 1, 28, 14, 16.);
+    REQUIRE(find(channels, 1, 1) != channels.end());
+    REQUIRE(find(channels, 1, 1)->Q == 0);
+    REQUIRE(find(channels, 28, 14) != channels.end());
+    REQUIRE(find(channels, 4, 2) != channels.end());
+    REQUIRE(find(channels, 4, 2)->resA == 25);
+    REQUIRE(find(channels, 4, 2)->resZ == 13);
+    REQUIRE(find(channels, 4, 2)->Q == Approx(-7.713).epsilon(1e-3));
+    for (const Channel_t &c : channels){
+        REQUIRE(c.Z >= 1);
+        REQUIRE(c.A + c.resA == 29);
+        REQUIRE(c.Z + c.resZ == 15);
+        REQUIRE(16.*28./29. + c.Q > 0);
+    }
+    channels = ExitChannels(1, 1, 28, 14, 5.);
+    REQUIRE(find(channels, 4, 2) == channels.end());
+    REQUIRE(ExitChannels(1, 1, 300, 14, 16.).empty());
+}
+
+TEST_CASE( "Kinematics map", "[KinematicsMap]" ) {
+    // 28Si(p,p')28Si
+    Particle p(1, 1), si28(14, 28), d(1, 2);
+    RelScatter rel(&p, &si28, &p, &si28);
+    KinematicsMap map;
+    REQUIRE(!map.Make(&p, &si28, &d, &si28, 16., 0.5, 1.5, 201, 8., 401));
+    REQUIRE(map.Make(&p, &si28, &p, &si28, 16., 0.5, 1.5, 201, 8., 401));
+
+    // On the grid and between the points.
+    double EY, EB, thetaB, Ex, thetaB2;
+    for (const double &theta : {0.5, 0.77, 1.234, 1.5}){
+        for (const double &ex : {0., 1.1, 3.33, 6.}){
+            REQUIRE(map.Evaluate(theta, ex, EY, EB, thetaB));
+            REQUIRE(EY == Approx(rel.EvaluateY(16., theta, ex)).epsilon(1e-5));
+            REQUIRE(EB == Approx(rel.EvaluateB(16., rel.EvaluateY(16., theta, ex), theta, Ex, thetaB2)).epsilon(1e-3));
+            REQUIRE(thetaB == Approx(thetaB2).epsilon(1e-4));
+        }
+    }
+    REQUIRE(!map.Evaluate(0.4, 1., EY, EB, thetaB));
+    REQUIRE(!map.Evaluate(1., 9., EY, EB, thetaB));
+
+    // Beyond the kinematic limit.
+    KinematicsMap full;
+    REQUIRE(full.Make(&p, &si28, &p, &si28, 16., 0.5, 1.5, 101, 20., 201));
+    REQUIRE(full.Evaluate(1., rel.FindMaxEx(16., 1.) - 0.2, EY, EB, thetaB));
+    REQUIRE(!full.Evaluate(1., rel.FindMaxEx(16., 1.) + 0.2, EY, EB, thetaB));
+
+    // Read back from file.
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "qkinz_kinematics_map_test.kmap";
+    REQUIRE(map.Write(file.string()));
+    KinematicsMap read;
+    REQUIRE(read.Read(file.string()));
+    REQUIRE(read.GetNTheta() == 201);
+    REQUIRE(read.GetNEx() == 401);
+    REQUIRE(read.GetParticles()[6] == 28);
+    double EY2, EB2;
+    REQUIRE(read.Evaluate(1.234, 3.33, EY2, EB2, thetaB2));
+    REQUIRE(map.Evaluate(1.234, 3.33, EY, EB, thetaB));
+    REQUIRE(EY2 == EY);
+    REQUIRE(EB2 == EB);
+    std::filesystem::resize_file(file, 100);
+    REQUIRE(!read.Read(file.string()));
+    std::filesystem::remove(file);
 }
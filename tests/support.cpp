@@ -0,0 +1,430 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <worker.h>
+#include <types.h>
+#include <Dual.h>
+#include <PeakFitter.h>
+#include <PIDGates.h>
+#include <Reconstructor.h>
+#include <StoppingModel.h>
+#include <Particle.h>
+#include <RelScatter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+const double PI = acos(-1);
+
+//! Proton on silicon, seen by SiRi with the absorber foil.
+struct SiRi {
+    Beam_t beam = {1, 1, 16.};
+    Target_t target = {28, 14, 4., mgcm2};
+    Extra_t front = {27, 13, 0.5, mgcm2, false};
+    Extra_t back = {27, 13, 0.5, mgcm2, false};
+    Telescope_t telescope = {{14, 130., um}, {14, 1550., um}, {13, 10.5, um}, true};
+    Worker worker{&beam, &target, &front, &back, &telescope};
+};
+
+} // namespace
+
+TEST_CASE( "Response derivatives", "[Worker]" ) {
+    // Every partial derivative against a central difference of the setup.
+    SiRi siri;
+    const double angle = 44*PI/180., Ex = 2.0;
+    Dual dE, E;
+    REQUIRE(siri.worker.Response(angle, 1, 1, Ex, dE, E));
+
+    struct { Param_t param; double *value; double h; } params[] = {
+        {BeamEnergy, &siri.beam.E, 1e-3},
+        {TargetWidth, &siri.target.width, 1e-3},
+        {AbsorberWidth, &siri.telescope.Absorber.width, 1e-2},
+        {dEWidth, &siri.telescope.dEdetector.width, 1e-2},
+        {EWidth, &siri.telescope.Edetector.width, 1e-1},
+        {ScatAngle, nullptr, 1e-5}
+    };
+    for (const auto &p : params){
+        // The angle is an argument, the other parameters are in the setup.
+        double angle1 = angle, angle2 = angle;
+        Dual dE1, E1, dE2, E2;
+        if (p.value)
+            *p.value += p.h;
+        else
+            angle1 += p.h;
+        REQUIRE(siri.worker.Response(angle1, 1, 1, Ex, dE1, E1));
+        if (p.value)
+            *p.value -= 2*p.h;
+        else
+            angle2 -= p.h;
+        REQUIRE(siri.worker.Response(angle2, 1, 1, Ex, dE2, E2));
+        if (p.value)
+            *p.value += p.h;
+
+        INFO("parameter " << p.param);
+        double ddE = (dE1.value() - dE2.value())/(2*p.h), dEE = (E1.value() - E2.value())/(2*p.h);
+        REQUIRE(fabs(dE.deriv(p.param) - ddE) <= 1e-4*fabs(ddE) + 1e-7);
+        REQUIRE(fabs(E.deriv(p.param) - dEE) <= 1e-4*fabs(dEE) + 1e-7);
+    }
+}
+
+TEST_CASE( "Peak fit", "[PeakFitter]" ) {
+    // Centroids of known states in 28Si made with the true setup, scattered
+    // by their uncertainties, and fitted from a wrong beam energy and dE width.
+    SiRi siri;
+    const double Ex[] = {0., 1.779, 4.618, 6.879};
+    const double sigma_dE = 0.01, sigma_E = 0.02;
+    std::mt19937 rng(1234);
+    std::normal_distribution<double> gauss(0, 1);
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "qkinz_peaks_test.txt";
+    {
+        std::ofstream out(file);
+        out << "# strip Ex dE E sigma_dE sigma_E\n";
+        for (int strip = 0 ; strip < 8 ; ++strip){
+            for (double ex : Ex){
+                Dual dE, E;
+                REQUIRE(siri.worker.Response((40 + 2*strip)*PI/180., 1, 1, ex, dE, E));
+                out << strip << " " << ex << " " << dE.value() + sigma_dE*gauss(rng) << " ";
+                out << E.value() + sigma_E*gauss(rng) << " " << sigma_dE << " " << sigma_E << "\n";
+            }
+        }
+    }
+
+    PeakFitter fitter(&siri.worker, 1, 1, false);
+    fitter.addParameter(BeamEnergy, &siri.beam.E);
+    fitter.addParameter(dEWidth, &siri.telescope.dEdetector.width);
+    REQUIRE(fitter.readPeaks(file.string()));
+    REQUIRE(fitter.GetNdf() == 2*8*4 - 2);
+    siri.beam.E = 15.7;
+    siri.telescope.dEdetector.width = 125.;
+    REQUIRE(fitter.Fit());
+
+    // Within four standard deviations, and chi^2 as expected for the scatter.
+    REQUIRE(fitter.GetError(0) > 0);
+    REQUIRE(fitter.GetError(1) > 0);
+    REQUIRE(fabs(fitter.GetValue(0) - 16.) < 4*fitter.GetError(0));
+    REQUIRE(fabs(fitter.GetValue(1) - 130.) < 4*fitter.GetError(1));
+    REQUIRE(fitter.GetChi2()/fitter.GetNdf() > 0.5);
+    REQUIRE(fitter.GetChi2()/fitter.GetNdf() < 1.6);
+
+    // Lines without the uncertainties, and lines that can not be read.
+    {
+        std::ofstream out(file);
+        out << "3 1.779 2.5 11.0\n";
+    }
+    PeakFitter plain(&siri.worker, 1, 1, false);
+    REQUIRE(plain.readPeaks(file.string()));
+    {
+        std::ofstream out(file);
+        out << "3 1.779 2.5\n";
+    }
+    PeakFitter broken(&siri.worker, 1, 1, false);
+    REQUIRE(!broken.readPeaks(file.string()));
+    std::filesystem::remove(file);
+}
+
+TEST_CASE( "Sort round trip", "[Reconstructor]" ) {
+    // Events at known states in 28Si, seen as the Worker calculates them,
+    // are sorted back to the same excitation energies.
+    SiRi siri;
+    const double Ex[] = {0., 1.779, 4.618, 6.879};
+    std::vector<Event_t> events;
+    for (int16_t strip = 0 ; strip < 8 ; ++strip){
+        for (double ex : Ex){
+            Dual dE, E;
+            REQUIRE(siri.worker.Response((40 + 2*strip)*PI/180., 1, 1, ex, dE, E));
+            events.push_back({0, strip, float(dE.value()), float(E.value())});
+        }
+    }
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "qkinz_events_test.bin";
+    std::filesystem::path exfile = std::filesystem::temp_directory_path() / "qkinz_ex_test.bin";
+    {
+        std::ofstream out(file, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(events.data()), events.size()*sizeof(Event_t));
+    }
+
+    Reconstructor sorter(&siri.beam, &siri.target, &siri.front, &siri.back, &siri.telescope, 1, 1, false);
+    REQUIRE(sorter.Sort(file.string(), exfile.string()));
+    REQUIRE(sorter.GetEvents() == events.size());
+
+    std::vector<float> ex(events.size());
+    {
+        std::ifstream in(exfile, std::ios::binary);
+        in.read(reinterpret_cast<char *>(ex.data()), ex.size()*sizeof(float));
+        REQUIRE(in);
+    }
+    for (size_t i = 0 ; i < events.size() ; ++i){
+        INFO("strip " << events[i].strip << ", Ex " << Ex[i % 4]);
+        REQUIRE(fabs(ex[i] - Ex[i % 4]) < 0.002);
+        REQUIRE(fabs(sorter.Ex(events[i]) - ex[i]) < 1e-4);
+    }
+    std::filesystem::remove(file);
+    std::filesystem::remove(exfile);
+}
+
+TEST_CASE( "Band", "[Worker]" ) {
+    // The band over the acceptance of a strip, against the centre of the strip.
+    SiRi siri;
+    const double angle = 44*PI/180.;
+    QVector<double> Ex, dE, E, sigma_dE, sigma_E, sigma_Ex;
+    for (int i = 0 ; i <= 16 ; ++i)
+        Ex.push_back(0.5*i);
+    Ex.push_back(15.);  // The fragment stops in the dE detector.
+
+    Acceptance_t point = {0., 0., 50., 1, 1};
+    REQUIRE(siri.worker.Band(Ex, dE, E, sigma_dE, sigma_E, sigma_Ex, angle, 1, 1, point));
+    REQUIRE(dE.size() == Ex.size());
+    for (int i = 0 ; i <= 16 ; ++i){
+        INFO("Ex " << Ex[i]);
+        Dual rdE, rE;
+        REQUIRE(siri.worker.Response(angle, 1, 1, Ex[i], rdE, rE));
+        REQUIRE(fabs(dE[i] - rdE.value()) < 2e-3*rdE.value());
+        REQUIRE(fabs(E[i] - rE.value()) < 2e-3*rE.value());
+        REQUIRE(sigma_dE[i] == 0);
+        REQUIRE(sigma_E[i] == 0);
+        REQUIRE(sigma_Ex[i] == 0);
+    }
+    REQUIRE(std::isnan(E.back()));
+    REQUIRE(std::isnan(sigma_Ex.back()));
+
+    // A spread that grows with the acceptance, and the same mean.
+    Acceptance_t strip = {2*PI/180., 1.5, 50., 7, 7}, wide = {4*PI/180., 1.5, 50., 9, 5};
+    QVector<double> dE2, E2, sigma_dE2, sigma_E2, sigma_Ex2;
+    REQUIRE(siri.worker.Band(Ex, dE, E, sigma_dE, sigma_E, sigma_Ex, angle, 1, 1, strip));
+    REQUIRE(siri.worker.Band(Ex, dE2, E2, sigma_dE2, sigma_E2, sigma_Ex2, angle, 1, 1, wide));
+    for (int i = 0 ; i <= 16 ; ++i){
+        INFO("Ex " << Ex[i]);
+        REQUIRE(sigma_E[i] > 0);
+        REQUIRE(std::isfinite(sigma_Ex[i]));
+        REQUIRE(sigma_Ex[i] > 0);
+        REQUIRE(sigma_Ex2[i] > sigma_Ex[i]);
+        REQUIRE(fabs(E2[i] - E[i]) < 0.01*E[i]);
+    }
+    REQUIRE(std::isnan(sigma_Ex.back()));
+    REQUIRE(std::isnan(sigma_Ex2.back()));
+}
+
+TEST_CASE( "Contaminants", "[Worker]" ) {
+    // Each contaminant gets its own curve, shifted by the kinematics of
+    // the lighter isotope.
+    SiRi siri;
+    siri.beam.E = 12.;      // The protons stop in the thick detector.
+    QVector<Contaminant_t> contaminants = {{16, 8, 0.1}};
+    siri.worker.setContaminants(contaminants);
+    contaminants.clear();   // The worker has its own copy.
+
+    const double angle = 44*PI/180., incAngle = angle - 47*PI/180.;
+    std::map<int, QVector<double> > Ex, total;
+    QObject::connect(&siri.worker, &Worker::ResultCurve, [&](const QVector<double> &ex, const QVector<double> &e, const QVector<double> &de,
+                                                              const QVector<double> &, const Fragment_t &, const int &component){
+        Ex[component] = ex;
+        for (int i = 0 ; i < ex.size() ; ++i)
+            total[component].push_back(de[i] + e[i]);
+    });
+    siri.worker.Run(angle, incAngle, true, false, false, false, false, -1, -1);
+    REQUIRE(Ex.size() == 2);
+    REQUIRE(!Ex[0].empty());
+    REQUIRE(!Ex[1].empty());
+
+    // The energy lost on the way differs little between the two.
+    Particle p(1, 1), si(14, 28), o(8, 16);
+    RelScatter scatSi(&p, &si, &p, &si), scatO(&p, &o, &p, &o);
+    double expected = scatSi.EvaluateY(siri.beam.E, angle, Ex[0][0]) - scatO.EvaluateY(siri.beam.E, angle, Ex[1][0]);
+    REQUIRE(expected > 0.1);
+    REQUIRE(fabs((total[0][0] - total[1][0]) - expected) < 0.01);
+
+    // Without contaminants only the target.
+    Ex.clear();
+    total.clear();
+    siri.worker.setContaminants(QVector<Contaminant_t>());
+    siri.worker.Run(angle, incAngle, true, false, false, false, false, -1, -1);
+    REQUIRE(Ex.size() == 1);
+    REQUIRE(Ex.count(0) == 1);
+}
+
+TEST_CASE( "Own setup", "[Worker]" ) {
+    // A worker with a copy of the settings gives what the owner's would,
+    // and does not see later changes of the owner.
+    SiRi siri;
+    Setup_t setup = {siri.beam, siri.target, siri.front, siri.back, siri.telescope, {}};
+    Worker own;
+    own.setSetup(setup);
+    siri.beam.E = 15.;
+
+    const double angle = 44*PI/180.;
+    Dual dE, E, ownDE, ownE;
+    REQUIRE(own.Response(angle, 1, 1, 2.0, ownDE, ownE));
+    siri.beam.E = 16.;
+    REQUIRE(siri.worker.Response(angle, 1, 1, 2.0, dE, E));
+    REQUIRE(ownDE.value() == dE.value());
+    REQUIRE(ownE.value() == E.value());
+}
+
+TEST_CASE( "PID gates", "[PIDGates]" ) {
+    // Gates of protons and deuterons in two strips, with a beam giving
+    // deuterons that reach the thick detector.
+    SiRi siri;
+    siri.beam.E = 30.;
+    const int bins = 200;
+    const double dEMax = 10., EMax = 20.;
+    const QVector<double> angles = {40*PI/180., 54*PI/180.};
+    PIDGates gates(&siri.worker, dEMax, EMax, bins);
+    REQUIRE(!gates.Build(angles));
+    gates.addFragment(1, 1);
+    gates.addFragment(2, 1);
+    REQUIRE(gates.Build(angles));
+
+    // Points on each band carry its label, far from the bands and outside the plane none.
+    for (int strip = 0 ; strip < 2 ; ++strip){
+        for (double Ex : {0., 2., 5., 8.}){
+            INFO("strip " << strip << ", Ex " << Ex);
+            Dual dE, E;
+            REQUIRE(siri.worker.Response(angles[strip], 1, 1, Ex, dE, E));
+            REQUIRE(gates.Label(strip, dE.value(), E.value()) == 1);
+            REQUIRE(siri.worker.Response(angles[strip], 2, 1, Ex, dE, E));
+            REQUIRE(gates.Label(strip, dE.value(), E.value()) == 2);
+        }
+        REQUIRE(gates.Label(strip, 9.5, 19.5) == 0);
+        REQUIRE(gates.Label(strip, 9.5, 0.5) == 0);
+        REQUIRE(gates.Label(strip, -1., 5.) == 0);
+        REQUIRE(gates.Label(strip, 1., EMax) == 0);
+        REQUIRE(gates.GetCells(strip, 1) > 0);
+        REQUIRE(gates.GetCells(strip, 2) > 0);
+        REQUIRE(gates.GetCells(strip, 0) + gates.GetCells(strip, 1) + gates.GetCells(strip, 2) == size_t(bins)*bins);
+    }
+    REQUIRE(gates.Label(2, 1., 10.) == 0);
+
+    // The file holds the header, the fragments and the labels of each strip, E fastest.
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "qkinz_gates_test.bin";
+    REQUIRE(gates.Write(file.string()));
+    std::ifstream in(file, std::ios::binary);
+    char magic[8];
+    uint32_t header[3];
+    double range[2];
+    int32_t AZ[4];
+    std::vector<uint8_t> labels(2*size_t(bins)*bins);
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(header), sizeof(header));
+    in.read(reinterpret_cast<char *>(range), sizeof(range));
+    in.read(reinterpret_cast<char *>(AZ), sizeof(AZ));
+    in.read(reinterpret_cast<char *>(labels.data()), labels.size());
+    REQUIRE(in);
+    REQUIRE(in.peek() == std::ifstream::traits_type::eof());
+    REQUIRE(std::string(magic, 8) == PIDGates::MAGIC);
+    REQUIRE(header[0] == 2);
+    REQUIRE(header[1] == 2);
+    REQUIRE(header[2] == uint32_t(bins));
+    REQUIRE(range[0] == dEMax);
+    REQUIRE(range[1] == EMax);
+    REQUIRE(AZ[0] == 1);
+    REQUIRE(AZ[1] == 1);
+    REQUIRE(AZ[2] == 2);
+    REQUIRE(AZ[3] == 1);
+    int differ = 0;
+    for (int strip = 0 ; strip < 2 ; ++strip){
+        for (int y = 0 ; y < bins ; ++y){
+            for (int x = 0 ; x < bins ; ++x){
+                double dE = (y + 0.5)*dEMax/bins, E = (x + 0.5)*EMax/bins;
+                differ += (labels[(size_t(strip)*bins + y)*bins + x] != gates.Label(strip, dE, E));
+            }
+        }
+    }
+    REQUIRE(differ == 0);
+    in.close();
+    std::filesystem::remove(file);
+}
+
+TEST_CASE( "Adaptive curve", "[Worker]" ) {
+    // The adaptive points against the evenly spaced ones, for protons that
+    // punch through the thick detector at low excitation energies.
+    SiRi siri;
+    siri.beam.E = 25.;
+    const double angle = 44*PI/180.;
+    QVector<double> Ex, dE, E, coeff;
+    REQUIRE(siri.worker.Curve(Ex, dE, E, coeff, angle, 1, 1));
+    REQUIRE(Ex.size() > 100);
+
+    const double tolerance = 1e-3;
+    QVector<double> aEx, adE, aE, acoeff;
+    siri.worker.setCurvePoints(400, tolerance);
+    REQUIRE(siri.worker.Curve(aEx, adE, aE, acoeff, angle, 1, 1));
+    REQUIRE(aEx.size() < 400);
+    REQUIRE(aEx.size() < Ex.size());
+    for (int i = 1 ; i < aEx.size() ; ++i)
+        REQUIRE(aEx[i] > aEx[i - 1]);
+
+    // Every even point lies close to the adaptive polyline in the dE-E plane,
+    // in the units the tolerance is relative to.
+    double scaleE = 0, scaledE = 0;
+    for (int i = 0 ; i < E.size() ; ++i){
+        scaleE = std::max(scaleE, E[i]);
+        scaledE = std::max(scaledE, dE[i]);
+    }
+    int far = 0;
+    for (int i = 0 ; i < Ex.size() ; ++i){
+        double px = E[i]/scaleE, py = dE[i]/scaledE, dist = HUGE_VAL;
+        for (int j = 0 ; j + 1 < aEx.size() ; ++j){
+            double x0 = aE[j]/scaleE, y0 = adE[j]/scaledE;
+            double dx = aE[j + 1]/scaleE - x0, dy = adE[j + 1]/scaledE - y0;
+            double t = std::clamp(((px - x0)*dx + (py - y0)*dy)/(dx*dx + dy*dy), 0., 1.);
+            dist = std::min(dist, hypot(px - x0 - t*dx, py - y0 - t*dy));
+        }
+        if (dist > 2*tolerance)
+            ++far;
+    }
+    REQUIRE(far == 0);
+
+    // The punch-through, where the energy in the thick detector peaks, is
+    // resolved much finer than by the even points.
+    int peak = int(std::max_element(E.begin(), E.end()) - E.begin());
+    int apeak = int(std::max_element(aE.begin(), aE.end()) - aE.begin());
+    REQUIRE(peak > 0);
+    REQUIRE(peak + 1 < Ex.size());
+    REQUIRE(apeak > 0);
+    REQUIRE(apeak + 1 < aEx.size());
+    REQUIRE(aE[apeak] >= E[peak] - 1e-3);
+    double even = Ex[1] - Ex[0];
+    double gap = HUGE_VAL;
+    for (int i = 1 ; i < aEx.size() ; ++i){
+        if (fabs(aEx[i] - Ex[peak]) < even)
+            gap = std::min(gap, aEx[i] - aEx[i - 1]);
+    }
+    REQUIRE(gap < 1e-3*even);
+
+    // A looser tolerance needs fewer points.
+    QVector<double> lEx, ldE, lE, lcoeff;
+    siri.worker.setCurvePoints(400, 10*tolerance);
+    REQUIRE(siri.worker.Curve(lEx, ldE, lE, lcoeff, angle, 1, 1));
+    REQUIRE(lEx.size() < aEx.size());
+}
+
+TEST_CASE( "Worker precision", "[Worker]" ) {
+    // The precision belongs to the worker, and leaves the rest of the program exact.
+    SiRi exact, fast;
+    fast.worker.setPrecision(StoppingModel::Fast);
+    const double angle = 44*PI/180.;
+    QVector<double> Ex, dE, E, coeff, fEx, fdE, fE, fcoeff;
+    REQUIRE(exact.worker.Curve(Ex, dE, E, coeff, angle, 1, 1));
+    REQUIRE(fast.worker.Curve(fEx, fdE, fE, fcoeff, angle, 1, 1));
+    REQUIRE(StoppingModel::GetPrecision() == StoppingModel::Exact);
+    REQUIRE(fEx.size() == Ex.size());
+    bool differ = false;
+    for (int i = 0 ; i < Ex.size() ; ++i){
+        REQUIRE(fdE[i] == Approx(dE[i]).epsilon(1e-4));
+        REQUIRE(fE[i] == Approx(E[i]).epsilon(1e-4));
+        differ = differ || fdE[i] != dE[i];
+    }
+    REQUIRE(differ);
+
+    // A worker made after the fast one is exact again.
+    SiRi later;
+    QVector<double> lEx, ldE, lE, lcoeff;
+    REQUIRE(later.worker.Curve(lEx, ldE, lE, lcoeff, angle, 1, 1));
+    REQUIRE(ldE == dE);
+}
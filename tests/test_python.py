@@ -0,0 +1,130 @@
+# Tests of the qkinz Python module, run by ctest with the module on the
+# PYTHONPATH. Uses NumPy if installed, else array.array, as the module.
+
+import math
+import unittest
+
+import qkinz
+
+
+def close(a, b, rel):
+    return abs(a - b) <= rel*max(abs(a), abs(b))
+
+
+class TestRangeTable(unittest.TestCase):
+
+    def setUp(self):
+        self.p = qkinz.Particle(1, 1)
+        self.si = qkinz.Material(14, 130.)
+        self.table = qkinz.RangeTable(self.p, self.si, 20.)
+
+    def test_covers(self):
+        self.assertGreaterEqual(self.table.Emax, 40.)
+        self.assertLess(self.table.Emin, 0.1)
+
+    def test_loss_gain(self):
+        E = [4. + 0.5*i for i in range(33)]
+        after = self.table.loss(E)
+        back = self.table.gain(after)
+        for e, a, b in zip(E, after, back):
+            self.assertLess(a, e)
+            self.assertTrue(close(b, e, 1e-9), (e, b))
+        # Stopped in the layer, and the least energy to get through.
+        self.assertEqual(self.table.loss(2.)[0], 0)
+        self.assertTrue(close(self.table.range(self.table.gain(0.)[0])[0], 130., 1e-9))
+
+    def test_range_energy(self):
+        E = [1., 5., 15., 30.]
+        for e, b in zip(E, self.table.energy(self.table.range(E))):
+            self.assertTrue(close(b, e, 1e-9), (e, b))
+
+    def test_integrated(self):
+        # The tabulated loss against the integrated stopping power.
+        E = [5., 10., 20.]
+        for a, b in zip(self.table.loss(E), qkinz.loss(self.p, self.si, E)):
+            self.assertTrue(close(a, b, 1e-4), (a, b))
+
+    def test_units(self):
+        # The same layer in mg/cm2 loses the same energy.
+        mg = qkinz.Material(14, 130.*self.si.density*0.1, 'mgcm2')
+        table = qkinz.RangeTable(self.p, mg, 20.)
+        self.assertTrue(close(table.loss(10.)[0], self.table.loss(10.)[0], 1e-9))
+
+    def test_broadcast(self):
+        # A single energy is used for all widths, and the other way round.
+        widths = [50., 100., 130.]
+        out = self.table.loss(10., widths)
+        self.assertEqual(len(out), 3)
+        self.assertTrue(out[0] > out[1] > out[2])
+        self.assertEqual(out[2], self.table.loss(10.)[0])
+        self.assertEqual(len(self.table.loss([8., 9., 10.], 130.)), 3)
+        with self.assertRaises(ValueError):
+            self.table.loss([8., 9., 10.], [50., 100.])
+
+    def test_threads(self):
+        E = [1. + 0.01*i for i in range(5000)]
+        one = self.table.loss(E, threads=1)
+        many = self.table.loss(E, threads=4)
+        self.assertEqual(list(one), list(many))
+
+
+class TestKinematics(unittest.TestCase):
+
+    def test_elastic(self):
+        p, si = qkinz.Particle(1, 1), qkinz.Particle(14, 28)
+        E = qkinz.kinematics(p, si, p, 16., [0., 0.5, 1.])
+        self.assertTrue(close(E[0], 16., 1e-9))
+        self.assertTrue(E[0] > E[1] > E[2])
+        excited = qkinz.kinematics(p, si, p, 16., 0.5, [0., 1.779])
+        self.assertTrue(close(excited[0] - excited[1], 1.779*0.98, 0.02))
+
+
+class TestTelescope(unittest.TestCase):
+
+    def test_response(self):
+        p = qkinz.Particle(1, 1)
+        tel = qkinz.Telescope(p, 16., qkinz.Material(14, 4., 'mgcm2', 28), p,
+                              dE=qkinz.Material(14, 130.), E=qkinz.Material(14, 1550.),
+                              absorber=qkinz.Material(13, 10.5))
+        theta = 44*math.pi/180.
+        dE, E = tel.response(theta, [0., 2., 4.])
+        self.assertEqual(len(dE), 3)
+        for i in range(3):
+            self.assertGreater(dE[i], 0)
+            self.assertGreater(E[i], 0)
+        self.assertTrue(E[0] > E[1] > E[2])
+        self.assertLess(dE[0] + E[0], qkinz.kinematics(p, qkinz.Particle(14, 28), p, 16., theta)[0])
+        # Not a state of the residual.
+        dE, E = tel.response(theta, 100.)
+        self.assertTrue(math.isnan(dE[0]) and math.isnan(E[0]))
+
+
+class TestErrors(unittest.TestCase):
+
+    def test_material(self):
+        for Z in (0, 93, 120):
+            with self.assertRaises(ValueError):
+                qkinz.Material(Z, 1.)
+        with self.assertRaises(ValueError):
+            qkinz.Material(14, 1., 'inch')
+
+    def test_particle(self):
+        with self.assertRaises(ValueError):
+            qkinz.Particle(1, 40)
+
+    def test_arguments(self):
+        p, si = qkinz.Particle(1, 1), qkinz.Material(14, 130.)
+        with self.assertRaises(TypeError):
+            qkinz.RangeTable(si, p, 20.)
+        with self.assertRaises(ValueError):
+            qkinz.RangeTable(p, si, 0.)
+        with self.assertRaises(ValueError):
+            qkinz.loss(p, si, 10., points=0)
+        with self.assertRaises(TypeError):
+            qkinz.loss(p, si, 'ten')
+        with self.assertRaises(ValueError):
+            qkinz.kinematics(p, p, p, [10., 11.], [0.1, 0.2, 0.3])
+
+
+if __name__ == '__main__':
+    unittest.main()